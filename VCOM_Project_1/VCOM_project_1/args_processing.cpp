@@ -45,6 +45,18 @@ void print_help()
 		-mkh,       --morph-kernel-height       <integer>       2
 		-mni,       --morph-number-iterations   <integer>       2
 		-rms,       --region-minimum-size       <decimal>       60.0
+		-tls,       --tile-size                 <integer>       0
+		-isa,       --instruction-set           <integer>       -1
+		-pft,       --prefilter-threshold       <decimal>       0.0
+		-pfr,       --prefilter-reject-rate     <decimal>       0.0
+		-trk,       --tracking-interval         <integer>       0
+		-adp,       --adaptive-mode             <integer>       0
+		-nsl,       --number-scanlines          <integer>       1
+		-spx,       --subpixel-mode             <integer>       0
+		-gpi,       --graph-api                 <integer>       0
+		-bmk,       --benchmark-runs            <integer>       0
+		-thr,       --threads                   <integer>       0
+		-mpr,       --memory-profiling          <integer>       0
 
 		-d,         --debug                     executes program in debug mode
 		-v,         --version                   displays program info and version
@@ -53,6 +65,49 @@ void print_help()
 		Note: The last 3 options are exclusive, meaning only one should be specified.
 		      If more than one of these is specified, this message will be displayed.
 		      If any other option is specified, it will be ignored.
+
+		Note: A binary threshold value of -1 is computed from each image with Otsu's method (from each tile, if tiled).
+
+		Note: An adaptive mode of 1 computes the binary threshold value and the scanline threshold with Otsu's method,
+		      closes the image once more with a kernel twice as wide before giving up on finding ROIs (if not tiled),
+		      and reports how confidently the barcode was analyzed, from 0.0 to 1.0. An adaptive mode of 0 disables it.
+
+		Note: A number of scanlines above 1 measures the barcode along that many lines across the middle half of its region,
+		      reporting the segments most lines agree on, along with the fraction of lines that found each segment.
+
+		Note: A subpixel mode of 1 measures the barcode at the resolution of its region rather than upscaled to 2560x1440,
+		      locating the edges between segments with sub-pixel precision, along a single scanline.
+		      A subpixel mode of 0 disables it.
+
+		Note: A graph API of 1 finds potential barcodes with a single graph executed by the Fluid backend of OpenCV G-API,
+		      falling back to the usual pipeline if it does not support the specified options. A graph API of 0 disables it.
+
+		Note: A number of benchmark runs above 0 times the usual and the graph pipelines on each image that many times,
+		      and reports their mean times along with how many pixels their results differ by.
+
+		Note: A number of threads of 0 uses as many threads as the hardware supports.
+		      Otherwise, the program and OpenCV share that many threads between them, all going to the program when tiled
+		      or with several scanlines (not sub-pixel), so that its threads run OpenCV serially, and all to OpenCV otherwise.
+
+		Note: A memory profiling of 1 reports, for each step of each image, how many times and how much memory was allocated,
+		      and the peak of memory held, separately for image buffers and for everything else. A memory profiling of 0 disables it.
+
+		Note: A tile size of 0 processes the whole image at once.
+		      Otherwise, the image is processed in overlapping tiles across worker threads.
+
+		Note: The instruction set of custom kernels is detected when -1 is specified.
+		      Otherwise, 0 is scalar, 1 is SSE4.2, 2 is AVX2 and 3 is AVX-512, limited to the detected one.
+
+		Note: A prefilter threshold of 0.0 disables the prefilter.
+		      Otherwise, images whose gradient energy score is below it are skipped, and the score is reported.
+		      Higher values skip more images without barcodes, but also more images with barcodes.
+		      A prefilter reject rate above 0.0 sets the threshold instead, as the score below which that fraction
+		      of the first 32 images found to contain a barcode fall, and reports it. Until then, no image is skipped.
+
+		Note: If <file> is a video, its frames are processed in sequence.
+		      A tracking interval of 0 searches each frame in its whole.
+		      Otherwise, each frame is first searched around the barcode of the previous frame,
+		      and in its whole when that fails or once every that many frames.
 )delim" 
 	<< std::endl;
 }
@@ -15,6 +15,18 @@ struct ProgramOptions
 	static constexpr char const * MKH = "-mkh";
 	static constexpr char const * MNI = "-mni";
 	static constexpr char const * RMS = "-rms";
+	static constexpr char const * TLS = "-tls";
+	static constexpr char const * ISA = "-isa";
+	static constexpr char const * PFT = "-pft";
+	static constexpr char const * PFR = "-pfr";
+	static constexpr char const * TRK = "-trk";
+	static constexpr char const * ADP = "-adp";
+	static constexpr char const * NSL = "-nsl";
+	static constexpr char const * SPX = "-spx";
+	static constexpr char const * GPI = "-gpi";
+	static constexpr char const * BMK = "-bmk";
+	static constexpr char const * THR = "-thr";
+	static constexpr char const * MPR = "-mpr";
 	static constexpr char const * D = "-d";
 	static constexpr char const * V = "-v";
 	static constexpr char const * H = "-h";
@@ -28,6 +40,18 @@ struct ProgramOptions
 	static constexpr char const * MKH_Ex = "--morph-kernel-height";
 	static constexpr char const * MNI_Ex = "--morph-number-iterations";
 	static constexpr char const * RMS_Ex = "--region-minimum-size";
+	static constexpr char const * TLS_Ex = "--tile-size";
+	static constexpr char const * ISA_Ex = "--instruction-set";
+	static constexpr char const * PFT_Ex = "--prefilter-threshold";
+	static constexpr char const * PFR_Ex = "--prefilter-reject-rate";
+	static constexpr char const * TRK_Ex = "--tracking-interval";
+	static constexpr char const * ADP_Ex = "--adaptive-mode";
+	static constexpr char const * NSL_Ex = "--number-scanlines";
+	static constexpr char const * SPX_Ex = "--subpixel-mode";
+	static constexpr char const * GPI_Ex = "--graph-api";
+	static constexpr char const * BMK_Ex = "--benchmark-runs";
+	static constexpr char const * THR_Ex = "--threads";
+	static constexpr char const * MPR_Ex = "--memory-profiling";
 	static constexpr char const * D_Ex = "--debug";
 	static constexpr char const * V_Ex = "--version";
 	static constexpr char const * H_Ex = "--help";
@@ -18,7 +18,7 @@ bool process_option(std::unordered_map<std::string, std::string> const& in_optio
 	}
 
 	auto const& str = it->second;
-	auto result = std::from_chars(&str.front(), &str.back(), out_value);
+	auto result = std::from_chars(str.data(), str.data() + str.size(), out_value);
 
 	return result.ec != std::errc::invalid_argument;
 }
@@ -0,0 +1,1210 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
+
+#include "barcode_detection.hpp"
+#include "fixed_pipeline.hpp"
+#include "simd_kernels.hpp"
+#include "task_scheduler.hpp"
+
+namespace
+{
+	// Labels along the borders of a tile, used to merge components that cross into neighbouring tiles
+	// Background components are labelled as well, since a component only has an external contour if it touches the background
+	// that reaches the image border
+	struct TileComponents
+	{
+		cv::Rect core;
+
+		std::vector<cv::Rect> regions; // Bounding rectangle of each component, excluding the background
+		std::vector<int> top_row;
+		std::vector<int> bottom_row;
+		std::vector<int> left_col;
+		std::vector<int> right_col;
+
+		int background_count; // Excluding the label of the components
+		std::vector<int> background_top_row;
+		std::vector<int> background_bottom_row;
+		std::vector<int> background_left_col;
+		std::vector<int> background_right_col;
+
+		std::vector<std::pair<int, int>> contacts; // Labels of each component and background component that are 4-adjacent in the tile
+	};
+
+	int FindRoot(std::vector<int> & parents, int label)
+	{
+		while (parents[label] != label)
+		{
+			parents[label] = parents[parents[label]];
+			label = parents[label];
+		}
+		return label;
+	}
+
+	void Unite(std::vector<int> & parents, int label1, int label2)
+	{
+		label1 = FindRoot(parents, label1);
+		label2 = FindRoot(parents, label2);
+
+		if (label1 != label2)
+		{
+			parents[std::max(label1, label2)] = std::min(label1, label2);
+		}
+	}
+
+	// Unites labels in two adjacent border strips, under 8-connectivity (reach of 1) or 4-connectivity (reach of 0)
+	void UniteStrips(std::vector<int> & parents, std::vector<int> const & in_strip1, int in_offset1, std::vector<int> const & in_strip2, int in_offset2, int in_reach)
+	{
+		auto const strip_size = int(in_strip1.size());
+
+		for (int idx1 = 0; idx1 < strip_size; ++idx1)
+		{
+			if (in_strip1[idx1] == 0)
+			{
+				continue;
+			}
+
+			for (int idx2 = std::max(idx1 - in_reach, 0); idx2 <= std::min(idx1 + in_reach, strip_size - 1); ++idx2)
+			{
+				if (in_strip2[idx2] != 0)
+				{
+					Unite(parents, in_offset1 + in_strip1[idx1] - 1, in_offset2 + in_strip2[idx2] - 1);
+				}
+			}
+		}
+	}
+
+	// Records the contacts between components of one border strip and background components of the opposite one, by their global labels
+	void AddStripContacts(std::vector<std::pair<int, int>> & io_contacts, std::vector<int> const & in_strip, int in_offset, std::vector<int> const & in_background_strip, int in_background_offset)
+	{
+		for (size_t idx = 0; idx < in_strip.size(); ++idx)
+		{
+			if (in_strip[idx] != 0 && in_background_strip[idx] != 0)
+			{
+				io_contacts.emplace_back(in_offset + in_strip[idx] - 1, in_background_offset + in_background_strip[idx] - 1);
+			}
+		}
+	}
+
+	// Blurs the gradient of a BGR image, as the steps of ComputeBarcodeMask before thresholding do in non-debug mode
+	void ComputeBlurredGradient(cv::Mat const & in_image, cv::Mat & out_gradient, std::vector<double> const & in_params)
+	{
+		cv::Mat gray;
+		cv::Mat x_gradient;
+		cv::Mat y_gradient;
+
+		cv::cvtColor(in_image, gray, cv::COLOR_BGR2GRAY);
+
+		cv::Sobel(gray, x_gradient, cv::FILTER_SCHARR, 2, 0, 3);
+		cv::Sobel(gray, y_gradient, cv::FILTER_SCHARR, 0, 2, 3);
+
+		cv::subtract(x_gradient, y_gradient, gray);
+
+		cv::GaussianBlur(gray, out_gradient, cv::Size(int(in_params[0]), int(in_params[1])), in_params[2], in_params[3]);
+	}
+
+	// Threshold from Otsu's method on a histogram, computed as cv::threshold does on an 8-bit image (the first maximum of the between-class variance)
+	double ComputeOtsuThreshold(std::array<size_t, 256> const & in_histogram)
+	{
+		double const scale = 1.0 / double(std::accumulate(std::begin(in_histogram), std::end(in_histogram), size_t(0)));
+
+		double mu = 0.0;
+
+		for (size_t idx = 0; idx < in_histogram.size(); ++idx)
+		{
+			mu += double(idx) * double(in_histogram[idx]);
+		}
+
+		mu *= scale;
+
+		double mu1 = 0.0;
+		double q1 = 0.0;
+		double max_sigma = 0.0;
+		double max_value = 0.0;
+
+		for (size_t idx = 0; idx < in_histogram.size(); ++idx)
+		{
+			double const p_i = double(in_histogram[idx]) * scale;
+
+			mu1 *= q1;
+			q1 += p_i;
+
+			double const q2 = 1.0 - q1;
+
+			if (std::min(q1, q2) < std::numeric_limits<float>::epsilon() || std::max(q1, q2) > 1.0 - std::numeric_limits<float>::epsilon())
+			{
+				continue;
+			}
+
+			mu1 = (mu1 + double(idx) * p_i) / q1;
+
+			double const mu2 = (mu - q1 * mu1) / q2;
+			double const sigma = q1 * q2 * (mu1 - mu2) * (mu1 - mu2);
+
+			if (sigma > max_sigma)
+			{
+				max_sigma = sigma;
+				max_value = double(idx);
+			}
+		}
+
+		return max_value;
+	}
+}
+
+void ComputeBarcodeMask(ImageSnapshot & io_data, std::vector<double> const & in_params, bool is_debugging)
+{
+	cv::Mat dst_data;
+
+	// Convert to grayscale
+
+	cv::cvtColor(io_data, dst_data, cv::COLOR_BGR2GRAY);
+	io_data = dst_data; // 1
+
+	// Use a pipeline specialised for the kernel sizes and iterations if one matches them (only in non-debug mode, as it takes no snapshots)
+
+	if (cv::Mat mask; !is_debugging && ComputeFixedBarcodeMask(io_data.Image(), mask, in_params))
+	{
+		io_data = mask; // 5
+		return;
+	}
+
+	// Apply Sobel operator: second derivative in x and y with a kernel size of 3
+
+	cv::Mat x_gradient;
+	cv::Mat y_gradient;
+
+	cv::Sobel(io_data, x_gradient, cv::FILTER_SCHARR, 2, 0, 3);
+	cv::Sobel(io_data, y_gradient, cv::FILTER_SCHARR, 0, 2, 3);
+
+	// Subtract
+
+	cv::subtract(x_gradient, y_gradient, dst_data);
+	io_data = dst_data; // 2
+
+	int const gauss_kernel_width = int(is_debugging ? in_params[0] * 2.0 + 1.0 : in_params[0]);
+	int const gauss_kernel_height = int(is_debugging ? in_params[1] * 2.0 + 1.0 : in_params[1]);
+	double const gauss_sigma_x = is_debugging ? in_params[2] * 0.1 : in_params[2];
+	double const gauss_sigma_y = is_debugging ? in_params[3] * 0.1 : in_params[3];
+
+	// Apply Gaussian blur
+
+	cv::GaussianBlur(io_data, dst_data, cv::Size(gauss_kernel_width, gauss_kernel_height), gauss_sigma_x, gauss_sigma_y);
+	io_data = dst_data; // 3
+
+	// Convert to binary image using a simple thresholding function with specified thresholding value, or one from Otsu's method if it is negative
+
+	if (in_params[4] < 0.0)
+	{
+		cv::threshold(io_data, dst_data, 0.0, 255.0, cv::THRESH_BINARY | cv::THRESH_OTSU);
+	}
+	else
+	{
+		cv::threshold(io_data, dst_data, in_params[4], 255.0, cv::THRESH_BINARY);
+	}
+	io_data = dst_data; // 4
+
+	// Apply morphological operator: close operation with specified kernel and iterations
+
+	cv::morphologyEx(io_data, dst_data, cv::MORPH_CLOSE, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(int(in_params[5]), int(in_params[6]))), cv::Point(-1, -1), int(in_params[7]));
+	io_data = dst_data; // 5
+}
+
+std::pmr::vector<ImageROI> FindImageROIs(ImageSnapshot & io_data, std::vector<double> const & in_params, bool is_debugging, std::pmr::memory_resource * in_memory)
+{
+	ComputeBarcodeMask(io_data, in_params, is_debugging);
+
+	return FindMaskROIs(io_data, in_params, is_debugging, in_memory);
+}
+
+std::pmr::vector<ImageROI> FindMaskROIs(ImageSnapshot & io_data, std::vector<double> const & in_params, bool is_debugging, std::pmr::memory_resource * in_memory)
+{
+	// Contours can only be output to vectors with the default allocator, so they are kept across calls to reuse their capacity instead
+
+	thread_local std::vector<std::vector<cv::Point>> contours;
+
+	// Find contours using border following algorithm
+
+	cv::findContours(io_data, contours, cv::noArray(), cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+
+	// Convert back to BGR color space (interesting only for debug mode)
+
+	cv::Mat dst_data;
+
+	if (is_debugging)
+	{
+		cv::cvtColor(io_data, dst_data, cv::COLOR_GRAY2BGR);
+	}
+
+	std::pmr::vector<ImageROI> image_ROIs{ in_memory };
+	image_ROIs.reserve(contours.size());
+
+	size_t unique_id = 0;
+
+	for (auto const & contour : contours)
+	{
+		// Find bounding rectangles for the contours, and save them as ROIs
+
+		if (auto rect = cv::boundingRect(contour); rect.height > in_params[8] && rect.width > rect.height)
+		{
+			// Trace ROIs with rectangles (interesting only for debug mode)
+
+			if (is_debugging)
+			{
+				cv::rectangle(dst_data, rect, cv::Scalar(0.0, 0.0, 255.0), 3);
+			}
+
+			image_ROIs.emplace_back(rect, unique_id++);
+		}
+	}
+
+	if (is_debugging)
+	{
+		io_data = dst_data; // 6
+	}
+
+	return image_ROIs;
+}
+
+std::pmr::vector<ImageROI> FindImageROIsWidened(ImageSnapshot & io_data, std::vector<double> const & in_params, std::pmr::memory_resource * in_memory)
+{
+	cv::Mat dst_data;
+
+	// Apply morphological operator: close operation with a kernel of twice the specified width, once
+
+	cv::morphologyEx(io_data, dst_data, cv::MORPH_CLOSE, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * int(in_params[5]), int(in_params[6]))));
+	io_data = dst_data;
+
+	return FindMaskROIs(io_data, in_params, false, in_memory);
+}
+
+std::pmr::vector<ImageROI> FindImageROIsTiled(cv::Mat const & in_image, std::vector<double> const & in_params, int in_tile_size, std::pmr::memory_resource * in_memory)
+{
+	// Each tile is extended by a halo wide enough for the Sobel, Gaussian and close operations, so that its core is exact
+
+	cv::Size const halo{
+		1 + int(in_params[0]) / 2 + 2 * int(in_params[7]) * int(in_params[5]),
+		1 + int(in_params[1]) / 2 + 2 * int(in_params[7]) * int(in_params[6])
+	};
+
+	int const tile_cols = (in_image.cols + in_tile_size - 1) / in_tile_size;
+	int const tile_rows = (in_image.rows + in_tile_size - 1) / in_tile_size;
+
+	std::vector<TileComponents> tiles(size_t(tile_cols) * size_t(tile_rows));
+
+	auto const tile_core = [&] (size_t tile_idx)
+	{
+		int const core_x = int(tile_idx % tile_cols) * in_tile_size;
+		int const core_y = int(tile_idx / tile_cols) * in_tile_size;
+
+		return cv::Rect(core_x, core_y, std::min(in_tile_size, in_image.cols - core_x), std::min(in_tile_size, in_image.rows - core_y));
+	};
+
+	auto const tile_padded_region = [&] (cv::Rect const & core)
+	{
+		return cv::Rect(core.x - halo.width, core.y - halo.height, core.width + halo.width * 2, core.height + halo.height * 2) & cv::Rect(0, 0, in_image.cols, in_image.rows);
+	};
+
+	// With a negative thresholding value, a single threshold from Otsu's method is fitted to the whole image, as the untiled search does,
+	// from the histograms of the blurred gradient in the cores of the tiles; fitting one to each tile would threshold those holding only background on their noise
+
+	std::vector<double> tile_params = in_params;
+
+	if (in_params[4] < 0.0)
+	{
+		std::vector<std::array<size_t, 256>> histograms(tiles.size());
+
+		GetTaskScheduler()->ParallelFor(tiles.size(), [&] (size_t tile_idx)
+		{
+			auto & histogram = histograms[tile_idx];
+			histogram.fill(0);
+
+			cv::Rect const core = tile_core(tile_idx);
+			cv::Rect const padded_region = tile_padded_region(core);
+
+			cv::Mat gradient;
+
+			ComputeBlurredGradient(in_image(padded_region), gradient, in_params);
+
+			cv::Mat const core_gradient = gradient(core - padded_region.tl());
+
+			for (int row = 0; row < core_gradient.rows; ++row)
+			{
+				auto const row_data = core_gradient.ptr<uchar>(row);
+
+				for (int col = 0; col < core_gradient.cols; ++col)
+				{
+					++histogram[row_data[col]];
+				}
+			}
+		});
+
+		std::array<size_t, 256> histogram{};
+
+		for (auto const & tile_histogram : histograms)
+		{
+			for (size_t idx = 0; idx < histogram.size(); ++idx)
+			{
+				histogram[idx] += tile_histogram[idx];
+			}
+		}
+
+		tile_params[4] = ComputeOtsuThreshold(histogram);
+	}
+
+	// Process tiles as tasks of the scheduler
+
+	GetTaskScheduler()->ParallelFor(tiles.size(), [&] (size_t tile_idx)
+	{
+		auto & tile = tiles[tile_idx];
+
+		tile.core = tile_core(tile_idx);
+
+		cv::Rect const padded_region = tile_padded_region(tile.core);
+
+		// Snapshots are never taken for tiles
+
+		ImageSnapshot tile_data{ in_image(padded_region), std::numeric_limits<size_t>::max() };
+
+		ComputeBarcodeMask(tile_data, tile_params, false);
+
+		// Label connected components in the tile's core, with the same connectivity used by the border following algorithm
+
+		cv::Mat labels;
+		cv::Mat stats;
+		cv::Mat centroids;
+
+		cv::Mat const core_mask = tile_data.Image()(tile.core - padded_region.tl());
+
+		int const label_count = cv::connectedComponentsWithStats(core_mask, labels, stats, centroids, 8, CV_32S);
+
+		tile.regions.reserve(size_t(label_count));
+
+		for (int label = 1; label < label_count; ++label)
+		{
+			tile.regions.emplace_back(
+				tile.core.x + stats.at<int>(label, cv::CC_STAT_LEFT),
+				tile.core.y + stats.at<int>(label, cv::CC_STAT_TOP),
+				stats.at<int>(label, cv::CC_STAT_WIDTH),
+				stats.at<int>(label, cv::CC_STAT_HEIGHT)
+			);
+		}
+
+		tile.top_row.assign(labels.ptr<int>(0), labels.ptr<int>(0) + labels.cols);
+		tile.bottom_row.assign(labels.ptr<int>(labels.rows - 1), labels.ptr<int>(labels.rows - 1) + labels.cols);
+
+		tile.left_col.resize(size_t(labels.rows));
+		tile.right_col.resize(size_t(labels.rows));
+
+		for (int row = 0; row < labels.rows; ++row)
+		{
+			tile.left_col[row] = labels.at<int>(row, 0);
+			tile.right_col[row] = labels.at<int>(row, labels.cols - 1);
+		}
+
+		// Label the background with the complementary connectivity, as the border following algorithm considers it
+
+		cv::Mat background_labels;
+
+		tile.background_count = cv::connectedComponents(core_mask == 0, background_labels, 4, CV_32S) - 1;
+
+		tile.background_top_row.assign(background_labels.ptr<int>(0), background_labels.ptr<int>(0) + background_labels.cols);
+		tile.background_bottom_row.assign(background_labels.ptr<int>(background_labels.rows - 1), background_labels.ptr<int>(background_labels.rows - 1) + background_labels.cols);
+
+		tile.background_left_col.resize(size_t(background_labels.rows));
+		tile.background_right_col.resize(size_t(background_labels.rows));
+
+		for (int row = 0; row < background_labels.rows; ++row)
+		{
+			tile.background_left_col[row] = background_labels.at<int>(row, 0);
+			tile.background_right_col[row] = background_labels.at<int>(row, background_labels.cols - 1);
+		}
+
+		// Record which components touch which background components inside the core, each pair once
+
+		for (int row = 0; row < labels.rows; ++row)
+		{
+			auto const label_row = labels.ptr<int>(row);
+			auto const background_row = background_labels.ptr<int>(row);
+			auto const next_label_row = row + 1 < labels.rows ? labels.ptr<int>(row + 1) : nullptr;
+			auto const next_background_row = row + 1 < labels.rows ? background_labels.ptr<int>(row + 1) : nullptr;
+
+			for (int col = 0; col < labels.cols; ++col)
+			{
+				auto const add_contact = [&tile] (int in_label, int in_background_label)
+				{
+					if (in_label != 0 && in_background_label != 0 && (tile.contacts.empty() || tile.contacts.back() != std::make_pair(in_label, in_background_label)))
+					{
+						tile.contacts.emplace_back(in_label, in_background_label);
+					}
+				};
+
+				if (col + 1 < labels.cols)
+				{
+					add_contact(label_row[col], background_row[col + 1]);
+					add_contact(label_row[col + 1], background_row[col]);
+				}
+				if (next_label_row)
+				{
+					add_contact(label_row[col], next_background_row[col]);
+					add_contact(next_label_row[col], background_row[col]);
+				}
+			}
+		}
+
+		std::sort(std::begin(tile.contacts), std::end(tile.contacts));
+		tile.contacts.erase(std::unique(std::begin(tile.contacts), std::end(tile.contacts)), std::end(tile.contacts));
+	});
+
+	// Merge components that cross tile borders
+
+	std::vector<int> label_offsets(tiles.size());
+	std::vector<int> background_offsets(tiles.size());
+	int label_count = 0;
+	int background_count = 0;
+
+	for (size_t tile_idx = 0; tile_idx < tiles.size(); ++tile_idx)
+	{
+		label_offsets[tile_idx] = label_count;
+		label_count += int(tiles[tile_idx].regions.size());
+
+		background_offsets[tile_idx] = background_count;
+		background_count += tiles[tile_idx].background_count;
+	}
+
+	std::vector<int> parents(size_t(label_count), 0);
+	std::vector<int> background_parents(size_t(background_count), 0);
+
+	std::iota(std::begin(parents), std::end(parents), 0);
+	std::iota(std::begin(background_parents), std::end(background_parents), 0);
+
+	// Contacts between components and background components, by their global labels
+
+	std::vector<std::pair<int, int>> contacts;
+
+	for (size_t tile_idx = 0; tile_idx < tiles.size(); ++tile_idx)
+	{
+		for (auto const & [label, background_label] : tiles[tile_idx].contacts)
+		{
+			contacts.emplace_back(label_offsets[tile_idx] + label - 1, background_offsets[tile_idx] + background_label - 1);
+		}
+	}
+
+	for (int tile_row = 0; tile_row < tile_rows; ++tile_row)
+	{
+		for (int tile_col = 0; tile_col < tile_cols; ++tile_col)
+		{
+			size_t const tile_idx = size_t(tile_row) * tile_cols + tile_col;
+			auto const & tile = tiles[tile_idx];
+
+			if (tile_col + 1 < tile_cols)
+			{
+				size_t const right_idx = tile_idx + 1;
+				auto const & right = tiles[right_idx];
+
+				UniteStrips(parents, tile.right_col, label_offsets[tile_idx], right.left_col, label_offsets[right_idx], 1);
+				UniteStrips(background_parents, tile.background_right_col, background_offsets[tile_idx], right.background_left_col, background_offsets[right_idx], 0);
+
+				AddStripContacts(contacts, tile.right_col, label_offsets[tile_idx], right.background_left_col, background_offsets[right_idx]);
+				AddStripContacts(contacts, right.left_col, label_offsets[right_idx], tile.background_right_col, background_offsets[tile_idx]);
+			}
+
+			if (tile_row + 1 < tile_rows)
+			{
+				size_t const bottom_idx = tile_idx + tile_cols;
+				auto const & bottom = tiles[bottom_idx];
+
+				UniteStrips(parents, tile.bottom_row, label_offsets[tile_idx], bottom.top_row, label_offsets[bottom_idx], 1);
+				UniteStrips(background_parents, tile.background_bottom_row, background_offsets[tile_idx], bottom.background_top_row, background_offsets[bottom_idx], 0);
+
+				AddStripContacts(contacts, tile.bottom_row, label_offsets[tile_idx], bottom.background_top_row, background_offsets[bottom_idx]);
+				AddStripContacts(contacts, bottom.top_row, label_offsets[bottom_idx], tile.background_bottom_row, background_offsets[tile_idx]);
+
+				// Diagonal neighbours only touch at their corner pixels
+
+				if (size_t const corner_idx = bottom_idx + 1; tile_col + 1 < tile_cols && tile.bottom_row.back() && tiles[corner_idx].top_row.front())
+				{
+					Unite(parents, label_offsets[tile_idx] + tile.bottom_row.back() - 1, label_offsets[corner_idx] + tiles[corner_idx].top_row.front() - 1);
+				}
+				if (size_t const corner_idx = bottom_idx - 1; tile_col > 0 && tile.bottom_row.front() && tiles[corner_idx].top_row.back())
+				{
+					Unite(parents, label_offsets[tile_idx] + tile.bottom_row.front() - 1, label_offsets[corner_idx] + tiles[corner_idx].top_row.back() - 1);
+				}
+			}
+		}
+	}
+
+	// Components touching the image border, or the background reaching it, have an external contour, as the image is framed by background
+
+	std::vector<char> is_outside(size_t(background_count), 0);
+	std::vector<char> is_external(size_t(label_count), 0);
+
+	auto const mark_border = [&] (std::vector<int> const & in_strip, int in_offset, std::vector<int> const & in_background_strip, int in_background_offset)
+	{
+		for (size_t idx = 0; idx < in_strip.size(); ++idx)
+		{
+			if (in_strip[idx] != 0)
+			{
+				is_external[FindRoot(parents, in_offset + in_strip[idx] - 1)] = 1;
+			}
+			if (in_background_strip[idx] != 0)
+			{
+				is_outside[FindRoot(background_parents, in_background_offset + in_background_strip[idx] - 1)] = 1;
+			}
+		}
+	};
+
+	for (size_t tile_idx = 0; tile_idx < tiles.size(); ++tile_idx)
+	{
+		auto const & tile = tiles[tile_idx];
+
+		int const tile_row = int(tile_idx) / tile_cols;
+		int const tile_col = int(tile_idx) % tile_cols;
+
+		if (tile_row == 0)
+		{
+			mark_border(tile.top_row, label_offsets[tile_idx], tile.background_top_row, background_offsets[tile_idx]);
+		}
+		if (tile_row + 1 == tile_rows)
+		{
+			mark_border(tile.bottom_row, label_offsets[tile_idx], tile.background_bottom_row, background_offsets[tile_idx]);
+		}
+		if (tile_col == 0)
+		{
+			mark_border(tile.left_col, label_offsets[tile_idx], tile.background_left_col, background_offsets[tile_idx]);
+		}
+		if (tile_col + 1 == tile_cols)
+		{
+			mark_border(tile.right_col, label_offsets[tile_idx], tile.background_right_col, background_offsets[tile_idx]);
+		}
+	}
+
+	for (auto const & [label, background_label] : contacts)
+	{
+		if (is_outside[FindRoot(background_parents, background_label)])
+		{
+			is_external[FindRoot(parents, label)] = 1;
+		}
+	}
+
+	std::vector<cv::Rect> merged_regions(size_t(label_count), cv::Rect{});
+
+	for (size_t tile_idx = 0; tile_idx < tiles.size(); ++tile_idx)
+	{
+		auto const & regions = tiles[tile_idx].regions;
+
+		for (size_t idx = 0; idx < regions.size(); ++idx)
+		{
+			auto & merged_region = merged_regions[FindRoot(parents, label_offsets[tile_idx] + int(idx))];
+			merged_region = merged_region.empty() ? regions[idx] : merged_region | regions[idx];
+		}
+	}
+
+	// Each merged component yields one region, as its external contour would, and components inside holes of others yield none
+
+	std::pmr::vector<ImageROI> image_ROIs{ in_memory };
+
+	size_t unique_id = 0;
+
+	for (int label = 0; label < label_count; ++label)
+	{
+		if (auto const & region = merged_regions[label]; parents[label] == label && is_external[label] && region.height > in_params[8] && region.width > region.height)
+		{
+			image_ROIs.emplace_back(region, unique_id++);
+		}
+	}
+
+	return image_ROIs;
+}
+
+size_t FindBarcodeROI(cv::Mat const & in_image, std::pmr::vector<ImageROI> & io_ROIs, std::pmr::memory_resource * in_memory)
+{
+	// Rankings hold indices into the regions rather than copies of them
+
+	std::pmr::vector<size_t> x_ranking{ in_memory };
+	std::pmr::vector<size_t> y_ranking{ in_memory };
+
+	x_ranking.reserve(io_ROIs.size());
+	y_ranking.reserve(io_ROIs.size());
+
+	for (size_t ROI_idx = 0; ROI_idx < io_ROIs.size(); ++ROI_idx)
+	{
+		auto & ROI = io_ROIs[ROI_idx];
+
+		cv::Mat img_ROI;
+
+		// Convert ROI to grayscale
+
+		cv::cvtColor(in_image(ROI.region), img_ROI, cv::COLOR_BGR2GRAY);
+
+		cv::Mat x_gradient;
+		cv::Mat y_gradient;
+
+		// Apply Sobel operator: second derivatives both in x and y with a kernel size of 3
+
+		cv::Sobel(img_ROI, x_gradient, cv::FILTER_SCHARR, 2, 0, 3);
+		cv::Sobel(img_ROI, y_gradient, cv::FILTER_SCHARR, 0, 2, 3);
+
+		// Accumulate response for each gradient
+
+		auto const x_response = SumPixels(x_gradient);
+		auto const y_response = SumPixels(y_gradient);
+
+		// Normalize and save response for each gradient
+
+		auto const ROI_size = std::uint64_t(ROI.region.area());
+
+		ROI.x_response = int(x_response / ROI_size);
+		ROI.y_response = int(y_response / ROI_size);
+
+		x_ranking.emplace_back(ROI_idx);
+		y_ranking.emplace_back(ROI_idx);
+	}
+
+	// Sort responses both in x and y, in maximizing order for x and minimizing order for y
+
+	std::sort(std::begin(x_ranking), std::end(x_ranking), [&io_ROIs] (auto const & Elem1, auto const & Elem2) { return io_ROIs[Elem1].x_response > io_ROIs[Elem2].x_response; });
+	std::sort(std::begin(y_ranking), std::end(y_ranking), [&io_ROIs] (auto const & Elem1, auto const & Elem2) { return io_ROIs[Elem1].y_response < io_ROIs[Elem2].y_response; });
+
+	// Search for better overall response among ROIs
+
+	auto const max_x_ROI = x_ranking[0];
+	auto const min_y_ROI = y_ranking[0];
+
+	for (size_t idx = 0; idx < io_ROIs.size(); ++idx)
+	{
+		if (max_x_ROI == y_ranking[idx]) // Preference for a maximizing x response
+		{
+			return max_x_ROI;
+		}
+		if (min_y_ROI == x_ranking[idx])
+		{
+			return min_y_ROI;
+		}
+	}
+
+	return max_x_ROI;
+}
+
+std::pmr::vector<BarcodeSegment> AnalyzeBarcodeRegion(cv::Mat const & in_region, ScanSettings const & in_settings, cv::Mat & out_scan_region, int & out_scan_row, double & out_confidence, std::pmr::memory_resource * in_memory)
+{
+	constexpr int ROI_width = 2560;
+	constexpr int ROI_height = 1440;
+	constexpr int ROI_scanline = ROI_height / 2;
+
+	// Adjust barcode region for processing
+
+	// Convert region to grayscale
+
+	cv::cvtColor(in_region, out_scan_region, cv::COLOR_BGR2GRAY);
+
+	if (in_settings.is_subpixel)
+	{
+		// Equalize pixel intensity, at the resolution of the region
+
+		cv::equalizeHist(out_scan_region, out_scan_region);
+
+		// Locate edges with sub-pixel precision along the binarized halfline, using a thresholding value of 96.0 or one from Otsu's method in adaptive mode
+
+		out_scan_row = out_scan_region.rows / 2;
+
+		return ScanBarcodeSegmentsSubpixel(out_scan_region, out_scan_row,
+			in_settings.is_adaptive ? ComputeOtsuThreshold(out_scan_region, out_confidence) : 96.0, in_memory);
+	}
+
+	// Resize it to 2560x1440
+
+	cv::resize(out_scan_region, out_scan_region, cv::Size(ROI_width, ROI_height), 0.0, 0.0, cv::INTER_CUBIC);
+
+	// Equalize pixel intensity
+
+	cv::equalizeHist(out_scan_region, out_scan_region);
+
+	// Apply morphological operator: close operation with a kernel size of 8 by 8 and 1 iteration
+
+	MorphCloseFixed<8, 8, 1>(out_scan_region, out_scan_region);
+
+	// Convert region to binary image using a simple thresholding function with a thresholding value of 96.0,
+	// or in adaptive mode one from Otsu's method, whose separation of bars and spaces also gives the confidence of the analysis
+
+	ThresholdBinary(out_scan_region, out_scan_region, in_settings.is_adaptive ? ComputeOtsuThreshold(out_scan_region, out_confidence) : 96.0);
+
+	// Iterate through region through a line at half-height, designated scanline, or through several lines and combine their segments
+
+	out_scan_row = ROI_scanline;
+
+	return in_settings.scanline_count > 1 ?
+		ScanBarcodeSegmentsVoting(out_scan_region, in_settings.scanline_count, in_memory) :
+		ScanBarcodeSegments(out_scan_region.ptr<uchar>(ROI_scanline), ROI_width, in_memory);
+}
+
+BarcodeDetection DetectBarcode(cv::Mat const & in_image, std::vector<double> const & in_params, ScanSettings const & in_settings)
+{
+	BarcodeDetection detection;
+
+	// The binary threshold value also comes from Otsu's method in adaptive mode
+
+	std::vector<double> params = in_params;
+
+	if (in_settings.is_adaptive)
+	{
+		params[4] = -1.0;
+	}
+
+	// First step, closing the mask once more with a wider kernel before giving up in adaptive mode
+
+	ImageSnapshot data{ in_image, std::numeric_limits<size_t>::max() };
+
+	auto image_ROIs = FindImageROIs(data, params, false);
+
+	if (image_ROIs.empty() && in_settings.is_adaptive)
+	{
+		image_ROIs = FindImageROIsWidened(data, params);
+	}
+
+	if (image_ROIs.empty())
+	{
+		return detection;
+	}
+
+	// Second and third steps
+
+	detection.barcode_idx = int(FindBarcodeROI(in_image, image_ROIs));
+
+	cv::Mat const barcode_region = in_image(image_ROIs[detection.barcode_idx].region);
+
+	cv::Mat scan_region;
+	int scan_row = 0;
+
+	auto const barcode_segments = AnalyzeBarcodeRegion(barcode_region, in_settings, scan_region, scan_row, detection.confidence);
+
+	detection.ROIs.assign(image_ROIs.begin(), image_ROIs.end());
+	detection.segments.assign(barcode_segments.begin(), barcode_segments.end());
+	detection.pixel_ratio = double(barcode_region.cols) / double(scan_region.cols);
+
+	return detection;
+}
+
+std::uint64_t SumPixels(cv::Mat const & in_image)
+{
+	CV_Assert(in_image.type() == CV_8UC1);
+
+	auto const & kernels = GetSimdKernels();
+
+	if (in_image.isContinuous())
+	{
+		return kernels.sum_bytes(in_image.ptr<uchar>(), in_image.total());
+	}
+
+	std::uint64_t sum = 0;
+	for (int row = 0; row < in_image.rows; ++row)
+	{
+		sum += kernels.sum_bytes(in_image.ptr<uchar>(row), size_t(in_image.cols));
+	}
+	return sum;
+}
+
+void ThresholdBinary(cv::Mat const & in_src, cv::Mat & out_dst, double in_threshold)
+{
+	CV_Assert(in_src.type() == CV_8UC1);
+
+	auto const & kernels = GetSimdKernels();
+
+	out_dst.create(in_src.size(), CV_8UC1);
+
+	for (int row = 0; row < in_src.rows; ++row)
+	{
+		kernels.threshold_binary(in_src.ptr<uchar>(row), out_dst.ptr<uchar>(row), size_t(in_src.cols), cvFloor(in_threshold));
+	}
+}
+
+double ComputeOtsuThreshold(cv::Mat const & in_image, double & out_separability)
+{
+	CV_Assert(in_image.type() == CV_8UC1);
+
+	std::uint64_t histogram[256] = {};
+
+	for (int row = 0; row < in_image.rows; ++row)
+	{
+		uchar const * pixels = in_image.ptr<uchar>(row);
+
+		for (int col = 0; col < in_image.cols; ++col)
+		{
+			++histogram[pixels[col]];
+		}
+	}
+
+	auto const total_count = double(in_image.total());
+
+	double total_sum = 0.0;
+	double total_square_sum = 0.0;
+
+	for (int level = 0; level < 256; ++level)
+	{
+		total_sum += double(level) * double(histogram[level]);
+		total_square_sum += double(level) * double(level) * double(histogram[level]);
+	}
+
+	double const total_mean = total_count > 0.0 ? total_sum / total_count : 0.0;
+	double const total_variance = total_count > 0.0 ? total_square_sum / total_count - total_mean * total_mean : 0.0;
+
+	// Choose the threshold that maximizes the variance between pixels at or below it and pixels above it
+
+	int best_threshold = 0;
+	double best_variance = 0.0;
+
+	double lower_count = 0.0;
+	double lower_sum = 0.0;
+
+	for (int level = 0; level < 255; ++level)
+	{
+		lower_count += double(histogram[level]);
+		lower_sum += double(level) * double(histogram[level]);
+
+		double const upper_count = total_count - lower_count;
+
+		if (lower_count == 0.0 || upper_count == 0.0)
+		{
+			continue;
+		}
+
+		double const mean_difference = lower_sum / lower_count - (total_sum - lower_sum) / upper_count;
+		double const variance = lower_count * upper_count * mean_difference * mean_difference / (total_count * total_count);
+
+		if (variance > best_variance)
+		{
+			best_threshold = level;
+			best_variance = variance;
+		}
+	}
+
+	out_separability = total_variance > 0.0 ? std::min(best_variance / total_variance, 1.0) : 0.0;
+
+	return double(best_threshold);
+}
+
+std::pmr::vector<BarcodeSegment> ScanBarcodeSegments(uchar const * in_scanline, int in_width, std::pmr::memory_resource * in_memory)
+{
+	int const halfline = in_width / 2;
+
+	// Split the scanline in runs of pixels likely to belong to a bar or space based on intensity, then walk them rather than every pixel
+
+	std::pmr::vector<int> run_starts(size_t(in_width) + 1, in_memory);
+	size_t const run_count = GetSimdKernels().extract_runs(in_scanline, size_t(in_width), run_starts.data());
+	run_starts[run_count] = in_width;
+
+	std::pmr::vector<BarcodeSegment> barcode_segments{ in_memory };
+
+	size_t scan_step = 0;
+
+	int longest_bar = 0;
+	int current_bar = 0;
+	int current_space = 0;
+
+	// Mark a new segment if its type differs from the last one
+	auto const mark_segment = [&barcode_segments] (int start_paint, bool on_bar)
+	{
+		if (start_paint && on_bar != (!barcode_segments.empty() && barcode_segments.back().is_bar))
+		{
+			barcode_segments.emplace_back(start_paint, on_bar);
+		}
+	};
+
+	// Accumulate bar and space widths along pixels from the first to the end of a run while on barcode
+	auto const scan_barcode = [&] (int first_pixel, int end_pixel, bool on_bar)
+	{
+		if (first_pixel >= end_pixel)
+		{
+			return;
+		}
+
+		if (on_bar)
+		{
+			longest_bar = std::max(current_bar + end_pixel - first_pixel - 1, longest_bar);
+			current_bar += end_pixel - first_pixel;
+			current_space = 0;
+		}
+		else
+		{
+			longest_bar = std::max(current_bar, longest_bar);
+			current_bar = 0;
+
+			// Rule to determine whether we should look for where to stop painting: first pixel past the halfline with enough space behind it
+			int const stop_pixel = std::max({ halfline, first_pixel + longest_bar * 2 - current_space, first_pixel });
+			scan_step += size_t(stop_pixel < end_pixel);
+
+			current_space += end_pixel - first_pixel;
+		}
+	};
+
+	bool on_bar = in_width > 0 && in_scanline[0] < 128;
+
+	for (size_t run_idx = 0; run_idx < run_count && scan_step < 5; ++run_idx, on_bar = !on_bar)
+	{
+		int const start_pixel = run_starts[run_idx];
+		int const end_pixel = run_starts[run_idx + 1];
+
+		// Determine whether we should paint based on likely position along the region
+		switch (scan_step)
+		{
+		case 0: // Pre-start
+			scan_step += size_t(!on_bar);
+			break;
+		case 1: // Pre-delim bar (its first pixel is not painted)
+			scan_step += size_t(on_bar);
+			if (on_bar && start_pixel + 1 < end_pixel)
+			{
+				mark_segment(start_pixel + 1, on_bar);
+			}
+			break;
+		case 2: // First delim bar
+			mark_segment(start_pixel, on_bar);
+			scan_step += size_t(!on_bar);
+			break;
+		case 3: // Second delim bar (barcode starts after its first pixel)
+			mark_segment(start_pixel, on_bar);
+			if (on_bar)
+			{
+				++scan_step;
+				scan_barcode(start_pixel + 1, end_pixel, on_bar);
+			}
+			break;
+		case 4: // On barcode
+			mark_segment(start_pixel, on_bar);
+			scan_barcode(start_pixel, end_pixel, on_bar);
+			break;
+		}
+	}
+
+	return barcode_segments;
+}
+
+std::pmr::vector<BarcodeSegment> ScanBarcodeSegmentsSubpixel(cv::Mat const & in_gray, int in_scanline, double in_threshold, std::pmr::memory_resource * in_memory)
+{
+	CV_Assert(in_gray.type() == CV_8UC1 && 0 <= in_scanline && in_scanline < in_gray.rows);
+
+	int const width = in_gray.cols;
+
+	// Average the scanline with its neighbours to reduce noise
+
+	std::pmr::vector<float> profile(size_t(width), 0.0f, in_memory);
+
+	int const first_row = std::max(in_scanline - 1, 0);
+	int const last_row = std::min(in_scanline + 1, in_gray.rows - 1);
+
+	for (int row = first_row; row <= last_row; ++row)
+	{
+		uchar const * pixels = in_gray.ptr<uchar>(row);
+
+		for (int col = 0; col < width; ++col)
+		{
+			profile[col] += float(pixels[col]);
+		}
+	}
+
+	for (auto & value : profile)
+	{
+		value /= float(last_row - first_row + 1);
+	}
+
+	// Find the segments along the binarized profile, with whole pixel precision
+
+	std::pmr::vector<uchar> scanline(size_t(width), in_memory);
+
+	for (int col = 0; col < width; ++col)
+	{
+		scanline[col] = profile[col] > float(cvFloor(in_threshold)) ? 255 : 0;
+	}
+
+	auto barcode_segments = ScanBarcodeSegments(scanline.data(), width, in_memory);
+
+	// Central differences of the profile, whose magnitude peaks at edges
+
+	std::pmr::vector<float> gradient(size_t(width), 0.0f, in_memory);
+
+	for (int col = 1; col + 1 < width; ++col)
+	{
+		gradient[col] = std::abs(profile[col + 1] - profile[col - 1]) * 0.5f;
+	}
+
+	for (auto & segment : barcode_segments)
+	{
+		// Segments start either at an edge or one pixel past it
+
+		int const start = segment.start_pixel;
+		int const edge = start > 0 && scanline[start] != scanline[start - 1] ? start : start - 1;
+
+		if (edge < 2 || edge + 1 >= width || scanline[edge] == scanline[edge - 1])
+		{
+			continue;
+		}
+
+		// The edge lies between the centres of its two pixels, so the gradient peaks at one of them
+		// Fit a parabola through the peak and its neighbours, whose vertex is where the second derivative crosses zero
+
+		int const peak = gradient[edge - 1] >= gradient[edge] ? edge - 1 : edge;
+
+		float const previous = gradient[peak - 1];
+		float const current = gradient[peak];
+		float const next = gradient[peak + 1];
+
+		float const curvature = previous - 2.0f * current + next;
+		float const offset = curvature < 0.0f ? std::clamp((previous - next) / (2.0f * curvature), -0.5f, 0.5f) : 0.0f;
+
+		// Pixel centres are half a pixel past their starts
+		// Every segment is reported at its fitted edge, whether the whole pixel scan started it at the edge or one pixel past it,
+		// so that widths measured between them are not off by that pixel
+
+		segment.start_position = double(peak) + double(offset) + 0.5;
+	}
+
+	return barcode_segments;
+}
+
+std::pmr::vector<BarcodeSegment> ScanBarcodeSegmentsVoting(cv::Mat const & in_region, int in_scanline_count, std::pmr::memory_resource * in_memory)
+{
+	CV_Assert(in_region.type() == CV_8UC1 && in_region.rows > 0);
+
+	int const width = in_region.cols;
+	int const scanline_count = std::clamp(in_scanline_count, 1, in_region.rows);
+
+	if (scanline_count == 1)
+	{
+		return ScanBarcodeSegments(in_region.ptr<uchar>(in_region.rows / 2), width, in_memory);
+	}
+
+	// Scanlines are evenly spaced around the halfline, across the middle half of the region
+
+	int const scanline_spacing = in_region.rows / (2 * scanline_count);
+
+	auto const scanline_row = [&] (int scanline_idx)
+	{
+		return in_region.rows / 2 + (2 * scanline_idx - (scanline_count - 1)) * scanline_spacing / 2;
+	};
+
+	// The arena is not thread safe, so each scanline works in its own slice of it (falling back to the default resource if it runs out),
+	// and copies its segments into storage reserved beforehand
+
+	size_t const buffer_size = (size_t(width) + 1) * (sizeof(int) + 3 * sizeof(BarcodeSegment));
+
+	std::pmr::vector<std::byte> line_buffers(buffer_size * scanline_count, in_memory);
+	std::pmr::vector<std::pmr::vector<BarcodeSegment>> line_segments(scanline_count, in_memory);
+
+	for (auto & segments : line_segments)
+	{
+		segments.reserve(size_t(width) + 1);
+	}
+
+	GetTaskScheduler()->ParallelFor(size_t(scanline_count), [&] (size_t scanline_idx)
+	{
+		std::pmr::monotonic_buffer_resource line_memory{ line_buffers.data() + buffer_size * scanline_idx, buffer_size };
+
+		auto const segments = ScanBarcodeSegments(in_region.ptr<uchar>(scanline_row(int(scanline_idx))), width, &line_memory);
+		line_segments[scanline_idx].assign(segments.begin(), segments.end());
+	});
+
+	// Choose the number of segments found by most scanlines, preferring scanlines closer to the halfline on ties
+
+	std::pmr::vector<int> scanline_order(scanline_count, in_memory);
+	std::iota(scanline_order.begin(), scanline_order.end(), 0);
+	std::stable_sort(scanline_order.begin(), scanline_order.end(), [scanline_count] (int scanline_idx1, int scanline_idx2)
+	{
+		return std::abs(2 * scanline_idx1 - (scanline_count - 1)) < std::abs(2 * scanline_idx2 - (scanline_count - 1));
+	});
+
+	size_t consensus_size = 0;
+	int consensus_votes = 0;
+
+	for (int scanline_idx : scanline_order)
+	{
+		auto const size = line_segments[scanline_idx].size();
+
+		auto const votes = int(std::count_if(line_segments.begin(), line_segments.end(), [size] (auto const & segments)
+		{
+			return segments.size() == size;
+		}));
+
+		if (size > 0 && votes > consensus_votes)
+		{
+			consensus_size = size;
+			consensus_votes = votes;
+		}
+	}
+
+	std::pmr::vector<BarcodeSegment> barcode_segments{ in_memory };
+
+	if (consensus_votes == 0)
+	{
+		return barcode_segments;
+	}
+
+	// Each segment starts at the median of its starts along the scanlines that voted for the chosen number of segments
+	// Medians of increasing sequences are increasing as well, so the segments remain in order
+
+	barcode_segments.reserve(consensus_size);
+
+	std::pmr::vector<int> segment_starts{ in_memory };
+	segment_starts.reserve(size_t(consensus_votes));
+
+	for (size_t segment_idx = 0; segment_idx < consensus_size; ++segment_idx)
+	{
+		segment_starts.clear();
+
+		bool is_bar = false;
+
+		for (auto const & segments : line_segments)
+		{
+			if (segments.size() == consensus_size)
+			{
+				segment_starts.push_back(segments[segment_idx].start_pixel);
+				is_bar = segments[segment_idx].is_bar;
+			}
+		}
+
+		auto const median = segment_starts.begin() + segment_starts.size() / 2;
+		std::nth_element(segment_starts.begin(), median, segment_starts.end());
+
+		barcode_segments.emplace_back(*median, is_bar);
+	}
+
+	// A scanline agrees on a segment if it found one of the same type starting and ending near it, even if it found a different number of segments
+
+	for (size_t segment_idx = 0; segment_idx < consensus_size; ++segment_idx)
+	{
+		auto & segment = barcode_segments[segment_idx];
+
+		bool const has_end = segment_idx + 1 < consensus_size;
+		int const segment_end = has_end ? barcode_segments[segment_idx + 1].start_pixel : segment.start_pixel;
+		int const tolerance = std::max((segment_end - segment.start_pixel) / 4, 2);
+
+		int agreeing_count = 0;
+
+		for (auto const & segments : line_segments)
+		{
+			auto it = std::lower_bound(segments.begin(), segments.end(), segment.start_pixel - tolerance, [] (BarcodeSegment const & line_segment, int pixel)
+			{
+				return line_segment.start_pixel < pixel;
+			});
+
+			for (; it != segments.end() && it->start_pixel <= segment.start_pixel + tolerance; ++it)
+			{
+				if (it->is_bar != segment.is_bar)
+				{
+					continue;
+				}
+
+				if (!has_end || std::next(it) != segments.end() && std::abs(std::next(it)->start_pixel - segment_end) <= tolerance)
+				{
+					++agreeing_count;
+					break;
+				}
+			}
+		}
+
+		segment.agreement = double(agreeing_count) / double(scanline_count);
+	}
+
+	return barcode_segments;
+}
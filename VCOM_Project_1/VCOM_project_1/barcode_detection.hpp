@@ -0,0 +1,77 @@
+#ifndef BARCODE_DETECTION_HEADER
+#define BARCODE_DETECTION_HEADER
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "opencv_utility.hpp"
+
+// Settings of the third step
+struct ScanSettings
+{
+	bool is_adaptive = false; // Threshold from Otsu's method, reporting the confidence of the analysis
+	bool is_subpixel = false; // Measured at the resolution of the region with sub-pixel edges, along a single scanline
+	int scanline_count = 1;
+};
+
+// Outcome of the first three steps on an image
+struct BarcodeDetection
+{
+	std::vector<ImageROI> ROIs;
+	int barcode_idx = -1; // Index of the ROI with the barcode, or -1 if none was found
+
+	std::vector<BarcodeSegment> segments; // Empty if the barcode could not be analyzed
+	double pixel_ratio = 1.0; // Width of a pixel of the region where the segments were measured, in pixels of the image
+	double confidence = 0.0; // Only in adaptive mode
+};
+
+// Transforms a BGR image into the binary mask of potential barcode regions (first step, up to the close operation)
+void ComputeBarcodeMask(ImageSnapshot & io_data, std::vector<double> const & in_params, bool is_debugging);
+
+// Finds potential barcode regions in a BGR image (first step)
+std::pmr::vector<ImageROI> FindImageROIs(ImageSnapshot & io_data, std::vector<double> const & in_params, bool is_debugging, std::pmr::memory_resource * in_memory = std::pmr::get_default_resource());
+
+// Finds potential barcode regions in the binary mask of a BGR image (first step, after the close operation)
+std::pmr::vector<ImageROI> FindMaskROIs(ImageSnapshot & io_data, std::vector<double> const & in_params, bool is_debugging, std::pmr::memory_resource * in_memory = std::pmr::get_default_resource());
+
+// Closes the mask left by FindImageROIs (in non-debug mode) once more with a kernel of twice the width, and finds potential barcode regions in it again
+std::pmr::vector<ImageROI> FindImageROIsWidened(ImageSnapshot & io_data, std::vector<double> const & in_params, std::pmr::memory_resource * in_memory = std::pmr::get_default_resource());
+
+// Finds potential barcode regions in a BGR image by processing it in overlapping tiles, as tasks of the scheduler, bounding memory by tile size
+std::pmr::vector<ImageROI> FindImageROIsTiled(cv::Mat const & in_image, std::vector<double> const & in_params, int in_tile_size, std::pmr::memory_resource * in_memory = std::pmr::get_default_resource());
+
+// Computes the gradient responses of each region and returns the index of the most likely barcode among them (second step)
+size_t FindBarcodeROI(cv::Mat const & in_image, std::pmr::vector<ImageROI> & io_ROIs, std::pmr::memory_resource * in_memory = std::pmr::get_default_resource());
+
+// Sum of all pixels of a single channel 8-bit image
+std::uint64_t SumPixels(cv::Mat const & in_image);
+
+// Same as cv::threshold with cv::THRESH_BINARY and a maximum value of 255, for single channel 8-bit images
+void ThresholdBinary(cv::Mat const & in_src, cv::Mat & out_dst, double in_threshold);
+
+// Threshold of a single channel 8-bit image by Otsu's method, along with how well it separates both classes,
+// as the ratio of between-class variance to total variance (0 for a uniform image, 1 for a two-valued one)
+double ComputeOtsuThreshold(cv::Mat const & in_image, double & out_separability);
+
+// Analyzes the barcode in a BGR barcode region (third step), leaving the grayscale image it was measured on and the row measured along,
+// at its halfline (possibly upscaled), for the segments to be painted on
+std::pmr::vector<BarcodeSegment> AnalyzeBarcodeRegion(cv::Mat const & in_region, ScanSettings const & in_settings, cv::Mat & out_scan_region, int & out_scan_row, double & out_confidence, std::pmr::memory_resource * in_memory = std::pmr::get_default_resource());
+
+// Runs the first three steps on a BGR image, as the program does in non-debug mode with whole images, without modifying it
+BarcodeDetection DetectBarcode(cv::Mat const & in_image, std::vector<double> const & in_params, ScanSettings const & in_settings);
+
+// Finds the barcode segments along a scanline of a binary barcode region (third step)
+std::pmr::vector<BarcodeSegment> ScanBarcodeSegments(uchar const * in_scanline, int in_width, std::pmr::memory_resource * in_memory = std::pmr::get_default_resource());
+
+// Finds the barcode segments along a scanline of a grayscale barcode region at its native resolution, binarized with the specified threshold,
+// then refines the start of each segment to the peak of the intensity gradient across its edge, with sub-pixel precision (third step)
+std::pmr::vector<BarcodeSegment> ScanBarcodeSegmentsSubpixel(cv::Mat const & in_gray, int in_scanline, double in_threshold, std::pmr::memory_resource * in_memory = std::pmr::get_default_resource());
+
+// Finds the barcode segments along several scanlines across the middle half of a binary barcode region, in parallel,
+// and combines them into the segments most scanlines found, each with the fraction of scanlines that agree on it (third step)
+std::pmr::vector<BarcodeSegment> ScanBarcodeSegmentsVoting(cv::Mat const & in_region, int in_scanline_count, std::pmr::memory_resource * in_memory = std::pmr::get_default_resource());
+
+#endif
@@ -3,7 +3,7 @@
 #include "event_handling.hpp"
 #include "opencv_utility.hpp"
 
-int WaitEvent(bool is_debugging)
+int WaitEvent(bool is_debugging, bool is_streaming)
 {
 	static bool is_selecting = false;
 	static int selected_image = 0;
@@ -11,13 +11,19 @@ int WaitEvent(bool is_debugging)
 	static bool should_wait = false;
 	while (should_wait)
 	{
-		int key_code = cv::waitKey(0);
+		// While streaming, only wait long enough for the frame to be drawn
+		int key_code = cv::waitKey(is_streaming ? 1 : 0);
 
 		if (key_code == VK_ESCAPE)
 		{
 			return EventType::Exit;
 		}
 
+		if (is_streaming)
+		{
+			return EventType::NextFrame;
+		}
+
 		if (is_debugging)
 		{
 			if (key_code == 0x68) // 'h' ASCII code
@@ -30,6 +30,8 @@ struct EventType
 		EndSelectImage,
 
 		AdjustImage,
+
+		NextFrame,
 	};
 };
 
@@ -62,7 +64,7 @@ private:
 
 };
 
-int WaitEvent(bool is_debugging);
+int WaitEvent(bool is_debugging, bool is_streaming = false);
 void ProcessEvent(bool is_debugging, int const & in_event, std::vector<Image> const & in_img_array, Image & out_img, std::vector<double> & out_params);
 
 void ConsoleClear();
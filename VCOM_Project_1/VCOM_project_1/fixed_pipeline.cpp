@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cmath>
+
+#include "fixed_pipeline.hpp"
+
+namespace fixed_pipeline_detail
+{
+	std::vector<std::uint32_t> GaussianKernelFixedPoint(int in_size, double in_sigma)
+	{
+		CV_Assert(in_size > 0 && in_size % 2 == 1);
+
+		int const half = in_size / 2;
+
+		// Small kernels without a sigma are fixed, and others sampled from the Gaussian, as with cv::getGaussianKernel
+
+		std::vector<double> kernel(size_t(in_size), 0.0);
+
+		if (in_sigma <= 0.0 && in_size <= 7)
+		{
+			static double const fixed_kernels[4][7] = {
+				{ 1.0 },
+				{ 0.25, 0.5, 0.25 },
+				{ 0.0625, 0.25, 0.375, 0.25, 0.0625 },
+				{ 0.03125, 0.109375, 0.21875, 0.28125, 0.21875, 0.109375, 0.03125 }
+			};
+
+			std::copy(fixed_kernels[half], fixed_kernels[half] + in_size, std::begin(kernel));
+		}
+		else
+		{
+			double const sigma = in_sigma > 0.0 ? in_sigma : std::fma(double(in_size), 0.15, 0.35);
+			double const scale = -0.125 / (sigma * sigma);
+
+			double sum = 0.0;
+			for (int idx = 0, x = 1 - in_size; idx < half; ++idx, x += 2)
+			{
+				kernel[size_t(idx)] = std::exp(double(x * x) * scale);
+				sum += kernel[size_t(idx)];
+			}
+			sum = sum * 2.0 + 1.0;
+
+			double const normaliser = 1.0 / sum;
+			for (int idx = 0; idx < half; ++idx)
+			{
+				kernel[size_t(idx)] *= normaliser;
+				kernel[size_t(in_size - 1 - idx)] = kernel[size_t(idx)];
+			}
+			kernel[size_t(half)] = normaliser;
+		}
+
+		// Coefficients are rounded to nearest even, as OpenCV's soft floating point does
+
+		std::vector<std::uint32_t> coeffs(size_t(in_size), 0);
+
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 2)
+		// Since OpenCV 4.2, the rounding error of each outer coefficient is carried over to the next, and the middle one makes up the rest
+
+		double error = 0.0;
+		std::uint32_t outer_sum = 0;
+
+		for (int idx = 0; idx < half; ++idx)
+		{
+			double const adjusted = kernel[size_t(idx)] * 256.0 + error;
+			double const rounded = std::nearbyint(adjusted);
+
+			error = adjusted - rounded;
+
+			coeffs[size_t(idx)] = std::uint32_t(rounded);
+			coeffs[size_t(in_size - 1 - idx)] = std::uint32_t(rounded);
+			outer_sum += std::uint32_t(rounded) * 2;
+		}
+		coeffs[size_t(half)] = 256 - outer_sum;
+#else
+		// Before OpenCV 4.2, every coefficient is rounded on its own, so they may not add up to 1 exactly
+
+		std::transform(std::begin(kernel), std::end(kernel), std::begin(coeffs), [] (double coeff) { return std::uint32_t(std::nearbyint(coeff * 256.0)); });
+#endif
+
+		return coeffs;
+	}
+}
+
+namespace
+{
+	template <class ... Pipeline_Types>
+	bool DispatchFixedPipeline(cv::Mat const & in_gray, cv::Mat & out_mask, std::vector<double> const & in_params)
+	{
+		return ((Pipeline_Types::Matches(in_params) && (Pipeline_Types::ComputeMask(in_gray, out_mask, in_params), true)) || ...);
+	}
+}
+
+bool ComputeFixedBarcodeMask(cv::Mat const & in_gray, cv::Mat & out_mask, std::vector<double> const & in_params)
+{
+	// Specialisations for the default kernel sizes and iterations, others fall back to the generic pipeline
+
+	return DispatchFixedPipeline<
+		FixedBarcodePipeline<5, 3, 8, 2, 2>
+	>(in_gray, out_mask, in_params);
+}
@@ -0,0 +1,25 @@
+#ifndef FIXED_PIPELINE_HEADER
+#define FIXED_PIPELINE_HEADER
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// Close operation with a rectangular kernel of compile-time size and iterations, on a single channel 8-bit image
+template <int Kernel_Width, int Kernel_Height, int Iterations>
+void MorphCloseFixed(cv::Mat const & in_src, cv::Mat & out_dst);
+
+// First step of the pipeline, from grayscale image to closed binary mask, with compile-time kernel sizes and iterations
+template <int Gauss_Width, int Gauss_Height, int Morph_Width, int Morph_Height, int Morph_Iterations>
+struct FixedBarcodePipeline
+{
+	static bool Matches(std::vector<double> const & in_params) noexcept;
+	static void ComputeMask(cv::Mat const & in_gray, cv::Mat & out_mask, std::vector<double> const & in_params);
+};
+
+// Computes the binary mask with a specialised pipeline if one matches the parameters, returning false otherwise
+bool ComputeFixedBarcodeMask(cv::Mat const & in_gray, cv::Mat & out_mask, std::vector<double> const & in_params);
+
+#include "fixed_pipeline.tpp"
+
+#endif
@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#include "simd_kernels.hpp"
+
+namespace fixed_pipeline_detail
+{
+	// Same coefficients as the 8-bit fixed point kernels of cv::GaussianBlur, with 8 fractional bits
+	std::vector<std::uint32_t> GaussianKernelFixedPoint(int in_size, double in_sigma);
+
+	// Same as cv::borderInterpolate with cv::BORDER_REFLECT_101
+	inline int Reflect101(int in_idx, int in_length) noexcept
+	{
+		if (in_length == 1)
+		{
+			return 0;
+		}
+
+		while (in_idx < 0 || in_idx >= in_length)
+		{
+			in_idx = in_idx < 0 ? -in_idx : 2 * in_length - 2 - in_idx;
+		}
+
+		return in_idx;
+	}
+
+	template <class Op_Type, int ... Offsets>
+	inline uchar FoldWindow(uchar const * in_src, Op_Type op, std::integer_sequence<int, Offsets...>) noexcept
+	{
+		uchar value = in_src[0];
+		((value = op(value, in_src[Offsets + 1])), ...);
+		return value;
+	}
+
+	template <size_t Size, class Op_Type, int ... Offsets>
+	inline uchar FoldRows(std::array<uchar const *, Size> const & in_rows, int in_col, Op_Type op, std::integer_sequence<int, Offsets...>) noexcept
+	{
+		uchar value = in_rows[0][in_col];
+		((value = op(value, in_rows[Offsets + 1][in_col])), ...);
+		return value;
+	}
+
+	// Horizontal pass of cv::GaussianBlur on 8-bit images, exact with 8 fractional bits, saturated as its 16-bit fixed point sums are
+	template <size_t Size, size_t ... Offsets>
+	inline std::uint32_t Convolve(std::array<std::uint32_t, Size> const & in_coeffs, uchar const * in_src, std::index_sequence<Offsets...>) noexcept
+	{
+		return std::min(((in_coeffs[Offsets] * std::uint32_t(in_src[Offsets])) + ...), std::uint32_t(0xFFFF));
+	}
+
+	// Vertical pass, exact with 16 fractional bits, then rounded to 8 bits
+	template <size_t Size, size_t ... Offsets>
+	inline uchar ConvolveRows(std::array<std::uint32_t, Size> const & in_coeffs, std::array<std::uint32_t const *, Size> const & in_rows, int in_col, std::index_sequence<Offsets...>) noexcept
+	{
+		return uchar(std::min((((in_coeffs[Offsets] * in_rows[Offsets][in_col]) + ...) + 0x8000) >> 16, std::uint32_t(255)));
+	}
+
+	// Applies op over a horizontal window of each pixel, clipped to the row (same as a constant border that never wins)
+	template <int Window, int Anchor, class Op_Type>
+	void FilterRowFixed(uchar const * in_src, uchar * out_dst, int in_length, Op_Type op) noexcept
+	{
+		int const interior_begin = std::min(Anchor, in_length);
+		int const interior_end = std::max(in_length - Window + 1 + Anchor, interior_begin);
+
+		auto const filter_clipped = [&] (int col)
+		{
+			int const first = std::max(col - Anchor, 0);
+			int const last = std::min(col - Anchor + Window - 1, in_length - 1);
+
+			uchar value = in_src[first];
+			for (int idx = first + 1; idx <= last; ++idx)
+			{
+				value = op(value, in_src[idx]);
+			}
+			out_dst[col] = value;
+		};
+
+		for (int col = 0; col < interior_begin; ++col)
+		{
+			filter_clipped(col);
+		}
+		for (int col = interior_begin; col < interior_end; ++col)
+		{
+			out_dst[col] = FoldWindow(in_src + col - Anchor, op, std::make_integer_sequence<int, Window - 1>{});
+		}
+		for (int col = interior_end; col < in_length; ++col)
+		{
+			filter_clipped(col);
+		}
+	}
+
+	// Applies op over a vertical window of each pixel, clipped to the image
+	template <int Window, int Anchor, class Op_Type>
+	void FilterColsFixed(cv::Mat const & in_src, cv::Mat & out_dst, Op_Type op) noexcept
+	{
+		for (int row = 0; row < in_src.rows; ++row)
+		{
+			int const first = std::max(row - Anchor, 0);
+			int const last = std::min(row - Anchor + Window - 1, in_src.rows - 1);
+
+			uchar * dst_row = out_dst.ptr<uchar>(row);
+
+			if (last - first + 1 == Window)
+			{
+				std::array<uchar const *, Window> src_rows;
+				for (int idx = 0; idx < Window; ++idx)
+				{
+					src_rows[idx] = in_src.ptr<uchar>(first + idx);
+				}
+
+				for (int col = 0; col < in_src.cols; ++col)
+				{
+					dst_row[col] = FoldRows(src_rows, col, op, std::make_integer_sequence<int, Window - 1>{});
+				}
+			}
+			else
+			{
+				std::copy(in_src.ptr<uchar>(first), in_src.ptr<uchar>(first) + in_src.cols, dst_row);
+
+				for (int idx = first + 1; idx <= last; ++idx)
+				{
+					uchar const * src_row = in_src.ptr<uchar>(idx);
+					for (int col = 0; col < in_src.cols; ++col)
+					{
+						dst_row[col] = op(dst_row[col], src_row[col]);
+					}
+				}
+			}
+		}
+	}
+}
+
+template <int Kernel_Width, int Kernel_Height, int Iterations>
+void MorphCloseFixed(cv::Mat const & in_src, cv::Mat & out_dst)
+{
+	static_assert(Kernel_Width > 0 && Kernel_Height > 0 && Iterations > 0, "Kernel sizes and iterations must be positive");
+
+	using namespace fixed_pipeline_detail;
+
+	CV_Assert(in_src.type() == CV_8UC1);
+
+	// Iterations of a rectangular kernel are equivalent to a single larger kernel, as done by cv::morphologyEx
+
+	constexpr int window_width = Kernel_Width + (Iterations - 1) * (Kernel_Width - 1);
+	constexpr int window_height = Kernel_Height + (Iterations - 1) * (Kernel_Height - 1);
+	constexpr int anchor_x = (Kernel_Width / 2) * Iterations;
+	constexpr int anchor_y = (Kernel_Height / 2) * Iterations;
+
+	auto const max_op = [] (uchar value1, uchar value2) { return std::max(value1, value2); };
+	auto const min_op = [] (uchar value1, uchar value2) { return std::min(value1, value2); };
+
+	cv::Mat row_buffer{ in_src.size(), CV_8UC1 };
+	cv::Mat col_buffer{ in_src.size(), CV_8UC1 };
+
+	// Dilate
+
+	for (int row = 0; row < in_src.rows; ++row)
+	{
+		FilterRowFixed<window_width, anchor_x>(in_src.ptr<uchar>(row), row_buffer.ptr<uchar>(row), in_src.cols, max_op);
+	}
+	FilterColsFixed<window_height, anchor_y>(row_buffer, col_buffer, max_op);
+
+	// Erode
+
+	for (int row = 0; row < in_src.rows; ++row)
+	{
+		FilterRowFixed<window_width, anchor_x>(col_buffer.ptr<uchar>(row), row_buffer.ptr<uchar>(row), in_src.cols, min_op);
+	}
+	out_dst.create(in_src.size(), CV_8UC1);
+	FilterColsFixed<window_height, anchor_y>(row_buffer, out_dst, min_op);
+}
+
+template <int Gauss_Width, int Gauss_Height, int Morph_Width, int Morph_Height, int Morph_Iterations>
+bool FixedBarcodePipeline<Gauss_Width, Gauss_Height, Morph_Width, Morph_Height, Morph_Iterations>::Matches(std::vector<double> const & in_params) noexcept
+{
+	// Thresholds from Otsu's method need the histogram of the whole blurred image, so they cannot be streamed
+
+	return in_params[4] >= 0.0 && int(in_params[0]) == Gauss_Width && int(in_params[1]) == Gauss_Height &&
+		int(in_params[5]) == Morph_Width && int(in_params[6]) == Morph_Height && int(in_params[7]) == Morph_Iterations;
+}
+
+template <int Gauss_Width, int Gauss_Height, int Morph_Width, int Morph_Height, int Morph_Iterations>
+void FixedBarcodePipeline<Gauss_Width, Gauss_Height, Morph_Width, Morph_Height, Morph_Iterations>::ComputeMask(cv::Mat const & in_gray, cv::Mat & out_mask, std::vector<double> const & in_params)
+{
+	static_assert(Gauss_Width % 2 == 1 && Gauss_Height % 2 == 1, "Gaussian kernel sizes must be odd");
+
+	using namespace fixed_pipeline_detail;
+
+	CV_Assert(in_gray.type() == CV_8UC1);
+
+	constexpr int gauss_radius_x = Gauss_Width / 2;
+	constexpr int gauss_radius_y = Gauss_Height / 2;
+
+	int const rows = in_gray.rows;
+	int const cols = in_gray.cols;
+
+	// Gaussian coefficients depend on the sigmas, which remain runtime values (as in cv::GaussianBlur, a null sigma y follows sigma x)
+	// Blurring is done in the same fixed point as cv::GaussianBlur, so that the result is the same to the bit
+
+	double const sigma_x = in_params[2];
+	double const sigma_y = in_params[3] > 0.0 ? in_params[3] : in_params[2];
+
+	auto const kernel_x = GaussianKernelFixedPoint(Gauss_Width, sigma_x);
+	auto const kernel_y = GaussianKernelFixedPoint(Gauss_Height, sigma_y);
+
+	std::array<std::uint32_t, Gauss_Width> coeffs_x;
+	std::array<std::uint32_t, Gauss_Height> coeffs_y;
+
+	std::copy(std::begin(kernel_x), std::end(kernel_x), std::begin(coeffs_x));
+	std::copy(std::begin(kernel_y), std::end(kernel_y), std::begin(coeffs_y));
+
+	// Same comparison as cv::threshold for 8-bit images
+
+	int const threshold = cvFloor(in_params[4]);
+
+	auto const & kernels = GetSimdKernels();
+
+	// Rows are processed one at a time: Sobel pair and subtraction, horizontal blur, then vertical blur and threshold,
+	// keeping only the last horizontally blurred rows in a ring buffer
+
+	std::vector<int> smooth_row(size_t(cols) + 2);
+	std::vector<int> deriv_row(size_t(cols) + 2);
+	std::vector<uchar> x_gradient_row(cols);
+	std::vector<uchar> y_gradient_row(cols);
+	std::vector<uchar> difference_row(size_t(cols) + gauss_radius_x * 2);
+	std::vector<uchar> blurred_values(cols);
+
+	std::array<std::vector<std::uint32_t>, Gauss_Height> blurred_rows;
+	std::array<int, Gauss_Height> blurred_row_idxs;
+
+	blurred_rows.fill(std::vector<std::uint32_t>(size_t(cols)));
+	blurred_row_idxs.fill(-1);
+
+	auto const compute_blurred_row = [&] (int row) -> std::uint32_t const *
+	{
+		auto & blurred_row = blurred_rows[size_t(row % Gauss_Height)];
+		auto & blurred_row_idx = blurred_row_idxs[size_t(row % Gauss_Height)];
+
+		if (blurred_row_idx == row)
+		{
+			return blurred_row.data();
+		}
+
+		uchar const * up_row = in_gray.ptr<uchar>(Reflect101(row - 1, rows));
+		uchar const * mid_row = in_gray.ptr<uchar>(row);
+		uchar const * down_row = in_gray.ptr<uchar>(Reflect101(row + 1, rows));
+
+		// Vertical parts of both Sobel kernels: [1, 2, 1] for the x derivative, [1, -2, 1] for the y derivative
+
+		for (int col = 0; col < cols; ++col)
+		{
+			smooth_row[col + 1] = up_row[col] + 2 * mid_row[col] + down_row[col];
+			deriv_row[col + 1] = up_row[col] - 2 * mid_row[col] + down_row[col];
+		}
+
+		smooth_row[0] = smooth_row[Reflect101(-1, cols) + 1];
+		deriv_row[0] = deriv_row[Reflect101(-1, cols) + 1];
+		smooth_row[cols + 1] = smooth_row[Reflect101(cols, cols) + 1];
+		deriv_row[cols + 1] = deriv_row[Reflect101(cols, cols) + 1];
+
+		// Horizontal parts, saturated to 8 bits before subtracting, as with cv::Sobel and cv::subtract
+
+		for (int col = 0; col < cols; ++col)
+		{
+			x_gradient_row[col] = uchar(std::clamp(smooth_row[col] - 2 * smooth_row[col + 1] + smooth_row[col + 2], 0, 255));
+			y_gradient_row[col] = uchar(std::clamp(deriv_row[col] + 2 * deriv_row[col + 1] + deriv_row[col + 2], 0, 255));
+		}
+
+		kernels.subtract_saturate(x_gradient_row.data(), y_gradient_row.data(), difference_row.data() + gauss_radius_x, size_t(cols));
+
+		for (int idx = 1; idx <= gauss_radius_x; ++idx)
+		{
+			difference_row[gauss_radius_x - idx] = difference_row[gauss_radius_x + Reflect101(-idx, cols)];
+			difference_row[gauss_radius_x + cols - 1 + idx] = difference_row[gauss_radius_x + Reflect101(cols - 1 + idx, cols)];
+		}
+
+		for (int col = 0; col < cols; ++col)
+		{
+			blurred_row[col] = Convolve(coeffs_x, difference_row.data() + col, std::make_index_sequence<Gauss_Width>{});
+		}
+
+		blurred_row_idx = row;
+		return blurred_row.data();
+	};
+
+	cv::Mat binary{ in_gray.size(), CV_8UC1 };
+
+	for (int row = 0; row < rows; ++row)
+	{
+		// Rows needed by one output row are always distinct modulo the kernel height, so none evicts another
+
+		std::array<std::uint32_t const *, Gauss_Height> src_rows;
+		for (int idx = 0; idx < Gauss_Height; ++idx)
+		{
+			src_rows[idx] = compute_blurred_row(Reflect101(row + idx - gauss_radius_y, rows));
+		}
+
+		for (int col = 0; col < cols; ++col)
+		{
+			blurred_values[col] = ConvolveRows(coeffs_y, src_rows, col, std::make_index_sequence<Gauss_Height>{});
+		}
+
+		kernels.threshold_binary(blurred_values.data(), binary.ptr<uchar>(row), size_t(cols), threshold);
+	}
+
+	MorphCloseFixed<Morph_Width, Morph_Height, Morph_Iterations>(binary, out_mask);
+}
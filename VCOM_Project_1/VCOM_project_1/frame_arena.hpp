@@ -0,0 +1,39 @@
+#ifndef FRAME_ARENA_HEADER
+#define FRAME_ARENA_HEADER
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// Monotonic memory for containers that live no longer than a frame, released all at once when the frame ends
+// Allocations are served from an initial buffer, only growing through the upstream resource if a frame outgrows it
+class FrameArena
+{
+public:
+	FrameArena(size_t in_initial_size = size_t(1) << 20)
+		: initial_buffer(in_initial_size)
+		, memory{ initial_buffer.data(), initial_buffer.size() }
+	{
+	}
+
+	FrameArena(FrameArena const &) = delete;
+	FrameArena & operator=(FrameArena const &) = delete;
+
+	std::pmr::memory_resource * Resource() noexcept
+	{
+		return &memory;
+	}
+
+	// Containers allocated from the arena must not be used after this
+	void Reset() noexcept
+	{
+		memory.release();
+	}
+
+private:
+	std::vector<std::byte> initial_buffer;
+	std::pmr::monotonic_buffer_resource memory;
+
+};
+
+#endif
@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <exception>
+
+#include <opencv2/gapi/core.hpp>
+#include <opencv2/gapi/imgproc.hpp>
+#include <opencv2/gapi/cpu/gcpukernel.hpp>
+#include <opencv2/gapi/fluid/core.hpp>
+#include <opencv2/gapi/fluid/gfluidkernel.hpp>
+#include <opencv2/gapi/fluid/imgproc.hpp>
+
+#include "barcode_detection.hpp"
+#include "graph_pipeline.hpp"
+#include "opencv_utility.hpp"
+
+namespace
+{
+	// Dilation or erosion of a binary image over each pixel and those up to the left and right offsets in its line
+	G_TYPED_KERNEL(GRowMorphology, <cv::GMat(cv::GMat, int, int, int)>, "vcom.barcode.row_morphology")
+	{
+		static cv::GMatDesc outMeta(cv::GMatDesc in_descr, int, int, int)
+		{
+			return in_descr;
+		}
+	};
+
+	// Dilation or erosion of a binary image over each pixel and the one above, the one below, or both
+	G_TYPED_KERNEL(GColumnMorphology, <cv::GMat(cv::GMat, int, int, int)>, "vcom.barcode.column_morphology")
+	{
+		static cv::GMatDesc outMeta(cv::GMatDesc in_descr, int, int, int)
+		{
+			return in_descr;
+		}
+	};
+
+	GAPI_FLUID_KERNEL(GFluidRowMorphology, GRowMorphology, false)
+	{
+		static const int Window = 1;
+
+		static void run(cv::gapi::fluid::View const & in_view, int in_left, int in_right, int in_operation, cv::gapi::fluid::Buffer & out_buffer)
+		{
+			auto const in_line = in_view.InLine<uchar>(0);
+			auto const out_line = out_buffer.OutLine<uchar>();
+			int const width = out_buffer.length();
+
+			// Pixels beyond the image are left out, as OpenCV does by default
+
+			for (int x = 0; x < width; ++x)
+			{
+				auto const first = in_line + std::max(x - in_left, 0);
+				auto const last = in_line + std::min(x + in_right, width - 1) + 1;
+
+				out_line[x] = in_operation == cv::MORPH_DILATE ? *std::max_element(first, last) : *std::min_element(first, last);
+			}
+		}
+	};
+
+	GAPI_FLUID_KERNEL(GFluidColumnMorphology, GColumnMorphology, false)
+	{
+		static const int Window = 3;
+
+		static void run(cv::gapi::fluid::View const & in_view, int in_above, int in_below, int in_operation, cv::gapi::fluid::Buffer & out_buffer)
+		{
+			auto const above_line = in_view.InLine<uchar>(in_above != 0 ? -1 : 0);
+			auto const in_line = in_view.InLine<uchar>(0);
+			auto const below_line = in_view.InLine<uchar>(in_below != 0 ? 1 : 0);
+			auto const out_line = out_buffer.OutLine<uchar>();
+			int const width = out_buffer.length();
+
+			for (int x = 0; x < width; ++x)
+			{
+				out_line[x] = in_operation == cv::MORPH_DILATE ?
+					std::max({ above_line[x], in_line[x], below_line[x] }) :
+					std::min({ above_line[x], in_line[x], below_line[x] });
+			}
+		}
+
+		// Lines beyond the image hold the value that leaves the others unchanged, as OpenCV does by default
+		static cv::gapi::fluid::Border getBorder(cv::GMatDesc const &, int, int, int in_operation)
+		{
+			return { cv::BORDER_CONSTANT, cv::Scalar(in_operation == cv::MORPH_DILATE ? 0.0 : 255.0) };
+		}
+	};
+
+	// Fluid has no kernel for Otsu's method, which needs the histogram of the whole image, so it runs between two Fluid islands
+	GAPI_OCV_KERNEL(GOCVThresholdOtsu, cv::gapi::core::GThresholdOT)
+	{
+		static void run(cv::Mat const & in_image, cv::Scalar const & in_max_value, int in_type, cv::Mat & out_image, cv::Scalar & out_threshold)
+		{
+			out_threshold = cv::Scalar(cv::threshold(in_image, out_image, 0.0, in_max_value[0], in_type));
+		}
+	};
+
+	// Dilation or erosion with a rectangular kernel and its anchor in the middle, as OpenCV does it: the rectangle is separable,
+	// and its iterations add up to a single wider one, reaching each line further away with another node
+	cv::GMat MorphologyRect(cv::GMat const & in_image, int in_operation, cv::Size const & in_size, int in_iterations)
+	{
+		int const left = in_size.width / 2 * in_iterations;
+		int const right = (in_size.width - 1 - in_size.width / 2) * in_iterations;
+		int const above = in_size.height / 2 * in_iterations;
+		int const below = (in_size.height - 1 - in_size.height / 2) * in_iterations;
+
+		cv::GMat image = left + right > 0 ? GRowMorphology::on(in_image, left, right, in_operation) : in_image;
+
+		for (int line = 0; line < std::max(above, below); ++line)
+		{
+			image = GColumnMorphology::on(image, int(line < above), int(line < below), in_operation);
+		}
+
+		return image;
+	}
+
+	cv::GComputation BuildBarcodeGraph(std::vector<double> const & in_params)
+	{
+		cv::GMat image;
+
+		// Convert to grayscale
+
+		cv::GMat gray = cv::gapi::BGR2Gray(image);
+
+		// Apply Sobel operator: second derivative in x and y with a kernel size of 3, and subtract (depths are explicit, as graph metadata does not resolve -1)
+
+		cv::GMat gradient = cv::gapi::sub(cv::gapi::Sobel(gray, CV_8U, 2, 0, 3), cv::gapi::Sobel(gray, CV_8U, 0, 2, 3), CV_8U);
+
+		// Apply Gaussian blur
+
+		cv::GMat blurred = cv::gapi::gaussianBlur(gradient, cv::Size(int(in_params[0]), int(in_params[1])), in_params[2], in_params[3]);
+
+		// Convert to binary image using a simple thresholding function with specified thresholding value, or one from Otsu's method if it is negative
+
+		cv::GMat binary = in_params[4] < 0.0 ?
+			std::get<0>(cv::gapi::threshold(blurred, cv::GScalar(cv::Scalar(255.0)), cv::THRESH_BINARY | cv::THRESH_OTSU)) :
+			cv::gapi::threshold(blurred, cv::GScalar(cv::Scalar(in_params[4])), cv::GScalar(cv::Scalar(255.0)), cv::THRESH_BINARY);
+
+		// Apply morphological operator: close operation with specified kernel and iterations, as dilations followed by as many erosions
+
+		cv::Size const kernel_size{ int(in_params[5]), int(in_params[6]) };
+
+		cv::GMat mask = MorphologyRect(MorphologyRect(binary, cv::MORPH_DILATE, kernel_size, int(in_params[7])), cv::MORPH_ERODE, kernel_size, int(in_params[7]));
+
+		return cv::GComputation(cv::GIn(image), cv::GOut(mask));
+	}
+}
+
+GraphBarcodePipeline::GraphBarcodePipeline(std::vector<double> const & in_params)
+	: computation{ BuildBarcodeGraph(in_params) }
+	, compute_count{ 0 }
+	, fallback_count{ 0 }
+{
+}
+
+bool GraphBarcodePipeline::ComputeMask(cv::Mat const & in_image, cv::Mat & out_mask)
+{
+	auto const descr = cv::descr_of(in_image);
+
+	if (std::find(std::begin(failed_descrs), std::end(failed_descrs), descr) != std::end(failed_descrs))
+	{
+		++fallback_count;
+		return false;
+	}
+
+	try
+	{
+		// Compile again only if the size or type of the image changed
+
+		if (!compiled || !(descr == compiled_descr))
+		{
+			auto const kernels = cv::gapi::combine(
+				cv::gapi::combine(cv::gapi::core::fluid::kernels(), cv::gapi::imgproc::fluid::kernels(), cv::unite_policy::KEEP),
+				cv::gapi::kernels<GFluidRowMorphology, GFluidColumnMorphology, GOCVThresholdOtsu>(),
+				cv::unite_policy::KEEP);
+
+			compiled = computation.compile(descr, cv::compile_args(kernels));
+			compiled_descr = descr;
+		}
+
+		compiled(cv::gin(in_image), cv::gout(out_mask));
+	}
+	catch (std::exception const & exception) // This may happen if the Fluid backend does not support some kernel size or border
+	{
+		compiled = cv::GCompiled{};
+		failed_descrs.push_back(descr);
+		failure_message = exception.what();
+		++fallback_count;
+		return false;
+	}
+
+	++compute_count;
+	return true;
+}
+
+PipelineBenchmark BenchmarkBarcodeMask(cv::Mat const & in_image, std::vector<double> const & in_params, int in_runs)
+{
+	PipelineBenchmark benchmark{ 0.0, -1.0, 0, {} };
+
+	GraphBarcodePipeline graph_pipeline{ in_params };
+
+	cv::Mat imperative_mask;
+	cv::Mat graph_mask;
+
+	auto const run_imperative = [&]
+	{
+		ImageSnapshot data{ in_image, 0 };
+		ComputeBarcodeMask(data, in_params, false);
+		imperative_mask = data.Image();
+	};
+
+	run_imperative();
+
+	auto start_ticks = cv::getTickCount();
+	for (int run = 0; run < in_runs; ++run)
+	{
+		run_imperative();
+	}
+	benchmark.imperative_seconds = double(cv::getTickCount() - start_ticks) / cv::getTickFrequency() / double(in_runs);
+
+	if (!graph_pipeline.ComputeMask(in_image, graph_mask))
+	{
+		benchmark.graph_failure = graph_pipeline.FailureMessage();
+		return benchmark;
+	}
+
+	start_ticks = cv::getTickCount();
+	for (int run = 0; run < in_runs; ++run)
+	{
+		graph_pipeline.ComputeMask(in_image, graph_mask);
+	}
+	auto const graph_seconds = double(cv::getTickCount() - start_ticks) / cv::getTickFrequency() / double(in_runs);
+
+	// Only report a time if every run went through the graph, and not through the imperative pipeline instead
+
+	if (graph_pipeline.FallbackCount() > 0)
+	{
+		benchmark.graph_failure = graph_pipeline.FailureMessage();
+		return benchmark;
+	}
+	benchmark.graph_seconds = graph_seconds;
+
+	benchmark.differing_pixels = cv::countNonZero(imperative_mask != graph_mask);
+
+	return benchmark;
+}
@@ -0,0 +1,64 @@
+#ifndef GRAPH_PIPELINE_HEADER
+#define GRAPH_PIPELINE_HEADER
+
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/gapi.hpp>
+
+// First step of the pipeline, from BGR image to closed binary mask, expressed as a single graph and executed by the Fluid backend,
+// which streams the image through the whole chain a few lines at a time instead of writing each intermediate image in full
+// Fluid kernels only read a fixed window of lines, and OpenCV's only close with a 3x3 kernel once, so the close is built from custom
+// kernels instead, one node per line of reach, and Otsu's method, which needs the whole image, runs on the OpenCV backend
+// The graph is built once for the parameters, and compiled again only when the size or type of the images changes
+// Sizes and types it failed for are remembered, so that the imperative pipeline is used for them right away afterwards
+class GraphBarcodePipeline
+{
+public:
+	GraphBarcodePipeline(std::vector<double> const & in_params);
+
+	// Returns false if the graph could not be compiled or executed for this image, in which case the imperative pipeline should be used
+	bool ComputeMask(cv::Mat const & in_image, cv::Mat & out_mask);
+
+	// Images the graph computed the mask of, and those it could not
+	size_t ComputeCount() const noexcept
+	{
+		return compute_count;
+	}
+
+	size_t FallbackCount() const noexcept
+	{
+		return fallback_count;
+	}
+
+	// Why the graph last failed, empty if it never did
+	std::string const & FailureMessage() const noexcept
+	{
+		return failure_message;
+	}
+
+private:
+	cv::GComputation computation;
+	cv::GCompiled compiled;
+	cv::GMatDesc compiled_descr;
+	std::vector<cv::GMatDesc> failed_descrs;
+
+	size_t compute_count;
+	size_t fallback_count;
+	std::string failure_message;
+
+};
+
+struct PipelineBenchmark
+{
+	double imperative_seconds; // Mean time of ComputeBarcodeMask
+	double graph_seconds; // Mean time of GraphBarcodePipeline, negative if it could not be used for every run
+	int differing_pixels; // Pixels where both masks differ
+	std::string graph_failure; // Why the graph could not be used, if it could not
+};
+
+// Times both first step pipelines over the specified number of runs, after a first run of each so that the graph is compiled
+PipelineBenchmark BenchmarkBarcodeMask(cv::Mat const & in_image, std::vector<double> const & in_params, int in_runs);
+
+#endif
@@ -1,14 +1,23 @@
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <optional>
 #include <vector>
-#include <atomic>
 
 #include <opencv2/opencv.hpp>
 
 #include "args_processing.hpp"
+#include "barcode_detection.hpp"
 #include "event_handling.hpp"
+#include "frame_arena.hpp"
+#include "graph_pipeline.hpp"
+#include "memory_profiling.hpp"
 #include "opencv_utility.hpp"
+#include "prefilter.hpp"
+#include "roi_tracking.hpp"
+#include "simd_kernels.hpp"
+#include "task_scheduler.hpp"
 
 //#define OUTPUT_EXECUTION_TIME
 
@@ -48,6 +57,19 @@ int main(int argc, char ** argv)
 		0.0, // Only used in debug-mode
 	};
 
+	int tile_size = 0;
+	int instruction_set = SimdLevel::Auto;
+	double prefilter_threshold = 0.0;
+	double prefilter_reject_rate = 0.0;
+	int tracking_interval = 0;
+	int adaptive_mode = 0;
+	int scanline_count = 1;
+	int subpixel_mode = 0;
+	int graph_api = 0;
+	int benchmark_runs = 0;
+	int thread_count = 0;
+	int memory_profiling = 0;
+
 	// If the 'help' option was specified, or if more than one exclusive option was specified, or if no image file was specified in non-debug mode
 	if (help || debug && version || !debug && filename.empty())
 	{
@@ -72,12 +94,60 @@ int main(int argc, char ** argv)
 		process_option(options, ProgramOptions::MKW, ProgramOptions::MKW_Ex, params[5]) &&
 		process_option(options, ProgramOptions::MKH, ProgramOptions::MKH_Ex, params[6]) &&
 		process_option(options, ProgramOptions::MNI, ProgramOptions::MNI_Ex, params[7]) &&
-		process_option(options, ProgramOptions::RMS, ProgramOptions::RMS_Ex, params[8])))
+		process_option(options, ProgramOptions::RMS, ProgramOptions::RMS_Ex, params[8]) &&
+		process_option(options, ProgramOptions::TLS, ProgramOptions::TLS_Ex, tile_size) &&
+		process_option(options, ProgramOptions::ISA, ProgramOptions::ISA_Ex, instruction_set) &&
+		process_option(options, ProgramOptions::PFT, ProgramOptions::PFT_Ex, prefilter_threshold) &&
+		process_option(options, ProgramOptions::PFR, ProgramOptions::PFR_Ex, prefilter_reject_rate) &&
+		process_option(options, ProgramOptions::TRK, ProgramOptions::TRK_Ex, tracking_interval) &&
+		process_option(options, ProgramOptions::ADP, ProgramOptions::ADP_Ex, adaptive_mode) &&
+		process_option(options, ProgramOptions::NSL, ProgramOptions::NSL_Ex, scanline_count) &&
+		process_option(options, ProgramOptions::SPX, ProgramOptions::SPX_Ex, subpixel_mode) &&
+		process_option(options, ProgramOptions::GPI, ProgramOptions::GPI_Ex, graph_api) &&
+		process_option(options, ProgramOptions::BMK, ProgramOptions::BMK_Ex, benchmark_runs) &&
+		process_option(options, ProgramOptions::THR, ProgramOptions::THR_Ex, thread_count) &&
+		process_option(options, ProgramOptions::MPR, ProgramOptions::MPR_Ex, memory_profiling)))
 	{
 		print_help();
 		return 1;
 	}
 
+	// Thresholds are computed from image statistics in adaptive mode (only in non-debug mode)
+
+	bool const adaptive = !debug && adaptive_mode != 0;
+
+	if (adaptive)
+	{
+		params[4] = -1.0;
+	}
+
+	// The graph of the first step is built once for the parameters (only in non-debug mode)
+
+	std::optional<GraphBarcodePipeline> graph_pipeline;
+
+	if (!debug && graph_api != 0)
+	{
+		graph_pipeline.emplace(params);
+	}
+
+	// Count allocations from here on, if requested (only in non-debug mode)
+
+	if (!debug && memory_profiling != 0)
+	{
+		EnableMemoryProfiling();
+	}
+
+	// Split the thread budget between the scheduler of the program and OpenCV, giving it all to the scheduler if any of its loops
+	// run in parallel (tiles, or scanlines unless sub-pixel), and all to OpenCV otherwise
+
+	bool const has_parallel_loops = tile_size > 0 || (scanline_count > 1 && subpixel_mode == 0);
+
+	ConfigureTaskScheduler(size_t(std::max(thread_count, 0)), has_parallel_loops ? 1 : 0);
+
+	// Select custom kernels for the best instruction set supported by the processor, unless a lower one was specified
+
+	SelectSimdKernels(instruction_set);
+
 	////////////////////
 	/// Load image(s)
 
@@ -117,6 +187,18 @@ int main(int argc, char ** argv)
 		return 1;
 	}
 
+	cv::VideoCapture video;
+
+	// If the file could not be read as an image, try to read it as a video (only in non-debug mode)
+	if (!debug && img_array.front().Data().empty())
+	{
+		if (!video.open(filename))
+		{
+			print_help();
+			return 1;
+		}
+	}
+
 	///////////////////////
 	/// Create window(s)
 
@@ -136,116 +218,174 @@ int main(int argc, char ** argv)
 	///////////////////////////
 	/// Execute program loop
 
-	// Wait for keyboard event (only accepts 'Escape' key while in non-debug mode)
-	while (int event = WaitEvent(debug))
-	{
-		Image img;
+	// Containers that live no longer than a frame are allocated from this arena
+	FrameArena frame_arena;
 
-		// Process keyboard event
-		ProcessEvent(debug, event, img_array, img, params); 
+	// Images with too little gradient energy are skipped before the first step (only in non-debug mode)
+	Prefilter prefilter{ debug ? 0.0 : prefilter_threshold, debug ? 0.0 : prefilter_reject_rate };
 
-		// Additional processing of debug mode only parameters
-		params[9] = double(PositiveModulo(int(params[9]), 7));
-		params[10] = double(PositiveModulo(int(params[10]), 2));
+	// Frames are first searched around the barcode of the previous frame (only in non-debug mode)
+	ROITracker tracker{ debug ? 0 : tracking_interval };
+
+	// Wait for keyboard event (only accepts 'Escape' key while in non-debug mode)
+	while (int event = WaitEvent(debug, video.isOpened()))
+	{
+		// Release memory of the previous frame
+		frame_arena.Reset();
 
 #if defined(OUTPUT_EXECUTION_TIME)
 		Stopwatch watch;
 		watch.Start();
 #endif
 
-		cv::Mat img_data = img.Data().clone();
+		BeginMemoryStage("Loading");
 
-		///////////////////////////////////////////////////
-		/// First step: Find potential barcodes in image
+		cv::Mat img_data;
 
-		ImageSnapshot src_data{ img_data, size_t(params[9]) };
-		cv::Mat dst_data;
+		if (video.isOpened())
+		{
+			// Stop once the video runs out of frames
+			if (!video.read(img_data))
+			{
+				break;
+			}
+		}
+		else
+		{
+			Image img;
 
-		std::vector<ImageROI> image_ROIs;
+			// Process keyboard event
+			ProcessEvent(debug, event, img_array, img, params);
 
-		try
-		{
-			// Convert to grayscale
+			img_data = img.Data().clone();
+		}
 
-			cv::cvtColor(src_data, dst_data, cv::COLOR_BGR2GRAY);
-			src_data = dst_data; // 1
+		// Additional processing of debug mode only parameters
+		params[9] = double(PositiveModulo(int(params[9]), 7));
+		params[10] = double(PositiveModulo(int(params[10]), 2));
 
-			// Apply Sobel operator: second derivative in x and y with a kernel size of 3
+		// Compare the usual and the graph pipelines of the first step, if requested (only in non-debug mode)
 
-			cv::Mat x_gradient;
-			cv::Mat y_gradient;
+		if (!debug && benchmark_runs > 0)
+		{
+			BeginMemoryStage("Benchmark");
 
-			cv::Sobel(src_data, x_gradient, cv::FILTER_SCHARR, 2, 0, 3);
-			cv::Sobel(src_data, y_gradient, cv::FILTER_SCHARR, 0, 2, 3);
+			auto const benchmark = BenchmarkBarcodeMask(img_data, params, benchmark_runs);
 
-			// Subtract 
-			
-			cv::subtract(x_gradient, y_gradient, dst_data);
-			src_data = dst_data; // 2
+			std::cout << "Usual pipeline: " << benchmark.imperative_seconds * 1000.0 << " ms\n";
 
-			int const gauss_kernel_width = int(debug ? params[0] * 2.0 + 1.0 : params[0]);
-			int const gauss_kernel_height = int(debug ? params[1] * 2.0 + 1.0 : params[1]);
-			double const gauss_sigma_x = debug ? params[2] * 0.1 : params[2];
-			double const gauss_sigma_y = debug ? params[3] * 0.1 : params[3];
+			if (benchmark.graph_seconds < 0.0)
+			{
+				std::cout << "Graph pipeline: not supported with the specified options (" << benchmark.graph_failure << ")\n";
+			}
+			else
+			{
+				std::cout << "Graph pipeline: " << benchmark.graph_seconds * 1000.0 << " ms (" << benchmark.differing_pixels << " pixels differ)\n";
+			}
+		}
 
-			// Apply Gaussian blur
+		///////////////////////////////////////////////////
+		/// First step: Find potential barcodes in image
 
-			cv::GaussianBlur(src_data, dst_data, cv::Size(gauss_kernel_width, gauss_kernel_height), gauss_sigma_x, gauss_sigma_y);
-			src_data = dst_data; // 3
+		BeginMemoryStage("First step");
 
-			// Convert to binary image using a simple thresholding function with specified thresholding value
+		ImageSnapshot src_data{ img_data, size_t(params[9]) };
 
-			cv::threshold(src_data, dst_data, params[4], 255.0, cv::THRESH_BINARY);
-			src_data = dst_data; // 4
+		std::pmr::vector<ImageROI> image_ROIs{ frame_arena.Resource() };
 
-			// Apply morphological operator: close operation with specified kernel and iterations
+		// Search the whole image, either right away or after the window around the tracked barcode
+		auto const find_image_ROIs = [&]
+		{
+			std::pmr::vector<ImageROI> found_ROIs{ frame_arena.Resource() };
 
-			cv::morphologyEx(src_data, dst_data, cv::MORPH_CLOSE, cv::getStructuringElement(cv::MORPH_RECT,cv::Size(int(params[5]), int(params[6]))), cv::Point(-1, -1), int(params[7]));
-			src_data = dst_data; // 5
+			// Process the image in overlapping tiles if a tile size was specified, or with the graph pipeline if it can (only in non-debug mode)
 
-			std::vector<std::vector<cv::Point>> contours;
+			if (tile_size > 0)
+			{
+				found_ROIs = FindImageROIsTiled(img_data, params, tile_size, frame_arena.Resource());
+			}
+			else if (cv::Mat mask; graph_pipeline && graph_pipeline->ComputeMask(img_data, mask))
+			{
+				src_data = mask;
+				found_ROIs = FindMaskROIs(src_data, params, debug, frame_arena.Resource());
+			}
+			else
+			{
+				found_ROIs = FindImageROIs(src_data, params, debug, frame_arena.Resource());
+			}
 
-			// Find contours using border following algorithm
+			// In adaptive mode, close the mask once more with a wider kernel before giving up (only if not tiled)
 
-			cv::findContours(src_data, contours, cv::noArray(), cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+			if (found_ROIs.empty() && adaptive && tile_size <= 0)
+			{
+				found_ROIs = FindImageROIsWidened(src_data, params, frame_arena.Resource());
+			}
 
-			// Convert back to BGR color space (interesting only for debug mode)
+			return found_ROIs;
+		};
 
-			cv::cvtColor(src_data, dst_data, cv::COLOR_GRAY2BGR);
+		// Whether the ROIs were only searched for in the window around the tracked barcode
+		bool searched_window = false;
 
-			image_ROIs.reserve(contours.size());
+		// Skip the first step altogether if the prefilter rejects the image
 
-			size_t unique_id = 0;
+		bool const prefiltered = prefilter.Enabled() && !prefilter.Accept(img_data);
 
-			for (auto const & contour : contours)
+		if (prefiltered)
+		{
+			std::cout << "Image skipped by prefilter with a score of " << prefilter.LastScore() << "! "
+				<< "(" << prefilter.SkippedCount() << " out of " << prefilter.FrameCount() << " images skipped)\n";
+		}
+		else
+		{
+			try
 			{
-				// Find bounding rectangles for the contours, and save them as ROIs
+				// Search the window around the tracked barcode first, if there is one
+
+				cv::Rect const search_window = tracker.SearchWindow(img_data.size());
 
-				if (auto rect = cv::boundingRect(contour); rect.height > params[8] && rect.width > rect.height)
+				if (!search_window.empty())
 				{
-					// Trace ROIs with rectangles (interesting only for debug mode)
+					ImageSnapshot window_data{ img_data(search_window), size_t(params[9]) };
+
+					image_ROIs = FindImageROIs(window_data, params, debug, frame_arena.Resource());
 
-					cv::rectangle(dst_data, rect, cv::Scalar(0.0, 0.0, 255.0), 3);
-					
-					image_ROIs.emplace_back(rect, unique_id++);
+					for (auto & image_ROI : image_ROIs)
+					{
+						image_ROI.region += search_window.tl();
+					}
+
+					searched_window = !image_ROIs.empty();
 				}
-			}
 
-			src_data = dst_data; // 6
-		}
-		catch (...) // This may happen if an invalid value was specified in some option
-		{
-			// We'll do a clean exit only in non-debug mode
-			if (!debug)
+				// Search the whole image if there was no window or nothing was found in it
+
+				if (image_ROIs.empty())
+				{
+					if (!search_window.empty())
+					{
+						tracker.FullSearch();
+					}
+
+					image_ROIs = find_image_ROIs();
+				}
+			}
+			catch (...) // This may happen if an invalid value was specified in some option
 			{
-				print_help();
-				return 1;
+				// We'll do a clean exit only in non-debug mode
+				if (!debug)
+				{
+					print_help();
+					return 1;
+				}
 			}
 		}
 
 		bool const detected_ROIs = !image_ROIs.empty();
 
-		if (!debug || bool(params[10]))
+		// Images skipped by the prefilter were already reported
+
+		if (!prefiltered && (!debug || bool(params[10])))
 		{
 			if (detected_ROIs)
 			{
@@ -260,88 +400,21 @@ int main(int argc, char ** argv)
 		///////////////////////////////////////////////////////
 		/// Second step: Find most likely barcode among ROIs
 
+		BeginMemoryStage("Second step");
+
+		cv::Rect barcode_rect;
 		cv::Mat barcode_region = img_data;
 
 		// If no ROI was obtained, then no barcode could be detected
 		if (detected_ROIs)
 		{
-			std::vector<ImageROI> image_ROIs_x_responses;
-			std::vector<ImageROI> image_ROIs_y_responses;
-
-			image_ROIs_x_responses.reserve(image_ROIs.size());
-			image_ROIs_y_responses.reserve(image_ROIs.size());
-
-			for (auto & ROI : image_ROIs)
-			{
-				cv::Mat img_ROI;
-
-				// Convert ROI to grayscale
-
-				cv::cvtColor(img_data(ROI.region), img_ROI, cv::COLOR_BGR2GRAY);
-
-				cv::Mat x_gradient;
-				cv::Mat y_gradient;
-
-				// Apply Sobel operator: second derivatives both in x and y with a kernel size of 3
-
-				cv::Sobel(img_ROI, x_gradient, cv::FILTER_SCHARR, 2, 0, 3);
-				cv::Sobel(img_ROI, y_gradient, cv::FILTER_SCHARR, 0, 2, 3);
-
-				// Accumulate response for each gradient
-
-				std::atomic_int x_response = 0;
-				std::atomic_int y_response = 0;
-
-				x_gradient.forEach<uchar>([&x_response](auto & elem, int const *)
-					{
-						x_response.fetch_add(elem, std::memory_order_release);
-					}
-				);
-				y_gradient.forEach<uchar>([&y_response](auto & elem, int const *)
-					{
-						y_response.fetch_add(elem, std::memory_order_release);
-					}
-				);
-
-				// Normalize and save response for each gradient
-
-				int ROI_size = ROI.region.area();
-
-				ROI.x_response = x_response.load(std::memory_order_acquire) / ROI_size;
-				ROI.y_response = y_response.load(std::memory_order_acquire) / ROI_size;
-
-				image_ROIs_x_responses.emplace_back(ROI);
-				image_ROIs_y_responses.emplace_back(ROI);
-			}
-
-			// Sort responses both in x and y, in maximizing order for x and minimizing order for y
-
-			std::sort(std::begin(image_ROIs_x_responses), std::end(image_ROIs_x_responses), [] (auto const & Elem1, auto const & Elem2) { return Elem1.x_response > Elem2.x_response; });
-			std::sort(std::begin(image_ROIs_y_responses), std::end(image_ROIs_y_responses), [] (auto const & Elem1, auto const & Elem2) { return Elem1.y_response < Elem2.y_response; });
-
-			// Search for better overall response among ROIs
-
-			auto & max_x_ROI = image_ROIs_x_responses[0];
-			auto & min_y_ROI = image_ROIs_y_responses[0];
-
-			for (size_t idx = 0; idx < image_ROIs.size(); ++idx)
-			{
-				if (max_x_ROI.idx == image_ROIs_y_responses[idx].idx) // Preference for a maximizing x response
-				{
-					barcode_region = img_data(max_x_ROI.region);
-					break;
-				}
-				if (min_y_ROI.idx == image_ROIs_x_responses[idx].idx)
-				{
-					barcode_region = img_data(min_y_ROI.region);
-					break;
-				}
-			}
+			barcode_rect = image_ROIs[FindBarcodeROI(img_data, image_ROIs, frame_arena.Resource())].region;
+			barcode_region = img_data(barcode_rect);
 		}
 
 		bool const detected_barcode = detected_ROIs;
 
-		if (!debug || bool(params[10]))
+		if (!prefiltered && (!debug || bool(params[10])))
 		{
 			if (detected_barcode)
 			{
@@ -356,102 +429,79 @@ int main(int argc, char ** argv)
 		////////////////////////////////////////////////////////////
 		/// Third step: Analyze barcode in ROI with best response
 
-		constexpr int ROI_width = 2560;
-		constexpr int ROI_height = 1440;
-		constexpr int ROI_halfline = ROI_width / 2;
-		constexpr int ROI_scanline = ROI_height / 2;
+		BeginMemoryStage("Third step");
 
 		cv::Mat scan_region = img_data;
 
-		std::vector<BarcodeSegment> barcode_segments;
+		// Row of the scan region along which the barcode is painted, which is at half-height of the region itself in subpixel mode
+		int scan_row = 0;
+
+		std::pmr::vector<BarcodeSegment> barcode_segments{ frame_arena.Resource() };
+
+		double barcode_confidence = 0.0;
 
 		if (detected_barcode)
 		{
-			// Adjust barcode region for processing
+			ScanSettings const scan_settings{ adaptive, subpixel_mode != 0, scanline_count };
 
-			// Convert region to grayscale
-
-			cv::cvtColor(barcode_region, scan_region, cv::COLOR_BGR2GRAY);
+			barcode_segments = AnalyzeBarcodeRegion(barcode_region, scan_settings, scan_region, scan_row, barcode_confidence, frame_arena.Resource());
+		}
 
-			// Resize it to 2560x1440
+		// If the region found around the tracked barcode could not be analyzed, the barcode may have moved away from it,
+		// so search the whole image for it before giving up on this frame
 
-			cv::resize(scan_region, scan_region, cv::Size(ROI_width, ROI_height), 0.0, 0.0, cv::INTER_CUBIC);
+		if (barcode_segments.empty() && searched_window)
+		{
+			if (!debug || bool(params[10]))
+			{
+				std::cout << "The region around the tracked barcode could not be analyzed! Searching the whole image...\n";
+			}
 
-			// Equalize pixel intensity
+			tracker.FullSearch();
 
-			cv::equalizeHist(scan_region, scan_region);
+			try
+			{
+				image_ROIs = find_image_ROIs();
+			}
+			catch (...) // This may happen if an invalid value was specified in some option
+			{
+				// We'll do a clean exit only in non-debug mode
+				if (!debug)
+				{
+					print_help();
+					return 1;
+				}
+			}
 
-			// Apply morphological operator: close operation with a kernel size of 8 by 8 and 1 iteration
+			if (!image_ROIs.empty())
+			{
+				barcode_rect = image_ROIs[FindBarcodeROI(img_data, image_ROIs, frame_arena.Resource())].region;
+				barcode_region = img_data(barcode_rect);
 
-			cv::morphologyEx(scan_region, scan_region, cv::MORPH_CLOSE, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(8, 8)));
+				ScanSettings const scan_settings{ adaptive, subpixel_mode != 0, scanline_count };
 
-			// Convert region to binary image using a simple thresholding function with a thresholding value of 96.0
+				barcode_segments = AnalyzeBarcodeRegion(barcode_region, scan_settings, scan_region, scan_row, barcode_confidence, frame_arena.Resource());
+			}
+		}
 
-			cv::threshold(scan_region, scan_region, 96.0, 255.0, cv::THRESH_BINARY);
+		bool const analyzed_barcode = !barcode_segments.empty();
 
-			// Iterate through region through a line at half-height, designated scanline
+		// Track the barcode into the next frame only if it could be analyzed in this one
+		tracker.Update(barcode_rect, analyzed_barcode);
 
-			size_t scan_step = 0;
+		// Calibrate the prefilter from the images it let through that turned out to contain a barcode
 
-			int longest_bar = 0;
-			int current_bar = 0;
-			int current_space = 0;
+		if (analyzed_barcode && prefilter.Calibrating())
+		{
+			prefilter.AddPositive();
 
-			for (int pixel_idx = 0; pixel_idx < ROI_width; ++pixel_idx)
+			if (!prefilter.Calibrating())
 			{
-				// Determine if pixel is likely to belong to a bar or space based on intensity
-				bool on_bar = scan_region.at<uchar>(ROI_scanline, pixel_idx) < 128;
-
-				// Determine first pixel to paint on based on whether we switched from segment (bar or space)
-				int start_paint = pixel_idx * int(on_bar != (!barcode_segments.empty() && barcode_segments.back().is_bar));
-
-				// Determine whether we should paint based on likely position along the region
-				bool should_paint = false;
-				switch (scan_step)
-				{
-				case 0: // Pre-start
-					scan_step += int(!on_bar);
-					should_paint = false;
-					break;
-				case 1: // Pre-delim bar
-					scan_step += int(on_bar);
-					should_paint = false;
-					break;
-				case 2: // First delim bar
-					scan_step += int(!on_bar);
-					should_paint = true;
-					break;
-				case 3: // Second delim bar
-					scan_step += int(on_bar);
-					should_paint = true;
-					break;
-				case 4: // On barcode
-					longest_bar = std::max(current_bar, longest_bar);
-
-					current_bar = on_bar ? current_bar + 1 : 0;
-					current_space = !on_bar ? current_space + 1 : 0;
-
-					// Rule to determine whether we should look for where to stop painting
-					scan_step += int(pixel_idx >= ROI_halfline && current_space > longest_bar * 2);
-					should_paint = true;
-					break;
-				case 5:
-				default:
-					should_paint = false;
-				}
-
-				// If it should paint and found a new segment to paint, mark it
-
-				if (should_paint && start_paint)
-				{
-					barcode_segments.emplace_back(start_paint, on_bar);
-				}
+				std::cout << "Prefilter calibrated with a threshold of " << prefilter.Threshold() << "!\n";
 			}
 		}
 
-		bool const analyzed_barcode = !barcode_segments.empty();
-
-		if (!debug || bool(params[10]))
+		if (!prefiltered && (!debug || bool(params[10])))
 		{
 			if (analyzed_barcode)
 			{
@@ -466,6 +516,8 @@ int main(int argc, char ** argv)
 		//////////////////////////////////////////////////////////////////////////////////////////////
 		/// Fourth step: Paint descriptive line in barcode region and report data about the barcode
 
+		BeginMemoryStage("Fourth step");
+
 		if (analyzed_barcode)
 		{
 			cv::cvtColor(scan_region, scan_region, cv::COLOR_GRAY2BGR);
@@ -473,12 +525,17 @@ int main(int argc, char ** argv)
 			if (!debug || bool(params[10]))
 			{
 				std::cout << std::setprecision(2) << "Barcode description:\n";
+
+				if (adaptive)
+				{
+					std::cout << "Confidence:\t" << barcode_confidence << "\n";
+				}
 			}
 
 			int const barcode_scanline = barcode_region.rows / 2;
 			float const pixel_ratio = float(barcode_region.cols) / float(scan_region.cols);
 
-			auto const barcode_length = double(barcode_segments.back().start_pixel) - double(barcode_segments.front().start_pixel);
+			auto const barcode_length = barcode_segments.back().start_position - barcode_segments.front().start_position;
 			for (size_t idx = 1; idx < barcode_segments.size(); ++idx)
 			{
 				auto const & segment_type = barcode_segments[idx - 1].is_bar;
@@ -489,17 +546,25 @@ int main(int argc, char ** argv)
 				{
 					// Report segment type and width as percentage of the whole barcode
 
-					auto const percentage = (double(segment_end) - double(segment_start)) * 100.0 / barcode_length;
-					std::cout << (segment_type ? "Bar:\t" : "Space:\t") << percentage << "%\n";
+					auto const percentage = (barcode_segments[idx].start_position - barcode_segments[idx - 1].start_position) * 100.0 / barcode_length;
+					std::cout << (segment_type ? "Bar:\t" : "Space:\t") << percentage << "%";
+
+					// Report the fraction of scanlines that agree on the segment, if there were several (the subpixel scan reads a single one)
+
+					if (scanline_count > 1 && subpixel_mode == 0)
+					{
+						std::cout << "\t(agreement: " << barcode_segments[idx - 1].agreement << ")";
+					}
+					std::cout << "\n";
 				}
 
 				// Paint segment with appropriate color depending on type
 
 				for (int pixel_idx = segment_start; pixel_idx < segment_end; ++pixel_idx)
 				{
-					auto & scan_top_pixel = scan_region.at<cv::Vec3b>(ROI_scanline - 1, pixel_idx);
-					auto & scan_mid_pixel = scan_region.at<cv::Vec3b>(ROI_scanline, pixel_idx);
-					auto & scan_bot_pixel = scan_region.at<cv::Vec3b>(ROI_scanline + 1, pixel_idx);
+					auto & scan_top_pixel = scan_region.at<cv::Vec3b>(scan_row - 1, pixel_idx);
+					auto & scan_mid_pixel = scan_region.at<cv::Vec3b>(scan_row, pixel_idx);
+					auto & scan_bot_pixel = scan_region.at<cv::Vec3b>(scan_row + 1, pixel_idx);
 
 					auto & pixel = barcode_region.at<cv::Vec3b>(barcode_scanline, int(float(pixel_idx) * pixel_ratio));
 
@@ -508,6 +573,20 @@ int main(int argc, char ** argv)
 			}
 		}
 
+		// Report allocations of each step, if profiling
+
+		if (IsMemoryProfilingEnabled())
+		{
+			std::cout << "Memory profile (allocations, KiB allocated, KiB peak):\n";
+
+			for (auto const & stage : EndMemoryImage())
+			{
+				std::cout << stage.stage_name << ":\t"
+					<< "images " << stage.mat_stats.allocation_count << ", " << stage.mat_stats.allocated_bytes / 1024 << ", " << stage.mat_stats.peak_bytes / 1024 << "\t"
+					<< "other " << stage.heap_stats.allocation_count << ", " << stage.heap_stats.allocated_bytes / 1024 << ", " << stage.heap_stats.peak_bytes / 1024 << "\n";
+			}
+		}
+
 #if defined(OUTPUT_EXECUTION_TIME)
 		auto execution_time = watch.Stop();
 		std::fstream{ "debug/execution.txt", std::ios::out | std::ios::app } << execution_time << "\n";
@@ -526,6 +605,36 @@ int main(int argc, char ** argv)
 			std::cout << "Press 'ESC' to exit." << std::endl;
 		}
 	}
+
+	// Report how busy the threads of the scheduler were, if any tasks ran on them
+
+	if (auto const counters = GetTaskScheduler()->Counters();
+		std::any_of(counters.workers.begin(), counters.workers.end(), [] (auto const & worker) { return worker.executed_tasks > 0; }))
+	{
+		std::cout << "Scheduler utilisation: " << counters.Utilisation() * 100.0 << "% of " << counters.workers.size() << " threads, "
+			<< "each running OpenCV on up to " << counters.opencv_thread_count << " threads (" << counters.ThreadBound() << " at most)\n";
+
+		for (size_t idx = 0; idx < counters.workers.size(); ++idx)
+		{
+			auto const & worker = counters.workers[idx];
+			std::cout << "Thread " << idx << ": " << worker.executed_tasks << " tasks (" << worker.stolen_tasks << " stolen), "
+				<< worker.busy_seconds * 1000.0 << " ms busy\n";
+		}
+	}
+
+	if (tracker.Enabled())
+	{
+		std::cout << "Frames searched around the tracked barcode: " << tracker.WindowSearchCount() << "\n"
+			<< "Frames searched in their whole: " << tracker.FullSearchCount() << std::endl;
+	}
+
+	// Report how many images the graph pipeline could not process, which went through the usual one instead
+
+	if (graph_pipeline && graph_pipeline->FallbackCount() > 0)
+	{
+		std::cout << "Images processed by the graph pipeline: " << graph_pipeline->ComputeCount() << "\n"
+			<< "Images processed by the usual pipeline instead: " << graph_pipeline->FallbackCount() << " (" << graph_pipeline->FailureMessage() << ")" << std::endl;
+	}
 	
 	return 0;
 }
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+
+#include <opencv2/opencv.hpp>
+
+#include "memory_profiling.hpp"
+
+namespace
+{
+	struct AllocationCounters
+	{
+		std::atomic<std::int64_t> held_bytes = 0; // Never reset, so that peaks account for memory held across stages
+
+		std::atomic<std::uint64_t> allocation_count = 0;
+		std::atomic<std::uint64_t> allocated_bytes = 0;
+		std::atomic<std::int64_t> peak_bytes = 0;
+	};
+
+	std::atomic_bool is_profiling = false;
+
+	AllocationCounters mat_counters;
+	AllocationCounters heap_counters;
+
+	// Stages are only opened and closed by the main thread, between steps
+	char const * current_stage = nullptr;
+	std::array<StageMemoryStats, 16> closed_stages;
+	size_t closed_stage_count = 0;
+
+	void RecordAllocation(AllocationCounters & io_counters, std::uint64_t in_bytes) noexcept
+	{
+		auto const held_bytes = io_counters.held_bytes.fetch_add(std::int64_t(in_bytes), std::memory_order_relaxed) + std::int64_t(in_bytes);
+
+		io_counters.allocation_count.fetch_add(1, std::memory_order_relaxed);
+		io_counters.allocated_bytes.fetch_add(in_bytes, std::memory_order_relaxed);
+
+		auto peak_bytes = io_counters.peak_bytes.load(std::memory_order_relaxed);
+		while (held_bytes > peak_bytes && !io_counters.peak_bytes.compare_exchange_weak(peak_bytes, held_bytes, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	void RecordDeallocation(AllocationCounters & io_counters, std::uint64_t in_bytes) noexcept
+	{
+		io_counters.held_bytes.fetch_sub(std::int64_t(in_bytes), std::memory_order_relaxed);
+	}
+
+	AllocationStats ResetCounters(AllocationCounters & io_counters) noexcept
+	{
+		AllocationStats const stats{
+			io_counters.allocation_count.exchange(0, std::memory_order_relaxed),
+			io_counters.allocated_bytes.exchange(0, std::memory_order_relaxed),
+			std::uint64_t(std::max(io_counters.peak_bytes.exchange(std::max(io_counters.held_bytes.load(std::memory_order_relaxed), std::int64_t(0)), std::memory_order_relaxed), std::int64_t(0)))
+		};
+		return stats;
+	}
+
+	void CloseStage() noexcept
+	{
+		if (current_stage && closed_stage_count < closed_stages.size())
+		{
+			closed_stages[closed_stage_count++] = { current_stage, ResetCounters(mat_counters), ResetCounters(heap_counters) };
+		}
+		current_stage = nullptr;
+	}
+
+	// Forwards to the default allocator, and takes over the deallocation of what it allocates so that it is counted as well
+	class ProfilingMatAllocator : public cv::MatAllocator
+	{
+	public:
+		ProfilingMatAllocator(cv::MatAllocator * in_allocator)
+			: allocator{ in_allocator }
+		{
+		}
+
+		cv::UMatData * allocate(int dims, int const * sizes, int type, void * data, size_t * step, int flags, cv::UMatUsageFlags usage_flags) const override
+		{
+			cv::UMatData * mat_data = allocator->allocate(dims, sizes, type, data, step, flags, usage_flags);
+
+			if (mat_data)
+			{
+				mat_data->currAllocator = this;
+
+				if (!(mat_data->flags & cv::UMatData::USER_ALLOCATED))
+				{
+					RecordAllocation(mat_counters, std::uint64_t(mat_data->size));
+				}
+			}
+
+			return mat_data;
+		}
+		bool allocate(cv::UMatData * data, int access_flags, cv::UMatUsageFlags usage_flags) const override
+		{
+			return allocator->allocate(data, access_flags, usage_flags);
+		}
+		void deallocate(cv::UMatData * data) const override
+		{
+			if (data && !(data->flags & cv::UMatData::USER_ALLOCATED))
+			{
+				RecordDeallocation(mat_counters, std::uint64_t(data->size));
+			}
+
+			allocator->deallocate(data);
+		}
+
+	private:
+		cv::MatAllocator * const allocator;
+
+	};
+}
+
+// Replacements of the global operator new and delete, through which every other form of them goes by default
+// Sizes are taken from the allocation itself, so that memory allocated by OpenCV and freed by the program remains valid
+
+void * operator new(std::size_t in_size)
+{
+	void * ptr = nullptr;
+
+	while (!(ptr = std::malloc(in_size ? in_size : 1)))
+	{
+		if (auto const handler = std::get_new_handler())
+		{
+			handler();
+		}
+		else
+		{
+			throw std::bad_alloc{};
+		}
+	}
+
+	if (is_profiling.load(std::memory_order_relaxed))
+	{
+		RecordAllocation(heap_counters, std::uint64_t(_msize(ptr)));
+	}
+
+	return ptr;
+}
+
+void operator delete(void * in_ptr) noexcept
+{
+	if (in_ptr && is_profiling.load(std::memory_order_relaxed))
+	{
+		RecordDeallocation(heap_counters, std::uint64_t(_msize(in_ptr)));
+	}
+
+	std::free(in_ptr);
+}
+
+void operator delete(void * in_ptr, std::size_t) noexcept
+{
+	operator delete(in_ptr);
+}
+
+void EnableMemoryProfiling()
+{
+	static ProfilingMatAllocator mat_allocator{ cv::Mat::getStdAllocator() };
+
+	cv::Mat::setDefaultAllocator(&mat_allocator);
+	is_profiling.store(true);
+}
+
+bool IsMemoryProfilingEnabled() noexcept
+{
+	return is_profiling.load(std::memory_order_relaxed);
+}
+
+void BeginMemoryStage(char const * in_stage_name) noexcept
+{
+	if (!IsMemoryProfilingEnabled())
+	{
+		return;
+	}
+
+	CloseStage();
+
+	// Allocations made while no stage was open are dropped
+
+	ResetCounters(mat_counters);
+	ResetCounters(heap_counters);
+
+	current_stage = in_stage_name;
+}
+
+std::vector<StageMemoryStats> EndMemoryImage()
+{
+	CloseStage();
+
+	std::vector<StageMemoryStats> stages(closed_stages.begin(), closed_stages.begin() + closed_stage_count);
+	closed_stage_count = 0;
+
+	return stages;
+}
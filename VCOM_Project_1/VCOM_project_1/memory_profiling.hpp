@@ -0,0 +1,32 @@
+#ifndef MEMORY_PROFILING_HEADER
+#define MEMORY_PROFILING_HEADER
+
+#include <cstdint>
+#include <vector>
+
+struct AllocationStats
+{
+	std::uint64_t allocation_count;
+	std::uint64_t allocated_bytes;
+	std::uint64_t peak_bytes; // Highest amount of memory held at once during the stage, including what earlier stages still held
+};
+
+struct StageMemoryStats
+{
+	char const * stage_name;
+
+	AllocationStats mat_stats; // Pixel buffers of cv::Mat
+	AllocationStats heap_stats; // Everything else allocated by the program through operator new
+};
+
+// Starts counting allocations of cv::Mat, through an allocator wrapping the default one, and allocations through the global operator new
+// Heap memory freed by the program but allocated elsewhere (by OpenCV itself, or before profiling started) is uncounted, so heap peaks are approximate
+void EnableMemoryProfiling();
+bool IsMemoryProfilingEnabled() noexcept;
+
+// Closes the current stage of the image, if any, and opens the specified one (does nothing unless profiling)
+void BeginMemoryStage(char const * in_stage_name) noexcept;
+// Closes the current stage and returns the statistics of every stage since the last call
+std::vector<StageMemoryStats> EndMemoryImage();
+
+#endif
@@ -112,15 +112,20 @@ struct ImageROI
 
 struct BarcodeSegment
 {
-	BarcodeSegment(int const & in_start_pixel, bool in_is_bar)
+	BarcodeSegment(int const & in_start_pixel, bool in_is_bar, double in_agreement = 1.0)
 		: start_pixel{ in_start_pixel }
+		, start_position{ double(in_start_pixel) }
 		, is_bar{ in_is_bar }
+		, agreement{ in_agreement }
 	{
 	}
 
 	int start_pixel;
+	double start_position; // Same as the start pixel, unless refined to sub-pixel precision
 	bool is_bar;
 
+	double agreement; // Fraction of scanlines that found this segment
+
 };
 
 class NamedWindow
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "prefilter.hpp"
+
+double ComputeGradientEnergyScore(cv::Mat const & in_image, int in_cell_size, int in_row_step)
+{
+	CV_Assert(in_image.depth() == CV_8U && in_cell_size > 0 && in_row_step > 0);
+
+	if (in_image.rows < 2 || in_image.cols < 2)
+	{
+		return 0.0;
+	}
+
+	// The green channel stands in for luminance, avoiding a grayscale conversion of the whole image
+
+	int const channels = in_image.channels();
+	int const channel = channels == 1 ? 0 : 1;
+
+	int const grid_cols = (in_image.cols + in_cell_size - 1) / in_cell_size;
+	int const grid_rows = (in_image.rows + in_cell_size - 1) / in_cell_size;
+
+	std::vector<long long> cell_energies(size_t(grid_cols) * grid_rows);
+	std::vector<int> cell_samples(size_t(grid_cols) * grid_rows);
+
+	// Accumulate, on every sampled row, how much the horizontal gradient exceeds the vertical one, which is high across vertical bars
+
+	for (int row = 0; row + 1 < in_image.rows; row += in_row_step)
+	{
+		uchar const * current_row = in_image.ptr<uchar>(row) + channel;
+		uchar const * next_row = in_image.ptr<uchar>(row + 1) + channel;
+
+		size_t const grid_row_offset = size_t(row / in_cell_size) * grid_cols;
+
+		for (int col = 0; col + 1 < in_image.cols; ++col)
+		{
+			int const x_energy = std::abs(int(current_row[(col + 1) * channels]) - int(current_row[col * channels]));
+			int const y_energy = std::abs(int(next_row[col * channels]) - int(current_row[col * channels]));
+
+			cell_energies[grid_row_offset + col / in_cell_size] += x_energy - y_energy;
+		}
+
+		for (int grid_col = 0; grid_col < grid_cols; ++grid_col)
+		{
+			cell_samples[grid_row_offset + grid_col] += std::min(in_cell_size, in_image.cols - 1 - grid_col * in_cell_size);
+		}
+	}
+
+	// Barcodes are wider than they are tall, so cells are scored in runs of three along each row of the grid
+
+	double score = 0.0;
+
+	for (int grid_row = 0; grid_row < grid_rows; ++grid_row)
+	{
+		for (int grid_col = 0; grid_col < grid_cols; ++grid_col)
+		{
+			long long energy = 0;
+			long long samples = 0;
+
+			for (int idx = std::max(grid_col - 1, 0); idx <= std::min(grid_col + 1, grid_cols - 1); ++idx)
+			{
+				energy += cell_energies[size_t(grid_row) * grid_cols + idx];
+				samples += cell_samples[size_t(grid_row) * grid_cols + idx];
+			}
+
+			if (samples > 0)
+			{
+				score = std::max(double(energy) / double(samples), score);
+			}
+		}
+	}
+
+	return score;
+}
+
+void Prefilter::AddPositive()
+{
+	if (!Calibrating())
+	{
+		return;
+	}
+
+	calibration_scores.push_back(last_score);
+
+	// Images scoring below the threshold are skipped, so it is set at the score with the rate of the calibration scores below it
+
+	if (calibration_scores.size() == calibration_size)
+	{
+		std::sort(std::begin(calibration_scores), std::end(calibration_scores));
+
+		auto const rank = std::min(size_t(std::min(reject_rate, 1.0) * double(calibration_size)), calibration_size - 1);
+
+		threshold = calibration_scores[rank];
+	}
+}
@@ -0,0 +1,86 @@
+#ifndef PREFILTER_HEADER
+#define PREFILTER_HEADER
+
+#include <atomic>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// Barcode likelihood of an image, from gradient energy on a coarse grid of cells, measured on a subset of rows
+// Each cell scores the mean excess of horizontal over vertical gradient energy, and the image scores its best run of three cells in a row
+double ComputeGradientEnergyScore(cv::Mat const & in_image, int in_cell_size = 32, int in_row_step = 8);
+
+// Front stage of the detector cascade, rejecting images unlikely to contain a barcode before the full pipeline runs
+// Raising the threshold skips more empty images, at the cost of more images with barcodes being rejected as well,
+// so it should be set at the desired false-reject quantile of the scores of images known to contain barcodes
+// Given a false-reject rate instead, the threshold is calibrated to that quantile from the first images found to contain barcodes,
+// which are all accepted, and then kept fixed, since later images with barcodes below it would never be found
+class Prefilter
+{
+public:
+	static constexpr size_t calibration_size = 32;
+
+	Prefilter(double in_threshold, double in_reject_rate = 0.0)
+		: threshold{ in_reject_rate > 0.0 ? 0.0 : in_threshold }
+		, reject_rate{ in_reject_rate }
+		, last_score{ 0.0 }
+		, frame_count{ 0 }
+		, skipped_count{ 0 }
+	{
+	}
+
+	bool Enabled() const noexcept
+	{
+		return threshold > 0.0 || reject_rate > 0.0;
+	}
+	bool Calibrating() const noexcept
+	{
+		return reject_rate > 0.0 && calibration_scores.size() < calibration_size;
+	}
+
+	// Returns whether the image should go through the full pipeline
+	bool Accept(cv::Mat const & in_image)
+	{
+		last_score = ComputeGradientEnergyScore(in_image);
+
+		bool const accepted = Calibrating() || last_score >= threshold;
+
+		frame_count.fetch_add(1, std::memory_order_relaxed);
+		skipped_count.fetch_add(size_t(!accepted), std::memory_order_relaxed);
+
+		return accepted;
+	}
+
+	// Records that the last accepted image contained a barcode, setting the threshold once enough of them were recorded, if calibrating
+	void AddPositive();
+
+	double Threshold() const noexcept
+	{
+		return threshold;
+	}
+	double LastScore() const noexcept
+	{
+		return last_score;
+	}
+	size_t FrameCount() const noexcept
+	{
+		return frame_count.load(std::memory_order_relaxed);
+	}
+	size_t SkippedCount() const noexcept
+	{
+		return skipped_count.load(std::memory_order_relaxed);
+	}
+
+private:
+	double threshold;
+	double const reject_rate;
+	double last_score;
+
+	std::vector<double> calibration_scores;
+
+	std::atomic_size_t frame_count;
+	std::atomic_size_t skipped_count;
+
+};
+
+#endif
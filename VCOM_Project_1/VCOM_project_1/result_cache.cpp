@@ -0,0 +1,416 @@
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#include "result_cache.hpp"
+
+namespace
+{
+	constexpr char cache_magic[8] = { 'V', 'C', 'O', 'M', 'R', 'E', 'S', 'C' };
+	constexpr std::uint32_t cache_version = 1;
+
+	// Counts beyond these only come from corrupted files, and are not allocated
+	constexpr std::uint64_t max_ROI_count = 1 << 20;
+	constexpr std::uint64_t max_segment_count = 1 << 20;
+
+	constexpr std::uint64_t prime_1 = 0x9E3779B185EBCA87ull;
+	constexpr std::uint64_t prime_2 = 0xC2B2AE3D27D4EB4Full;
+	constexpr std::uint64_t prime_3 = 0x165667B19E3779F9ull;
+	constexpr std::uint64_t prime_4 = 0x85EBCA77C2B2AE63ull;
+	constexpr std::uint64_t prime_5 = 0x27D4EB2F165667C5ull;
+
+	std::uint64_t RotateLeft(std::uint64_t in_value, int in_bits) noexcept
+	{
+		return (in_value << in_bits) | (in_value >> (64 - in_bits));
+	}
+
+	// Little-endian, as on every platform the program is built for
+	template <typename T>
+	T ReadLittleEndian(unsigned char const * in_bytes) noexcept
+	{
+		T value;
+		std::memcpy(&value, in_bytes, sizeof(value));
+		return value;
+	}
+
+	std::uint64_t HashRound(std::uint64_t in_accumulator, std::uint64_t in_input) noexcept
+	{
+		return RotateLeft(in_accumulator + in_input * prime_2, 31) * prime_1;
+	}
+
+	std::uint64_t HashMerge(std::uint64_t in_accumulator, std::uint64_t in_lane) noexcept
+	{
+		return (in_accumulator ^ HashRound(0, in_lane)) * prime_1 + prime_4;
+	}
+
+	template <typename T>
+	void WriteValue(std::ostream & io_stream, T const & in_value)
+	{
+		io_stream.write(reinterpret_cast<char const *>(&in_value), sizeof(in_value));
+	}
+
+	template <typename T>
+	bool ReadValue(std::istream & io_stream, T & out_value)
+	{
+		return bool(io_stream.read(reinterpret_cast<char *>(&out_value), sizeof(out_value)));
+	}
+
+	// Approximately the memory held by an entry, along with its node in the index
+	size_t EntrySize(BarcodeDetection const & in_detection) noexcept
+	{
+		return 2 * sizeof(ResultKey) + sizeof(BarcodeDetection) + 6 * sizeof(void *) + in_detection.ROIs.size() * sizeof(ImageROI)
+			+ in_detection.segments.size() * sizeof(BarcodeSegment);
+	}
+}
+
+std::uint64_t HashBytes(void const * in_data, size_t in_size, std::uint64_t in_seed) noexcept
+{
+	auto bytes = static_cast<unsigned char const *>(in_data);
+	auto const end = bytes + in_size;
+
+	std::uint64_t hash;
+
+	// Four lanes of 8 bytes are accumulated independently, so that their multiplications overlap
+
+	if (in_size >= 32)
+	{
+		std::uint64_t lanes[4] = { in_seed + prime_1 + prime_2, in_seed + prime_2, in_seed, in_seed - prime_1 };
+
+		for (; end - bytes >= 32; bytes += 32)
+		{
+			for (size_t lane = 0; lane < 4; ++lane)
+			{
+				lanes[lane] = HashRound(lanes[lane], ReadLittleEndian<std::uint64_t>(bytes + lane * 8));
+			}
+		}
+
+		hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+
+		for (auto const lane : lanes)
+		{
+			hash = HashMerge(hash, lane);
+		}
+	}
+	else
+	{
+		hash = in_seed + prime_5;
+	}
+
+	hash += std::uint64_t(in_size);
+
+	// The remaining bytes, 8, 4, then 1 at a time
+
+	for (; end - bytes >= 8; bytes += 8)
+	{
+		hash = RotateLeft(hash ^ HashRound(0, ReadLittleEndian<std::uint64_t>(bytes)), 27) * prime_1 + prime_4;
+	}
+	if (end - bytes >= 4)
+	{
+		hash = RotateLeft(hash ^ (std::uint64_t(ReadLittleEndian<std::uint32_t>(bytes)) * prime_1), 23) * prime_2 + prime_3;
+		bytes += 4;
+	}
+	for (; bytes < end; ++bytes)
+	{
+		hash = RotateLeft(hash ^ (std::uint64_t(*bytes) * prime_5), 11) * prime_1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= prime_2;
+	hash ^= hash >> 29;
+	hash *= prime_3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+ResultKey MakeResultKey(void const * in_encoded, size_t in_size, std::vector<double> const & in_params, ScanSettings const & in_settings)
+{
+	// The binary threshold value is overridden in adaptive mode, so results do not depend on the one specified
+
+	std::vector<double> settings = in_params;
+
+	if (in_settings.is_adaptive && settings.size() > 4)
+	{
+		settings[4] = -1.0;
+	}
+
+	settings.push_back(double(in_settings.is_adaptive));
+	settings.push_back(double(in_settings.is_subpixel));
+	settings.push_back(double(in_settings.scanline_count));
+
+	return { HashBytes(in_encoded, in_size), std::uint64_t(in_size), HashBytes(settings.data(), settings.size() * sizeof(double)) };
+}
+
+ResultCache::ResultCache(fs::path const & in_path, size_t in_capacity)
+	: path{ in_path }
+	, capacity{ in_capacity }
+	, size{ 0 }
+	, hits{ 0 }
+	, misses{ 0 }
+	, evictions{ 0 }
+{
+	Load();
+
+	// Entries evicted while loading were never used in this run
+	evictions = 0;
+}
+
+ResultCache::~ResultCache()
+{
+	Save();
+}
+
+bool ResultCache::Find(ResultKey const & in_key, BarcodeDetection & out_detection)
+{
+	std::lock_guard<std::mutex> lock{ mutex };
+
+	auto const it = index.find(in_key);
+	if (it == index.end())
+	{
+		++misses;
+		return false;
+	}
+
+	++hits;
+
+	entries.splice(entries.begin(), entries, it->second);
+	out_detection = it->second->detection;
+
+	return true;
+}
+
+void ResultCache::Insert(ResultKey const & in_key, BarcodeDetection const & in_detection)
+{
+	std::lock_guard<std::mutex> lock{ mutex };
+
+	Add(in_key, in_detection);
+}
+
+bool ResultCache::Save() const
+{
+	std::lock_guard<std::mutex> lock{ mutex };
+
+	auto temporary_path = path;
+	temporary_path += ".tmp";
+
+	{
+		std::ofstream file{ temporary_path, std::ios::binary | std::ios::trunc };
+		if (!file)
+		{
+			return false;
+		}
+
+		file.write(cache_magic, sizeof(cache_magic));
+		WriteValue(file, cache_version);
+		WriteValue(file, std::uint64_t(entries.size()));
+
+		// Least recently used first, so that loading adds them back in the same order
+
+		for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+		{
+			auto const & detection = it->detection;
+
+			WriteValue(file, it->key.content_hash);
+			WriteValue(file, it->key.content_size);
+			WriteValue(file, it->key.settings_hash);
+
+			WriteValue(file, std::int32_t(detection.barcode_idx));
+			WriteValue(file, detection.pixel_ratio);
+			WriteValue(file, detection.confidence);
+
+			WriteValue(file, std::uint64_t(detection.ROIs.size()));
+			for (auto const & ROI : detection.ROIs)
+			{
+				WriteValue(file, std::int32_t(ROI.region.x));
+				WriteValue(file, std::int32_t(ROI.region.y));
+				WriteValue(file, std::int32_t(ROI.region.width));
+				WriteValue(file, std::int32_t(ROI.region.height));
+				WriteValue(file, std::uint64_t(ROI.idx));
+				WriteValue(file, std::int32_t(ROI.x_response));
+				WriteValue(file, std::int32_t(ROI.y_response));
+			}
+
+			WriteValue(file, std::uint64_t(detection.segments.size()));
+			for (auto const & segment : detection.segments)
+			{
+				WriteValue(file, std::int32_t(segment.start_pixel));
+				WriteValue(file, segment.start_position);
+				WriteValue(file, std::uint8_t(segment.is_bar));
+				WriteValue(file, segment.agreement);
+			}
+		}
+
+		if (!file.flush())
+		{
+			return false;
+		}
+	}
+
+	// The cache file is only ever replaced by a complete one
+
+	std::error_code error;
+	fs::rename(temporary_path, path, error);
+
+	return !error;
+}
+
+ResultCacheCounters ResultCache::Counters() const
+{
+	std::lock_guard<std::mutex> lock{ mutex };
+
+	return { hits, misses, evictions, entries.size(), size };
+}
+
+void ResultCache::Load()
+{
+	std::ifstream file{ path, std::ios::binary };
+	if (!file)
+	{
+		return;
+	}
+
+	char magic[sizeof(cache_magic)];
+	std::uint32_t version = 0;
+	std::uint64_t entry_count = 0;
+
+	if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, cache_magic, sizeof(magic)) != 0 || !ReadValue(file, version) || version != cache_version
+		|| !ReadValue(file, entry_count))
+	{
+		return;
+	}
+
+	// Entries read up to a truncated or corrupted one are kept
+
+	for (std::uint64_t entry_idx = 0; entry_idx < entry_count; ++entry_idx)
+	{
+		ResultKey key;
+		BarcodeDetection detection;
+		std::int32_t barcode_idx = -1;
+		std::uint64_t ROI_count = 0;
+
+		if (!ReadValue(file, key.content_hash) || !ReadValue(file, key.content_size) || !ReadValue(file, key.settings_hash)
+			|| !ReadValue(file, barcode_idx) || !ReadValue(file, detection.pixel_ratio) || !ReadValue(file, detection.confidence)
+			|| !ReadValue(file, ROI_count) || ROI_count > max_ROI_count)
+		{
+			return;
+		}
+
+		detection.barcode_idx = barcode_idx;
+		detection.ROIs.reserve(size_t(ROI_count));
+
+		for (std::uint64_t ROI_idx = 0; ROI_idx < ROI_count; ++ROI_idx)
+		{
+			std::int32_t rect[4];
+			std::uint64_t idx = 0;
+			std::int32_t responses[2];
+
+			if (!ReadValue(file, rect) || !ReadValue(file, idx) || !ReadValue(file, responses))
+			{
+				return;
+			}
+
+			auto & ROI = detection.ROIs.emplace_back(cv::Rect{ rect[0], rect[1], rect[2], rect[3] }, size_t(idx));
+			ROI.x_response = responses[0];
+			ROI.y_response = responses[1];
+		}
+
+		std::uint64_t segment_count = 0;
+
+		if (!ReadValue(file, segment_count) || segment_count > max_segment_count || (barcode_idx >= 0 ? size_t(barcode_idx) >= ROI_count : barcode_idx != -1))
+		{
+			return;
+		}
+
+		detection.segments.reserve(size_t(segment_count));
+
+		for (std::uint64_t segment_idx = 0; segment_idx < segment_count; ++segment_idx)
+		{
+			std::int32_t start_pixel = 0;
+			double start_position = 0.0;
+			std::uint8_t is_bar = 0;
+			double agreement = 0.0;
+
+			if (!ReadValue(file, start_pixel) || !ReadValue(file, start_position) || !ReadValue(file, is_bar) || !ReadValue(file, agreement))
+			{
+				return;
+			}
+
+			auto & segment = detection.segments.emplace_back(start_pixel, is_bar != 0, agreement);
+			segment.start_position = start_position;
+		}
+
+		Add(key, detection);
+	}
+}
+
+void ResultCache::Add(ResultKey const & in_key, BarcodeDetection const & in_detection)
+{
+	auto const entry_size = EntrySize(in_detection);
+
+	if (auto const it = index.find(in_key); it != index.end())
+	{
+		size -= it->second->size;
+		entries.erase(it->second);
+		index.erase(it);
+	}
+
+	// An entry larger than the whole cache would only evict everything else
+	if (entry_size > capacity)
+	{
+		return;
+	}
+
+	while (size + entry_size > capacity)
+	{
+		size -= entries.back().size;
+		index.erase(entries.back().key);
+		entries.pop_back();
+
+		++evictions;
+	}
+
+	entries.push_front({ in_key, in_detection, entry_size });
+	index.emplace(in_key, entries.begin());
+
+	size += entry_size;
+}
+
+BarcodeDetection DetectBarcodeEncoded(void const * in_encoded, size_t in_size, std::vector<double> const & in_params, ScanSettings const & in_settings,
+	ResultCache * io_cache)
+{
+	BarcodeDetection detection;
+	ResultKey key{};
+
+	if (io_cache)
+	{
+		key = MakeResultKey(in_encoded, in_size, in_params, in_settings);
+
+		if (io_cache->Find(key, detection))
+		{
+			return detection;
+		}
+	}
+
+	cv::Mat image;
+
+	if (in_size > 0 && in_size <= size_t(std::numeric_limits<int>::max()))
+	{
+		image = cv::imdecode(cv::Mat(1, int(in_size), CV_8UC1, const_cast<void *>(in_encoded)), cv::IMREAD_COLOR);
+	}
+
+	if (image.empty())
+	{
+		throw std::runtime_error("Image could not be decoded!");
+	}
+
+	detection = DetectBarcode(image, in_params, in_settings);
+
+	if (io_cache)
+	{
+		io_cache->Insert(key, detection);
+	}
+
+	return detection;
+}
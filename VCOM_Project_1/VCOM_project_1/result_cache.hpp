@@ -0,0 +1,107 @@
+#ifndef RESULT_CACHE_HEADER
+#define RESULT_CACHE_HEADER
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "barcode_detection.hpp"
+#include "opencv_utility.hpp"
+
+// Identity of a detection: the encoded bytes of the image file, and the effective parameters and settings it was detected with
+struct ResultKey
+{
+	std::uint64_t content_hash;
+	std::uint64_t content_size;
+	std::uint64_t settings_hash;
+
+	bool operator==(ResultKey const & in_other) const noexcept
+	{
+		return content_hash == in_other.content_hash && content_size == in_other.content_size && settings_hash == in_other.settings_hash;
+	}
+};
+
+struct ResultKeyHash
+{
+	size_t operator()(ResultKey const & in_key) const noexcept
+	{
+		return size_t(in_key.content_hash ^ (in_key.settings_hash * 0x9E3779B97F4A7C15ull) ^ in_key.content_size);
+	}
+};
+
+struct ResultCacheCounters
+{
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+	size_t entry_count;
+	size_t size; // In bytes, of the entries held
+};
+
+// 64-bit hash of the bytes, the same as XXH64, which runs at memory speed on encoded image files
+std::uint64_t HashBytes(void const * in_data, size_t in_size, std::uint64_t in_seed = 0) noexcept;
+
+// Key of the detection of an encoded image file, with the parameters as DetectBarcode effectively uses them for the settings
+ResultKey MakeResultKey(void const * in_encoded, size_t in_size, std::vector<double> const & in_params, ScanSettings const & in_settings);
+
+// Results of detections by the bytes of their image files, so that files sent again are not decoded nor detected again
+// Bounded by the size of the entries it holds, evicting the least recently used first, and persisted to a file between runs
+// All members may be called concurrently
+class ResultCache
+{
+public:
+	// Loads the entries persisted at the path, if any, starting empty if the file is missing or not a valid cache,
+	// and keeping at most the specified number of bytes of entries
+	ResultCache(fs::path const & in_path, size_t in_capacity);
+	// Persists the entries
+	~ResultCache();
+
+	ResultCache(ResultCache const &) = delete;
+	ResultCache & operator=(ResultCache const &) = delete;
+
+	// Copies the detection of the key and marks it most recently used, counting a hit, or counts a miss
+	bool Find(ResultKey const & in_key, BarcodeDetection & out_detection);
+	// Adds (or replaces) the detection of the key as most recently used, evicting the least recently used entries beyond the capacity
+	void Insert(ResultKey const & in_key, BarcodeDetection const & in_detection);
+
+	// Writes the entries to a temporary file replacing the cache file once complete, returning false on failure
+	bool Save() const;
+
+	ResultCacheCounters Counters() const;
+
+private:
+	struct Entry
+	{
+		ResultKey key;
+		BarcodeDetection detection;
+		size_t size;
+	};
+
+	void Load();
+	void Add(ResultKey const & in_key, BarcodeDetection const & in_detection);
+
+	fs::path path;
+	size_t capacity;
+
+	mutable std::mutex mutex;
+	// Most recently used first, the index pointing into it since list iterators survive splicing
+	std::list<Entry> entries;
+	std::unordered_map<ResultKey, std::list<Entry>::iterator, ResultKeyHash> index;
+
+	size_t size;
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+
+};
+
+// Detects the barcode in an encoded image file as DetectBarcode does, only decoding it if the cache (if any) has no result for its bytes
+// and the settings yet, in which case the result is added to it
+// Throws std::runtime_error if the image has to be decoded and cannot be
+BarcodeDetection DetectBarcodeEncoded(void const * in_encoded, size_t in_size, std::vector<double> const & in_params, ScanSettings const & in_settings,
+	ResultCache * io_cache);
+
+#endif
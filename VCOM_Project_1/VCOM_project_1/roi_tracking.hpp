@@ -0,0 +1,92 @@
+#ifndef ROI_TRACKING_HEADER
+#define ROI_TRACKING_HEADER
+
+#include <opencv2/opencv.hpp>
+
+// Carries the barcode region of a frame forward, so that the next frame is first searched in a padded window around it
+// A full search is done when no region is tracked, when the tracked region could not be analyzed, or every so many frames,
+// and also for the same frame when its window yields no region, or none that can be analyzed
+class ROITracker
+{
+public:
+	ROITracker(int in_full_search_interval, double in_padding_ratio = 0.5)
+		: full_search_interval{ in_full_search_interval }
+		, padding_ratio{ in_padding_ratio }
+		, frames_since_full_search{ 0 }
+		, tracked_region{}
+		, window_search_count{ 0 }
+		, full_search_count{ 0 }
+	{
+	}
+
+	bool Enabled() const noexcept
+	{
+		return full_search_interval > 0;
+	}
+
+	// Window of the frame to search first, or an empty rectangle if the whole frame must be searched
+	cv::Rect SearchWindow(cv::Size const & in_frame_size)
+	{
+		if (!Enabled() || tracked_region.empty() || frames_since_full_search >= full_search_interval)
+		{
+			return FullSearch();
+		}
+
+		auto const padding_x = int(double(tracked_region.width) * padding_ratio);
+		auto const padding_y = int(double(tracked_region.height) * padding_ratio);
+
+		auto const window = cv::Rect{
+			tracked_region.x - padding_x,
+			tracked_region.y - padding_y,
+			tracked_region.width + 2 * padding_x,
+			tracked_region.height + 2 * padding_y
+		} & cv::Rect{ cv::Point{ 0, 0 }, in_frame_size };
+
+		if (window.empty())
+		{
+			return FullSearch();
+		}
+
+		++frames_since_full_search;
+		++window_search_count;
+
+		return window;
+	}
+
+	// Restarts the interval between full searches, also to be called when the window of a frame yielded nothing
+	cv::Rect FullSearch() noexcept
+	{
+		frames_since_full_search = 1;
+		++full_search_count;
+
+		return cv::Rect{};
+	}
+
+	// Records the barcode region of the frame, in frame coordinates, dropping it if the barcode could not be analyzed
+	void Update(cv::Rect const & in_region, bool was_analyzed) noexcept
+	{
+		tracked_region = was_analyzed ? in_region : cv::Rect{};
+	}
+
+	size_t WindowSearchCount() const noexcept
+	{
+		return window_search_count;
+	}
+	size_t FullSearchCount() const noexcept
+	{
+		return full_search_count;
+	}
+
+private:
+	int const full_search_interval;
+	double const padding_ratio;
+
+	int frames_since_full_search;
+	cv::Rect tracked_region;
+
+	size_t window_search_count;
+	size_t full_search_count;
+
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <atomic>
+
+#include <intrin.h>
+#include <immintrin.h>
+
+#include "simd_kernels.hpp"
+
+namespace
+{
+	std::uint64_t SumBytes(std::uint8_t const * in_src, std::size_t in_length)
+	{
+		std::uint64_t sum = 0;
+		for (std::size_t idx = 0; idx < in_length; ++idx)
+		{
+			sum += in_src[idx];
+		}
+		return sum;
+	}
+
+	void SubtractSaturate(std::uint8_t const * in_src1, std::uint8_t const * in_src2, std::uint8_t * out_dst, std::size_t in_length)
+	{
+		for (std::size_t idx = 0; idx < in_length; ++idx)
+		{
+			out_dst[idx] = std::uint8_t(std::max(int(in_src1[idx]) - int(in_src2[idx]), 0));
+		}
+	}
+
+	void ThresholdBinary(std::uint8_t const * in_src, std::uint8_t * out_dst, std::size_t in_length, int in_threshold)
+	{
+		for (std::size_t idx = 0; idx < in_length; ++idx)
+		{
+			out_dst[idx] = int(in_src[idx]) > in_threshold ? 255 : 0;
+		}
+	}
+
+	std::size_t ExtractRuns(std::uint8_t const * in_src, std::size_t in_length, int * out_starts)
+	{
+		if (in_length == 0)
+		{
+			return 0;
+		}
+
+		std::size_t run_count = 0;
+		out_starts[run_count++] = 0;
+
+		for (std::size_t idx = 1; idx < in_length; ++idx)
+		{
+			if ((in_src[idx] ^ in_src[idx - 1]) & 0x80)
+			{
+				out_starts[run_count++] = int(idx);
+			}
+		}
+		return run_count;
+	}
+
+	std::atomic<SimdKernels const *> selected_kernels = nullptr;
+
+	SimdKernels const & GetLevelKernels(int in_level) noexcept
+	{
+		switch (in_level)
+		{
+		case SimdLevel::AVX512:
+			return GetAVX512Kernels();
+		case SimdLevel::AVX2:
+			return GetAVX2Kernels();
+		case SimdLevel::SSE42:
+			return GetSSE42Kernels();
+		case SimdLevel::Scalar:
+		default:
+			return GetScalarKernels();
+		}
+	}
+}
+
+SimdKernels const & GetScalarKernels() noexcept
+{
+	static SimdKernels const kernels{ "Scalar", SumBytes, SubtractSaturate, ThresholdBinary, ExtractRuns };
+	return kernels;
+}
+
+int DetectSimdLevel() noexcept
+{
+	int registers[4];
+
+	__cpuid(registers, 0);
+	int const max_leaf = registers[0];
+
+	__cpuid(registers, 1);
+	bool const has_sse42 = registers[2] & (1 << 20);
+	bool const has_osxsave = registers[2] & (1 << 27);
+
+	if (!has_sse42)
+	{
+		return SimdLevel::Scalar;
+	}
+	if (!has_osxsave || max_leaf < 7)
+	{
+		return SimdLevel::SSE42;
+	}
+
+	// The operating system must also save the extended registers on context switches
+
+	auto const enabled_states = _xgetbv(0);
+
+	__cpuidex(registers, 7, 0);
+	bool const has_avx2 = registers[1] & (1 << 5);
+	bool const has_avx512f = registers[1] & (1 << 16);
+	bool const has_avx512bw = registers[1] & (1 << 30);
+
+	if (has_avx512f && has_avx512bw && (enabled_states & 0xE6) == 0xE6)
+	{
+		return SimdLevel::AVX512;
+	}
+	if (has_avx2 && (enabled_states & 0x06) == 0x06)
+	{
+		return SimdLevel::AVX2;
+	}
+	return SimdLevel::SSE42;
+}
+
+int SelectSimdKernels(int in_level) noexcept
+{
+	int const detected_level = DetectSimdLevel();
+	int const level = in_level == SimdLevel::Auto ? detected_level : std::clamp(in_level, int(SimdLevel::Scalar), detected_level);
+
+	selected_kernels.store(&GetLevelKernels(level), std::memory_order_release);
+
+	return level;
+}
+
+SimdKernels const & GetSimdKernels() noexcept
+{
+	auto kernels = selected_kernels.load(std::memory_order_acquire);
+
+	if (!kernels)
+	{
+		SelectSimdKernels(SimdLevel::Auto);
+		kernels = selected_kernels.load(std::memory_order_acquire);
+	}
+
+	return *kernels;
+}
@@ -0,0 +1,49 @@
+#ifndef SIMD_KERNELS_HEADER
+#define SIMD_KERNELS_HEADER
+
+#include <cstddef>
+#include <cstdint>
+
+struct SimdLevel
+{
+	enum _simd_level : int
+	{
+		Auto = -1,
+
+		Scalar = 0,
+		SSE42,
+		AVX2,
+		AVX512,
+	};
+};
+
+// Custom kernels of the detector, built once for each instruction set level
+// The translation unit of each level is compiled with its own instruction set, so it includes nothing but this header and the intrinsics,
+// otherwise inline functions compiled there could be picked by the linker for the rest of the program
+struct SimdKernels
+{
+	char const * name;
+
+	// Sum of all bytes
+	std::uint64_t (*sum_bytes)(std::uint8_t const * in_src, std::size_t in_length);
+	// Saturating subtraction of the second array from the first
+	void (*subtract_saturate)(std::uint8_t const * in_src1, std::uint8_t const * in_src2, std::uint8_t * out_dst, std::size_t in_length);
+	// Same as cv::threshold with cv::THRESH_BINARY and a maximum value of 255, given the floored threshold
+	void (*threshold_binary)(std::uint8_t const * in_src, std::uint8_t * out_dst, std::size_t in_length, int in_threshold);
+	// Start of each run of pixels on the same side of 128, returning the number of runs (the first always starts at 0)
+	std::size_t (*extract_runs)(std::uint8_t const * in_src, std::size_t in_length, int * out_starts);
+};
+
+SimdKernels const & GetScalarKernels() noexcept;
+SimdKernels const & GetSSE42Kernels() noexcept;
+SimdKernels const & GetAVX2Kernels() noexcept;
+SimdKernels const & GetAVX512Kernels() noexcept;
+
+// Highest level supported by both the processor and the operating system
+int DetectSimdLevel() noexcept;
+// Selects the kernels of the specified level (or the detected one), limited to what is supported, and returns the selected level
+int SelectSimdKernels(int in_level) noexcept;
+// Kernels currently selected, the detected ones unless others were selected
+SimdKernels const & GetSimdKernels() noexcept;
+
+#endif
@@ -0,0 +1,109 @@
+#include <intrin.h>
+#include <immintrin.h>
+
+#include "simd_kernels.hpp"
+
+namespace
+{
+	std::uint64_t SumBytes(std::uint8_t const * in_src, std::size_t in_length)
+	{
+		__m256i const zero = _mm256_setzero_si256();
+		__m256i sums = _mm256_setzero_si256();
+
+		std::size_t idx = 0;
+		for (; idx + 32 <= in_length; idx += 32)
+		{
+			sums = _mm256_add_epi64(sums, _mm256_sad_epu8(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(in_src + idx)), zero));
+		}
+
+		alignas(32) std::uint64_t lanes[4];
+		_mm256_store_si256(reinterpret_cast<__m256i *>(lanes), sums);
+
+		std::uint64_t sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+		for (; idx < in_length; ++idx)
+		{
+			sum += in_src[idx];
+		}
+		return sum;
+	}
+
+	void SubtractSaturate(std::uint8_t const * in_src1, std::uint8_t const * in_src2, std::uint8_t * out_dst, std::size_t in_length)
+	{
+		std::size_t idx = 0;
+		for (; idx + 32 <= in_length; idx += 32)
+		{
+			__m256i const src1 = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in_src1 + idx));
+			__m256i const src2 = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in_src2 + idx));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(out_dst + idx), _mm256_subs_epu8(src1, src2));
+		}
+		for (; idx < in_length; ++idx)
+		{
+			out_dst[idx] = in_src1[idx] > in_src2[idx] ? std::uint8_t(in_src1[idx] - in_src2[idx]) : 0;
+		}
+	}
+
+	void ThresholdBinary(std::uint8_t const * in_src, std::uint8_t * out_dst, std::size_t in_length, int in_threshold)
+	{
+		std::size_t idx = 0;
+
+		// Thresholds outside of the 8-bit range give constant results, handled by the scalar loop
+		if (0 <= in_threshold && in_threshold < 255)
+		{
+			// A pixel is above the threshold if it is the maximum of itself and the threshold plus one
+			__m256i const limit = _mm256_set1_epi8(char(in_threshold + 1));
+
+			for (; idx + 32 <= in_length; idx += 32)
+			{
+				__m256i const src = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in_src + idx));
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(out_dst + idx), _mm256_cmpeq_epi8(_mm256_max_epu8(src, limit), src));
+			}
+		}
+		for (; idx < in_length; ++idx)
+		{
+			out_dst[idx] = int(in_src[idx]) > in_threshold ? 255 : 0;
+		}
+	}
+
+	std::size_t ExtractRuns(std::uint8_t const * in_src, std::size_t in_length, int * out_starts)
+	{
+		if (in_length == 0)
+		{
+			return 0;
+		}
+
+		std::size_t run_count = 0;
+		out_starts[run_count++] = 0;
+
+		// A new run starts wherever the most significant bit differs from that of the previous pixel
+
+		std::size_t idx = 1;
+		for (; idx + 32 <= in_length; idx += 32)
+		{
+			__m256i const current = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in_src + idx));
+			__m256i const previous = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(in_src + idx - 1));
+
+			unsigned long mask = unsigned(_mm256_movemask_epi8(_mm256_xor_si256(current, previous)));
+			unsigned long bit;
+
+			while (_BitScanForward(&bit, mask))
+			{
+				out_starts[run_count++] = int(idx + bit);
+				mask &= mask - 1;
+			}
+		}
+		for (; idx < in_length; ++idx)
+		{
+			if ((in_src[idx] ^ in_src[idx - 1]) & 0x80)
+			{
+				out_starts[run_count++] = int(idx);
+			}
+		}
+		return run_count;
+	}
+}
+
+SimdKernels const & GetAVX2Kernels() noexcept
+{
+	static SimdKernels const kernels{ "AVX2", SumBytes, SubtractSaturate, ThresholdBinary, ExtractRuns };
+	return kernels;
+}
@@ -0,0 +1,110 @@
+#include <intrin.h>
+#include <immintrin.h>
+
+#include "simd_kernels.hpp"
+
+namespace
+{
+	// Mask of the first bytes of a vector, used for the remaining pixels of a row
+	__mmask64 TailMask(std::size_t in_length) noexcept
+	{
+		return in_length >= 64 ? ~__mmask64(0) : (__mmask64(1) << in_length) - 1;
+	}
+
+	std::uint64_t SumBytes(std::uint8_t const * in_src, std::size_t in_length)
+	{
+		__m512i const zero = _mm512_setzero_si512();
+		__m512i sums = _mm512_setzero_si512();
+
+		for (std::size_t idx = 0; idx < in_length; idx += 64)
+		{
+			__m512i const src = _mm512_maskz_loadu_epi8(TailMask(in_length - idx), in_src + idx);
+			sums = _mm512_add_epi64(sums, _mm512_sad_epu8(src, zero));
+		}
+
+		alignas(64) std::uint64_t lanes[8];
+		_mm512_store_si512(lanes, sums);
+
+		return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+	}
+
+	void SubtractSaturate(std::uint8_t const * in_src1, std::uint8_t const * in_src2, std::uint8_t * out_dst, std::size_t in_length)
+	{
+		for (std::size_t idx = 0; idx < in_length; idx += 64)
+		{
+			__mmask64 const mask = TailMask(in_length - idx);
+
+			__m512i const src1 = _mm512_maskz_loadu_epi8(mask, in_src1 + idx);
+			__m512i const src2 = _mm512_maskz_loadu_epi8(mask, in_src2 + idx);
+			_mm512_mask_storeu_epi8(out_dst + idx, mask, _mm512_subs_epu8(src1, src2));
+		}
+	}
+
+	void ThresholdBinary(std::uint8_t const * in_src, std::uint8_t * out_dst, std::size_t in_length, int in_threshold)
+	{
+		// Thresholds outside of the 8-bit range give constant results
+		if (in_threshold < 0 || in_threshold >= 255)
+		{
+			__m512i const value = _mm512_set1_epi8(char(in_threshold < 0 ? 255 : 0));
+
+			for (std::size_t idx = 0; idx < in_length; idx += 64)
+			{
+				_mm512_mask_storeu_epi8(out_dst + idx, TailMask(in_length - idx), value);
+			}
+			return;
+		}
+
+		__m512i const limit = _mm512_set1_epi8(char(in_threshold));
+
+		for (std::size_t idx = 0; idx < in_length; idx += 64)
+		{
+			__mmask64 const mask = TailMask(in_length - idx);
+
+			__m512i const src = _mm512_maskz_loadu_epi8(mask, in_src + idx);
+			_mm512_mask_storeu_epi8(out_dst + idx, mask, _mm512_movm_epi8(_mm512_cmpgt_epu8_mask(src, limit)));
+		}
+	}
+
+	std::size_t ExtractRuns(std::uint8_t const * in_src, std::size_t in_length, int * out_starts)
+	{
+		if (in_length == 0)
+		{
+			return 0;
+		}
+
+		std::size_t run_count = 0;
+		out_starts[run_count++] = 0;
+
+		// A new run starts wherever the most significant bit differs from that of the previous pixel
+
+		for (std::size_t idx = 1; idx < in_length; idx += 64)
+		{
+			__mmask64 const tail_mask = TailMask(in_length - idx);
+
+			__m512i const current = _mm512_maskz_loadu_epi8(tail_mask, in_src + idx);
+			__m512i const previous = _mm512_maskz_loadu_epi8(tail_mask, in_src + idx - 1);
+
+			__mmask64 const run_mask = _mm512_movepi8_mask(_mm512_xor_si512(current, previous));
+
+			// Scanned in halves, as 64-bit bit scans are not available on 32-bit targets
+			for (std::size_t half = 0; half < 2; ++half)
+			{
+				unsigned long mask = unsigned(run_mask >> (half * 32));
+				unsigned long bit;
+
+				while (_BitScanForward(&bit, mask))
+				{
+					out_starts[run_count++] = int(idx + half * 32 + bit);
+					mask &= mask - 1;
+				}
+			}
+		}
+		return run_count;
+	}
+}
+
+SimdKernels const & GetAVX512Kernels() noexcept
+{
+	static SimdKernels const kernels{ "AVX-512", SumBytes, SubtractSaturate, ThresholdBinary, ExtractRuns };
+	return kernels;
+}
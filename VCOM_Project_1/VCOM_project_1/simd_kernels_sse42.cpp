@@ -0,0 +1,109 @@
+#include <intrin.h>
+#include <immintrin.h>
+
+#include "simd_kernels.hpp"
+
+namespace
+{
+	std::uint64_t SumBytes(std::uint8_t const * in_src, std::size_t in_length)
+	{
+		__m128i const zero = _mm_setzero_si128();
+		__m128i sums = _mm_setzero_si128();
+
+		std::size_t idx = 0;
+		for (; idx + 16 <= in_length; idx += 16)
+		{
+			sums = _mm_add_epi64(sums, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(in_src + idx)), zero));
+		}
+
+		alignas(16) std::uint64_t lanes[2];
+		_mm_store_si128(reinterpret_cast<__m128i *>(lanes), sums);
+
+		std::uint64_t sum = lanes[0] + lanes[1];
+		for (; idx < in_length; ++idx)
+		{
+			sum += in_src[idx];
+		}
+		return sum;
+	}
+
+	void SubtractSaturate(std::uint8_t const * in_src1, std::uint8_t const * in_src2, std::uint8_t * out_dst, std::size_t in_length)
+	{
+		std::size_t idx = 0;
+		for (; idx + 16 <= in_length; idx += 16)
+		{
+			__m128i const src1 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in_src1 + idx));
+			__m128i const src2 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in_src2 + idx));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out_dst + idx), _mm_subs_epu8(src1, src2));
+		}
+		for (; idx < in_length; ++idx)
+		{
+			out_dst[idx] = in_src1[idx] > in_src2[idx] ? std::uint8_t(in_src1[idx] - in_src2[idx]) : 0;
+		}
+	}
+
+	void ThresholdBinary(std::uint8_t const * in_src, std::uint8_t * out_dst, std::size_t in_length, int in_threshold)
+	{
+		std::size_t idx = 0;
+
+		// Thresholds outside of the 8-bit range give constant results, handled by the scalar loop
+		if (0 <= in_threshold && in_threshold < 255)
+		{
+			// A pixel is above the threshold if it is the maximum of itself and the threshold plus one
+			__m128i const limit = _mm_set1_epi8(char(in_threshold + 1));
+
+			for (; idx + 16 <= in_length; idx += 16)
+			{
+				__m128i const src = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in_src + idx));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(out_dst + idx), _mm_cmpeq_epi8(_mm_max_epu8(src, limit), src));
+			}
+		}
+		for (; idx < in_length; ++idx)
+		{
+			out_dst[idx] = int(in_src[idx]) > in_threshold ? 255 : 0;
+		}
+	}
+
+	std::size_t ExtractRuns(std::uint8_t const * in_src, std::size_t in_length, int * out_starts)
+	{
+		if (in_length == 0)
+		{
+			return 0;
+		}
+
+		std::size_t run_count = 0;
+		out_starts[run_count++] = 0;
+
+		// A new run starts wherever the most significant bit differs from that of the previous pixel
+
+		std::size_t idx = 1;
+		for (; idx + 16 <= in_length; idx += 16)
+		{
+			__m128i const current = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in_src + idx));
+			__m128i const previous = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in_src + idx - 1));
+
+			unsigned long mask = _mm_movemask_epi8(_mm_xor_si128(current, previous));
+			unsigned long bit;
+
+			while (_BitScanForward(&bit, mask))
+			{
+				out_starts[run_count++] = int(idx + bit);
+				mask &= mask - 1;
+			}
+		}
+		for (; idx < in_length; ++idx)
+		{
+			if ((in_src[idx] ^ in_src[idx - 1]) & 0x80)
+			{
+				out_starts[run_count++] = int(idx);
+			}
+		}
+		return run_count;
+	}
+}
+
+SimdKernels const & GetSSE42Kernels() noexcept
+{
+	static SimdKernels const kernels{ "SSE4.2", SumBytes, SubtractSaturate, ThresholdBinary, ExtractRuns };
+	return kernels;
+}
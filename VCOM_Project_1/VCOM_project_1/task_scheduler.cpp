@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+#include <opencv2/opencv.hpp>
+
+#include "task_scheduler.hpp"
+
+namespace
+{
+	// Worker that the current thread runs as, the first one for threads outside the scheduler
+	thread_local TaskScheduler const * current_scheduler = nullptr;
+	thread_local size_t current_worker_idx = 0;
+
+	std::mutex scheduler_mutex;
+	std::shared_ptr<TaskScheduler> scheduler;
+}
+
+double SchedulerCounters::Utilisation() const noexcept
+{
+	if (workers.empty() || elapsed_seconds <= 0.0)
+	{
+		return 0.0;
+	}
+
+	double busy_seconds = 0.0;
+	for (auto const & worker : workers)
+	{
+		busy_seconds += worker.busy_seconds;
+	}
+	return busy_seconds / (elapsed_seconds * double(workers.size()));
+}
+
+size_t SchedulerCounters::ThreadBound() const noexcept
+{
+	return workers.size() * opencv_thread_count;
+}
+
+TaskScheduler::TaskScheduler(size_t in_thread_count, size_t in_opencv_thread_count)
+	: pending_tasks{ 0 }
+	, is_stopping{ false }
+	, start_time{ std::chrono::steady_clock::now() }
+{
+	in_thread_count = in_thread_count ? in_thread_count : std::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+
+	// OpenCV gets its share of the budget, which only changes when the scheduler is configured again, and the scheduler
+	// as many workers as can each run an OpenCV loop at once within the budget
+
+	opencv_thread_count = in_opencv_thread_count ? std::min(in_opencv_thread_count, in_thread_count) : in_thread_count;
+	size_t const worker_count = in_thread_count / opencv_thread_count;
+
+	cv::setNumThreads(int(opencv_thread_count));
+
+	workers.reserve(worker_count);
+	for (size_t idx = 0; idx < worker_count; ++idx)
+	{
+		workers.push_back(std::make_unique<Worker>());
+	}
+
+	threads.reserve(worker_count - 1);
+	for (size_t idx = 1; idx < worker_count; ++idx)
+	{
+		threads.emplace_back(&TaskScheduler::WorkerLoop, this, idx);
+	}
+}
+
+TaskScheduler::~TaskScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock{ wake_mutex };
+		is_stopping = true;
+	}
+	wake_condition.notify_all();
+
+	for (auto & thread : threads)
+	{
+		thread.join();
+	}
+}
+
+void TaskScheduler::ParallelFor(size_t in_count, std::function<void(size_t)> const & in_body)
+{
+	// Nothing to gain from the workers for a single task
+
+	if (in_count <= 1 || workers.size() == 1)
+	{
+		for (size_t idx = 0; idx < in_count; ++idx)
+		{
+			in_body(idx);
+		}
+		return;
+	}
+
+	size_t const home_idx = current_scheduler == this ? current_worker_idx : 0;
+
+	std::atomic_size_t remaining_tasks = in_count;
+	std::vector<std::exception_ptr> task_errors(in_count);
+
+	// Tasks are counted before they are queued, so that workers never see more tasks than are counted
+
+	pending_tasks.fetch_add(in_count);
+
+	// Spread the tasks over the queues of all workers, starting with the calling one, so that they only steal once the loop is unbalanced
+
+	for (size_t idx = 0; idx < in_count; ++idx)
+	{
+		auto & worker = *workers[(home_idx + idx) % workers.size()];
+
+		std::lock_guard<std::mutex> lock{ worker.mutex };
+		worker.tasks.emplace_back([this, &in_body, &remaining_tasks, &task_errors, idx]
+		{
+			try
+			{
+				in_body(idx);
+			}
+			catch (...)
+			{
+				task_errors[idx] = std::current_exception();
+			}
+
+			// The last task wakes the calling thread, if it is waiting, without touching the loop's state any further
+
+			if (remaining_tasks.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				{
+					std::lock_guard<std::mutex> lock{ wake_mutex };
+				}
+				wake_condition.notify_all();
+			}
+		});
+	}
+
+	// Workers check for tasks while holding the lock, so taking it here keeps them from missing the notification
+
+	{
+		std::lock_guard<std::mutex> lock{ wake_mutex };
+	}
+	wake_condition.notify_all();
+
+	// Help with any task until those of this loop are done, which also keeps nested loops from waiting on each other,
+	// sleeping while there is none left to take but some of this loop are still running on other workers
+
+	while (remaining_tasks.load(std::memory_order_acquire) > 0)
+	{
+		if (TryRunTask(home_idx))
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock{ wake_mutex };
+		wake_condition.wait(lock, [this, &remaining_tasks] { return remaining_tasks.load(std::memory_order_acquire) == 0 || pending_tasks.load() > 0; });
+	}
+
+	for (auto const & error : task_errors)
+	{
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
+}
+
+SchedulerCounters TaskScheduler::Counters() const
+{
+	SchedulerCounters counters;
+	counters.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	counters.workers.reserve(workers.size());
+	counters.opencv_thread_count = opencv_thread_count;
+
+	for (auto const & worker : workers)
+	{
+		counters.workers.push_back({
+			worker->executed_tasks.load(std::memory_order_relaxed),
+			worker->stolen_tasks.load(std::memory_order_relaxed),
+			double(worker->busy_nanoseconds.load(std::memory_order_relaxed)) * 1e-9
+		});
+	}
+
+	return counters;
+}
+
+void TaskScheduler::WorkerLoop(size_t in_worker_idx)
+{
+	current_scheduler = this;
+	current_worker_idx = in_worker_idx;
+
+	while (true)
+	{
+		if (TryRunTask(in_worker_idx))
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock{ wake_mutex };
+		wake_condition.wait(lock, [this] { return is_stopping || pending_tasks.load() > 0; });
+
+		if (is_stopping && pending_tasks.load() == 0)
+		{
+			return;
+		}
+	}
+}
+
+bool TaskScheduler::TryRunTask(size_t in_worker_idx)
+{
+	std::function<void()> task;
+	bool is_stolen = false;
+
+	// Take the newest task of its own queue, or else the oldest task of another one
+
+	for (size_t offset = 0; offset < workers.size() && !task; ++offset)
+	{
+		auto & worker = *workers[(in_worker_idx + offset) % workers.size()];
+
+		std::lock_guard<std::mutex> lock{ worker.mutex };
+
+		if (!worker.tasks.empty())
+		{
+			if (offset == 0)
+			{
+				task = std::move(worker.tasks.back());
+				worker.tasks.pop_back();
+			}
+			else
+			{
+				task = std::move(worker.tasks.front());
+				worker.tasks.pop_front();
+				is_stolen = true;
+			}
+		}
+	}
+
+	if (!task)
+	{
+		return false;
+	}
+
+	pending_tasks.fetch_sub(1);
+
+	auto & worker = *workers[in_worker_idx];
+
+	auto const task_start = std::chrono::steady_clock::now();
+	task();
+	auto const task_time = std::chrono::steady_clock::now() - task_start;
+
+	worker.executed_tasks.fetch_add(1, std::memory_order_relaxed);
+	worker.stolen_tasks.fetch_add(std::uint64_t(is_stolen), std::memory_order_relaxed);
+	worker.busy_nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(task_time).count(), std::memory_order_relaxed);
+
+	return true;
+}
+
+std::shared_ptr<TaskScheduler> ConfigureTaskScheduler(size_t in_thread_count, size_t in_opencv_thread_count)
+{
+	auto configured_scheduler = std::make_shared<TaskScheduler>(in_thread_count, in_opencv_thread_count);
+
+	// The previous scheduler is released without the lock held, since its threads are joined if nothing else holds it
+
+	std::shared_ptr<TaskScheduler> previous_scheduler;
+
+	{
+		std::lock_guard<std::mutex> lock{ scheduler_mutex };
+
+		previous_scheduler = std::exchange(scheduler, configured_scheduler);
+	}
+
+	return configured_scheduler;
+}
+
+std::shared_ptr<TaskScheduler> GetTaskScheduler()
+{
+	std::lock_guard<std::mutex> lock{ scheduler_mutex };
+
+	if (!scheduler)
+	{
+		scheduler = std::make_shared<TaskScheduler>(0, 1);
+	}
+
+	return scheduler;
+}
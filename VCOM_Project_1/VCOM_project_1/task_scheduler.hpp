@@ -0,0 +1,102 @@
+#ifndef TASK_SCHEDULER_HEADER
+#define TASK_SCHEDULER_HEADER
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct WorkerCounters
+{
+	std::uint64_t executed_tasks; // Tasks run by this worker, stolen ones included
+	std::uint64_t stolen_tasks; // Tasks taken from the queue of another worker
+	double busy_seconds;
+};
+
+struct SchedulerCounters
+{
+	double elapsed_seconds;
+	std::vector<WorkerCounters> workers; // The first one stands for the threads that call into the scheduler
+	size_t opencv_thread_count; // Threads of each OpenCV loop, which any worker may run at once
+
+	// Busy time of all workers as a fraction of the time they have existed
+	double Utilisation() const noexcept;
+	// Threads that may run at once, every worker running an OpenCV loop
+	size_t ThreadBound() const noexcept;
+};
+
+// Owns the thread budget of the detector, split between its own parallel tasks and OpenCV's internal parallelism
+// Tasks call into OpenCV, and every worker may run an OpenCV loop at once (whether OpenCV runs concurrent loops in parallel
+// depends on its backend), so the budget is split for their product to stay within it: OpenCV gets its share and the scheduler
+// as many workers as fit alongside, a share of 1 giving all threads to the scheduler and the whole budget all of them to OpenCV
+// OpenCV's thread count is set when the scheduler is created, and never changed while it runs, since it is global
+// to the process and may be in use by other callers at any time (OpenCV 4.1.1 cannot run its parallel loops on an external pool)
+// Each worker has its own queue of tasks, and steals from the others once its own is empty
+class TaskScheduler
+{
+public:
+	// A thread count of 0 uses the number of hardware threads, the calling thread counting as one of them,
+	// and an OpenCV thread count of 0 the whole budget
+	TaskScheduler(size_t in_thread_count, size_t in_opencv_thread_count);
+	~TaskScheduler();
+
+	TaskScheduler(TaskScheduler const &) = delete;
+	TaskScheduler & operator=(TaskScheduler const &) = delete;
+
+	size_t ThreadCount() const noexcept
+	{
+		return workers.size();
+	}
+
+	size_t OpenCVThreadCount() const noexcept
+	{
+		return opencv_thread_count;
+	}
+
+	// Runs the body for every index up to the count across the workers, with the calling thread helping until all are done,
+	// then rethrows the first exception thrown by the body, if any
+	void ParallelFor(size_t in_count, std::function<void(size_t)> const & in_body);
+
+	SchedulerCounters Counters() const;
+
+private:
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+
+		std::atomic<std::uint64_t> executed_tasks = 0;
+		std::atomic<std::uint64_t> stolen_tasks = 0;
+		std::atomic<std::int64_t> busy_nanoseconds = 0;
+	};
+
+	void WorkerLoop(size_t in_worker_idx);
+	bool TryRunTask(size_t in_worker_idx);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::thread> threads;
+	size_t opencv_thread_count;
+
+	std::mutex wake_mutex;
+	std::condition_variable wake_condition;
+	std::atomic_size_t pending_tasks;
+	bool is_stopping;
+
+	std::chrono::steady_clock::time_point const start_time;
+
+};
+
+// Replaces the scheduler with one of the specified thread counts, which later loops run on
+// Loops already running keep the previous one alive until they are done, as it is only destroyed along with its last reference
+std::shared_ptr<TaskScheduler> ConfigureTaskScheduler(size_t in_thread_count, size_t in_opencv_thread_count);
+// Scheduler currently configured, one with the number of hardware threads, all for the scheduler, unless configured otherwise
+// The reference should be held for as long as the scheduler is used, as it may be replaced by another thread meanwhile
+std::shared_ptr<TaskScheduler> GetTaskScheduler();
+
+#endif
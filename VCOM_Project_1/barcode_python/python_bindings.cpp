@@ -0,0 +1,725 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The release interpreter is linked in every configuration, since debug builds of Python are seldom installed
+
+#if defined(_DEBUG)
+#undef _DEBUG
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#define _DEBUG
+#else
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#endif
+
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+
+#include <opencv2/opencv.hpp>
+
+#include "barcode_detection.hpp"
+#include "result_cache.hpp"
+#include "task_scheduler.hpp"
+
+namespace
+{
+	// Records of the structured arrays returned to Python, laid out as their dtypes
+
+#pragma pack(push, 1)
+	struct ROIRecord
+	{
+		std::int32_t x;
+		std::int32_t y;
+		std::int32_t width;
+		std::int32_t height;
+		std::int32_t x_response;
+		std::int32_t y_response;
+	};
+
+	struct SegmentRecord
+	{
+		double start; // In pixels of the image
+		double end;
+		double width_percent; // Of the whole barcode
+		bool is_bar;
+		double agreement;
+	};
+#pragma pack(pop)
+
+	// Dtypes of the records, created along with the module
+	PyArray_Descr * ROI_descr = nullptr;
+	PyArray_Descr * segment_descr = nullptr;
+
+	PyArray_Descr * NewRecordDescr(PyObject * in_fields)
+	{
+		PyArray_Descr * descr = nullptr;
+
+		if (in_fields && !PyArray_DescrConverter(in_fields, &descr))
+		{
+			descr = nullptr;
+		}
+
+		Py_XDECREF(in_fields);
+
+		return descr;
+	}
+
+	// Image of a NumPy array, keeping a reference to the array for as long as its data is used without the interpreter lock
+	struct ImageView
+	{
+		PyArrayObject * array;
+		cv::Mat image;
+	};
+
+	// Wraps a BGR array as an image without copying it, which requires 8-bit pixels stored contiguously within each row
+	bool WrapImage(PyObject * in_object, ImageView & out_view)
+	{
+		if (!PyArray_Check(in_object))
+		{
+			PyErr_SetString(PyExc_TypeError, "image must be a numpy.ndarray");
+			return false;
+		}
+
+		auto const array = reinterpret_cast<PyArrayObject *>(in_object);
+		auto const shape = PyArray_DIMS(array);
+		auto const strides = PyArray_STRIDES(array);
+
+		if (PyArray_TYPE(array) != NPY_UINT8 || PyArray_NDIM(array) != 3 || shape[2] != 3)
+		{
+			PyErr_SetString(PyExc_ValueError, "image must be a uint8 array of shape (height, width, 3) in BGR order");
+			return false;
+		}
+		if (strides[2] != 1 || strides[1] != 3 || strides[0] < 3 * shape[1])
+		{
+			PyErr_SetString(PyExc_ValueError, "image rows must be contiguous, use numpy.ascontiguousarray to copy it");
+			return false;
+		}
+		if (shape[0] == 0 || shape[1] == 0)
+		{
+			PyErr_SetString(PyExc_ValueError, "image must not be empty");
+			return false;
+		}
+
+		Py_INCREF(in_object);
+
+		out_view.array = array;
+		out_view.image = cv::Mat(int(shape[0]), int(shape[1]), CV_8UC3, PyArray_DATA(array), size_t(strides[0]));
+
+		return true;
+	}
+
+	void ReleaseImages(std::vector<ImageView> & io_views)
+	{
+		for (auto & view : io_views)
+		{
+			view.image.release();
+			Py_DECREF(view.array);
+		}
+		io_views.clear();
+	}
+
+	// Parameters of the first step as in non-debug mode, with the program's defaults if none are specified
+	bool ParseParams(PyObject * in_object, std::vector<double> & out_params)
+	{
+		out_params = { 5.0, 3.0, 0.8, 1.6, 20.0, 8.0, 2.0, 2.0, 60.0, 0.0, 0.0 };
+
+		if (!in_object || in_object == Py_None)
+		{
+			return true;
+		}
+
+		PyObject * sequence = PySequence_Fast(in_object, "params must be a sequence");
+		if (!sequence)
+		{
+			return false;
+		}
+
+		bool is_valid = PySequence_Fast_GET_SIZE(sequence) == 9;
+		if (!is_valid)
+		{
+			PyErr_SetString(PyExc_ValueError, "params must have 9 values (gkw, gkh, gsx, gsy, btv, mkw, mkh, mni, rms)");
+		}
+
+		for (Py_ssize_t idx = 0; is_valid && idx < 9; ++idx)
+		{
+			out_params[size_t(idx)] = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(sequence, idx));
+			is_valid = !PyErr_Occurred();
+		}
+
+		Py_DECREF(sequence);
+
+		return is_valid;
+	}
+
+	PyObject * NewRecordArray(PyArray_Descr * in_descr, void const * in_records, size_t in_count, size_t in_record_size)
+	{
+		npy_intp dims[1] = { npy_intp(in_count) };
+
+		// Steals a reference to the descriptor
+		Py_INCREF(in_descr);
+		PyObject * array = PyArray_NewFromDescr(&PyArray_Type, in_descr, 1, dims, nullptr, nullptr, 0, nullptr);
+		if (array && in_count > 0)
+		{
+			std::memcpy(PyArray_DATA(reinterpret_cast<PyArrayObject *>(array)), in_records, in_count * in_record_size);
+		}
+
+		return array;
+	}
+
+	// Converts a detection into a dictionary, with the segments in coordinates of the image
+	PyObject * BuildResult(BarcodeDetection const & in_detection)
+	{
+		std::vector<ROIRecord> ROI_records;
+		ROI_records.reserve(in_detection.ROIs.size());
+
+		for (auto const & ROI : in_detection.ROIs)
+		{
+			ROI_records.push_back({ ROI.region.x, ROI.region.y, ROI.region.width, ROI.region.height, ROI.x_response, ROI.y_response });
+		}
+
+		std::vector<SegmentRecord> segment_records;
+
+		if (auto const & segments = in_detection.segments; segments.size() > 1)
+		{
+			double const origin = double(in_detection.ROIs[size_t(in_detection.barcode_idx)].region.x);
+			double const barcode_length = segments.back().start_position - segments.front().start_position;
+
+			segment_records.reserve(segments.size() - 1);
+
+			for (size_t idx = 1; idx < segments.size(); ++idx)
+			{
+				double const start = segments[idx - 1].start_position;
+				double const end = segments[idx].start_position;
+
+				segment_records.push_back({
+					origin + start * in_detection.pixel_ratio,
+					origin + end * in_detection.pixel_ratio,
+					(end - start) * 100.0 / barcode_length,
+					segments[idx - 1].is_bar,
+					segments[idx - 1].agreement
+				});
+			}
+		}
+
+		PyObject * ROIs = NewRecordArray(ROI_descr, ROI_records.data(), ROI_records.size(), sizeof(ROIRecord));
+		PyObject * segments = ROIs ? NewRecordArray(segment_descr, segment_records.data(), segment_records.size(), sizeof(SegmentRecord)) : nullptr;
+
+		PyObject * result = segments ? Py_BuildValue("{s:O,s:i,s:O,s:d}",
+			"rois", ROIs,
+			"barcode", in_detection.barcode_idx,
+			"segments", segments,
+			"confidence", in_detection.confidence) : nullptr;
+
+		Py_XDECREF(ROIs);
+		Py_XDECREF(segments);
+
+		return result;
+	}
+
+	// Message of the exception being handled, copied so that it can be raised once the interpreter lock is held again
+	std::string CurrentErrorMessage()
+	{
+		try
+		{
+			throw;
+		}
+		catch (std::exception const & exception)
+		{
+			return *exception.what() ? exception.what() : "Detection failed!";
+		}
+		catch (...)
+		{
+			return "Detection failed with an unknown error!";
+		}
+	}
+
+	bool ParseSettings(int in_adaptive, int in_subpixel, int in_scanlines, ScanSettings & out_settings)
+	{
+		if (in_scanlines < 1)
+		{
+			PyErr_SetString(PyExc_ValueError, "scanlines must be positive");
+			return false;
+		}
+
+		out_settings.is_adaptive = in_adaptive != 0;
+		out_settings.is_subpixel = in_subpixel != 0;
+		out_settings.scanline_count = in_scanlines;
+
+		return true;
+	}
+
+	char const * detect_keywords[] = { "image", "params", "adaptive", "subpixel", "scanlines", nullptr };
+	char const * detect_batch_keywords[] = { "images", "params", "adaptive", "subpixel", "scanlines", nullptr };
+	char const * detect_file_keywords[] = { "path", "params", "adaptive", "subpixel", "scanlines", nullptr };
+	char const * detect_encoded_keywords[] = { "data", "params", "adaptive", "subpixel", "scanlines", nullptr };
+	char const * set_result_cache_keywords[] = { "path", "max_bytes", nullptr };
+	char const * set_thread_count_keywords[] = { "count", "opencv_count", nullptr };
+
+	// Cache of the detections of encoded images, if enabled, shared with the detections running when it is replaced so it outlives them
+	std::shared_ptr<ResultCache> result_cache;
+
+	PyObject * Detect(PyObject *, PyObject * in_args, PyObject * in_kwargs)
+	{
+		PyObject * image_object = nullptr;
+		PyObject * params_object = nullptr;
+		int adaptive = 0;
+		int subpixel = 0;
+		int scanlines = 1;
+
+		if (!PyArg_ParseTupleAndKeywords(in_args, in_kwargs, "O|Oppi", const_cast<char **>(detect_keywords), &image_object, &params_object, &adaptive, &subpixel, &scanlines))
+		{
+			return nullptr;
+		}
+
+		std::vector<double> params;
+		ScanSettings settings;
+
+		if (!ParseParams(params_object, params) || !ParseSettings(adaptive, subpixel, scanlines, settings))
+		{
+			return nullptr;
+		}
+
+		std::vector<ImageView> views(1);
+		if (!WrapImage(image_object, views[0]))
+		{
+			return nullptr;
+		}
+
+		// Detect without the interpreter lock, so that other Python threads keep running
+
+		BarcodeDetection detection;
+		std::string error;
+
+		Py_BEGIN_ALLOW_THREADS
+		try
+		{
+			detection = DetectBarcode(views[0].image, params, settings);
+		}
+		catch (...)
+		{
+			error = CurrentErrorMessage();
+		}
+		Py_END_ALLOW_THREADS
+
+		ReleaseImages(views);
+
+		if (!error.empty())
+		{
+			PyErr_SetString(PyExc_RuntimeError, error.c_str());
+			return nullptr;
+		}
+
+		return BuildResult(detection);
+	}
+
+	PyObject * DetectBatch(PyObject *, PyObject * in_args, PyObject * in_kwargs)
+	{
+		PyObject * images_object = nullptr;
+		PyObject * params_object = nullptr;
+		int adaptive = 0;
+		int subpixel = 0;
+		int scanlines = 1;
+
+		if (!PyArg_ParseTupleAndKeywords(in_args, in_kwargs, "O|Oppi", const_cast<char **>(detect_batch_keywords), &images_object, &params_object, &adaptive, &subpixel, &scanlines))
+		{
+			return nullptr;
+		}
+
+		std::vector<double> params;
+		ScanSettings settings;
+
+		if (!ParseParams(params_object, params) || !ParseSettings(adaptive, subpixel, scanlines, settings))
+		{
+			return nullptr;
+		}
+
+		PyObject * sequence = PySequence_Fast(images_object, "images must be a sequence of arrays");
+		if (!sequence)
+		{
+			return nullptr;
+		}
+
+		// Wrap every image before releasing the interpreter lock, holding references to them in case the sequence changes meanwhile
+
+		auto const image_count = size_t(PySequence_Fast_GET_SIZE(sequence));
+
+		std::vector<ImageView> views;
+		views.reserve(image_count);
+
+		for (size_t idx = 0; idx < image_count; ++idx)
+		{
+			ImageView view;
+			if (!WrapImage(PySequence_Fast_GET_ITEM(sequence, Py_ssize_t(idx)), view))
+			{
+				ReleaseImages(views);
+				Py_DECREF(sequence);
+				return nullptr;
+			}
+			views.push_back(view);
+		}
+
+		Py_DECREF(sequence);
+
+		// Detect in every image as a task of the scheduler, each with its own result
+		// The scheduler is held until all are done, in case another thread configures a new one meanwhile
+
+		auto const scheduler = GetTaskScheduler();
+
+		std::vector<BarcodeDetection> detections(image_count);
+		std::string error;
+
+		Py_BEGIN_ALLOW_THREADS
+		try
+		{
+			scheduler->ParallelFor(image_count, [&](size_t in_idx)
+			{
+				detections[in_idx] = DetectBarcode(views[in_idx].image, params, settings);
+			});
+		}
+		catch (...)
+		{
+			error = CurrentErrorMessage();
+		}
+		Py_END_ALLOW_THREADS
+
+		ReleaseImages(views);
+
+		if (!error.empty())
+		{
+			PyErr_SetString(PyExc_RuntimeError, error.c_str());
+			return nullptr;
+		}
+
+		PyObject * results = PyList_New(Py_ssize_t(image_count));
+		if (!results)
+		{
+			return nullptr;
+		}
+
+		for (size_t idx = 0; idx < image_count; ++idx)
+		{
+			PyObject * result = BuildResult(detections[idx]);
+			if (!result)
+			{
+				Py_DECREF(results);
+				return nullptr;
+			}
+
+			// Steals the reference to the result
+			PyList_SET_ITEM(results, Py_ssize_t(idx), result);
+		}
+
+		return results;
+	}
+
+	// Reads the whole file, returning false if it cannot be read
+	bool ReadFile(fs::path const & in_path, std::vector<char> & out_data)
+	{
+		std::ifstream file{ in_path, std::ios::binary };
+		if (!file)
+		{
+			return false;
+		}
+
+		out_data.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+
+		return !file.bad();
+	}
+
+	PyObject * DetectFile(PyObject *, PyObject * in_args, PyObject * in_kwargs)
+	{
+		PyObject * path_object = nullptr;
+		PyObject * params_object = nullptr;
+		int adaptive = 0;
+		int subpixel = 0;
+		int scanlines = 1;
+
+		// The path is converted to bytes in the file system encoding, which is UTF-8 on Windows as well
+		if (!PyArg_ParseTupleAndKeywords(in_args, in_kwargs, "O&|Oppi", const_cast<char **>(detect_file_keywords), PyUnicode_FSConverter, &path_object, &params_object, &adaptive, &subpixel, &scanlines))
+		{
+			return nullptr;
+		}
+
+		auto const path = fs::u8path(PyBytes_AS_STRING(path_object));
+		Py_DECREF(path_object);
+
+		std::vector<double> params;
+		ScanSettings settings;
+
+		if (!ParseParams(params_object, params) || !ParseSettings(adaptive, subpixel, scanlines, settings))
+		{
+			return nullptr;
+		}
+
+		auto const cache = result_cache;
+
+		// Read and detect without the interpreter lock, the image only being decoded if its result is not cached yet
+
+		BarcodeDetection detection;
+		bool is_read = false;
+		std::string error;
+
+		Py_BEGIN_ALLOW_THREADS
+		try
+		{
+			std::vector<char> data;
+
+			is_read = ReadFile(path, data);
+			if (is_read)
+			{
+				detection = DetectBarcodeEncoded(data.data(), data.size(), params, settings, cache.get());
+			}
+		}
+		catch (...)
+		{
+			error = CurrentErrorMessage();
+		}
+		Py_END_ALLOW_THREADS
+
+		if (!error.empty())
+		{
+			PyErr_SetString(PyExc_RuntimeError, error.c_str());
+			return nullptr;
+		}
+		if (!is_read)
+		{
+			PyErr_SetString(PyExc_OSError, ("Image could not be read: " + path.u8string()).c_str());
+			return nullptr;
+		}
+
+		return BuildResult(detection);
+	}
+
+	PyObject * DetectEncoded(PyObject *, PyObject * in_args, PyObject * in_kwargs)
+	{
+		PyObject * data_object = nullptr;
+		PyObject * params_object = nullptr;
+		int adaptive = 0;
+		int subpixel = 0;
+		int scanlines = 1;
+
+		if (!PyArg_ParseTupleAndKeywords(in_args, in_kwargs, "O|Oppi", const_cast<char **>(detect_encoded_keywords), &data_object, &params_object, &adaptive, &subpixel, &scanlines))
+		{
+			return nullptr;
+		}
+
+		std::vector<double> params;
+		ScanSettings settings;
+
+		if (!ParseParams(params_object, params) || !ParseSettings(adaptive, subpixel, scanlines, settings))
+		{
+			return nullptr;
+		}
+
+		// The buffer holds on to the bytes for as long as they are used without the interpreter lock
+		Py_buffer data;
+		if (PyObject_GetBuffer(data_object, &data, PyBUF_SIMPLE) != 0)
+		{
+			return nullptr;
+		}
+
+		auto const cache = result_cache;
+
+		BarcodeDetection detection;
+		std::string error;
+
+		Py_BEGIN_ALLOW_THREADS
+		try
+		{
+			detection = DetectBarcodeEncoded(data.buf, size_t(data.len), params, settings, cache.get());
+		}
+		catch (...)
+		{
+			error = CurrentErrorMessage();
+		}
+		Py_END_ALLOW_THREADS
+
+		PyBuffer_Release(&data);
+
+		if (!error.empty())
+		{
+			PyErr_SetString(PyExc_RuntimeError, error.c_str());
+			return nullptr;
+		}
+
+		return BuildResult(detection);
+	}
+
+	PyObject * SetResultCache(PyObject *, PyObject * in_args, PyObject * in_kwargs)
+	{
+		PyObject * path_object = nullptr;
+		Py_ssize_t max_bytes = Py_ssize_t(64) << 20;
+
+		if (!PyArg_ParseTupleAndKeywords(in_args, in_kwargs, "|On", const_cast<char **>(set_result_cache_keywords), &path_object, &max_bytes))
+		{
+			return nullptr;
+		}
+
+		if (max_bytes < 0)
+		{
+			PyErr_SetString(PyExc_ValueError, "max_bytes must not be negative");
+			return nullptr;
+		}
+
+		std::shared_ptr<ResultCache> cache;
+
+		if (path_object && path_object != Py_None)
+		{
+			PyObject * path_bytes = nullptr;
+			if (!PyUnicode_FSConverter(path_object, &path_bytes))
+			{
+				return nullptr;
+			}
+
+			auto const path = fs::u8path(PyBytes_AS_STRING(path_bytes));
+			Py_DECREF(path_bytes);
+
+			std::string error;
+
+			Py_BEGIN_ALLOW_THREADS
+			try
+			{
+				cache = std::make_shared<ResultCache>(path, size_t(max_bytes));
+			}
+			catch (...)
+			{
+				error = CurrentErrorMessage();
+			}
+			Py_END_ALLOW_THREADS
+
+			if (!error.empty())
+			{
+				PyErr_SetString(PyExc_RuntimeError, error.c_str());
+				return nullptr;
+			}
+		}
+
+		// The previous cache is persisted once the last detection using it is done
+		std::swap(result_cache, cache);
+
+		Py_BEGIN_ALLOW_THREADS
+		cache.reset();
+		Py_END_ALLOW_THREADS
+
+		Py_RETURN_NONE;
+	}
+
+	PyObject * SaveResultCache(PyObject *, PyObject *)
+	{
+		auto const cache = result_cache;
+		bool is_saved = true;
+
+		if (cache)
+		{
+			Py_BEGIN_ALLOW_THREADS
+			is_saved = cache->Save();
+			Py_END_ALLOW_THREADS
+		}
+
+		if (!is_saved)
+		{
+			PyErr_SetString(PyExc_OSError, "Result cache could not be saved!");
+			return nullptr;
+		}
+
+		Py_RETURN_NONE;
+	}
+
+	PyObject * ResultCacheStats(PyObject *, PyObject *)
+	{
+		auto const counters = result_cache ? result_cache->Counters() : ResultCacheCounters{};
+
+		return Py_BuildValue("{s:n,s:n,s:n,s:n,s:n}",
+			"hits", Py_ssize_t(counters.hits),
+			"misses", Py_ssize_t(counters.misses),
+			"evictions", Py_ssize_t(counters.evictions),
+			"entries", Py_ssize_t(counters.entry_count),
+			"bytes", Py_ssize_t(counters.size));
+	}
+
+	PyObject * SetThreadCount(PyObject *, PyObject * in_args, PyObject * in_kwargs)
+	{
+		int thread_count = 0;
+		int opencv_thread_count = 1;
+
+		if (!PyArg_ParseTupleAndKeywords(in_args, in_kwargs, "i|i", const_cast<char **>(set_thread_count_keywords), &thread_count, &opencv_thread_count))
+		{
+			return nullptr;
+		}
+
+		ConfigureTaskScheduler(size_t(std::max(thread_count, 0)), size_t(std::max(opencv_thread_count, 0)));
+
+		Py_RETURN_NONE;
+	}
+
+	PyMethodDef module_methods[] = {
+		{ "detect", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(Detect)), METH_VARARGS | METH_KEYWORDS,
+			"detect(image, params=None, adaptive=False, subpixel=False, scanlines=1)\n\n"
+			"Detects and analyzes the barcode in a uint8 BGR image of shape (height, width, 3), without copying it.\n"
+			"Returns a dict with the candidate regions ('rois'), the index of the barcode among them ('barcode', -1 if none),\n"
+			"its bars and spaces in image coordinates ('segments', empty if it could not be analyzed) and the confidence\n"
+			"of the analysis ('confidence', in adaptive mode)." },
+		{ "detect_batch", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(DetectBatch)), METH_VARARGS | METH_KEYWORDS,
+			"detect_batch(images, params=None, adaptive=False, subpixel=False, scanlines=1)\n\n"
+			"Same as detect for each image of a sequence, in parallel on the native thread pool, returning a list of results." },
+		{ "detect_file", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(DetectFile)), METH_VARARGS | METH_KEYWORDS,
+			"detect_file(path, params=None, adaptive=False, subpixel=False, scanlines=1)\n\n"
+			"Same as detect for the image file at the path, which is only decoded if the result cache has no result for its bytes\n"
+			"and the same parameters yet." },
+		{ "detect_encoded", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(DetectEncoded)), METH_VARARGS | METH_KEYWORDS,
+			"detect_encoded(data, params=None, adaptive=False, subpixel=False, scanlines=1)\n\n"
+			"Same as detect_file for the bytes of an encoded image file (any bytes-like object)." },
+		{ "set_result_cache", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(SetResultCache)), METH_VARARGS | METH_KEYWORDS,
+			"set_result_cache(path=None, max_bytes=64 MiB)\n\n"
+			"Caches the results of detect_file and detect_encoded by the bytes of the images and the parameters, in a cache persisted\n"
+			"to the file at the path, loading its entries if it exists. The least recently used results are evicted beyond max_bytes.\n"
+			"The previous cache, if any, is saved and replaced, and None disables caching." },
+		{ "save_result_cache", SaveResultCache, METH_NOARGS,
+			"save_result_cache()\n\n"
+			"Saves the result cache to its file, which is otherwise only done when it is replaced or the module is unloaded." },
+		{ "result_cache_stats", ResultCacheStats, METH_NOARGS,
+			"result_cache_stats()\n\n"
+			"Returns a dict with the hits, misses and evictions of the result cache since it was set, and the number of entries it holds\n"
+			"and their size ('entries' and 'bytes'), all 0 if there is no cache." },
+		{ "set_thread_count", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(SetThreadCount)), METH_VARARGS | METH_KEYWORDS,
+			"set_thread_count(count, opencv_count=1)\n\n"
+			"Sets the number of threads shared by the detector and OpenCV, 0 for the number of hardware threads, OpenCV running on\n"
+			"opencv_count of them (0 for all) and the detector on as many as can each run OpenCV at once within the count.\n"
+			"The default keeps OpenCV serial, for detect_batch to run images in parallel, while a single detect gains from more.\n"
+			"Detections already running finish on the threads they started with." },
+		{ nullptr, nullptr, 0, nullptr }
+	};
+
+	PyModuleDef module_definition = {
+		PyModuleDef_HEAD_INIT,
+		"barcode_detector",
+		"Barcode detection of VCOM_project_1 on NumPy images",
+		-1,
+		module_methods
+	};
+}
+
+PyMODINIT_FUNC PyInit_barcode_detector()
+{
+	import_array();
+
+	ROI_descr = NewRecordDescr(Py_BuildValue("[(ss)(ss)(ss)(ss)(ss)(ss)]",
+		"x", "<i4", "y", "<i4", "width", "<i4", "height", "<i4", "x_response", "<i4", "y_response", "<i4"));
+	segment_descr = NewRecordDescr(Py_BuildValue("[(ss)(ss)(ss)(ss)(ss)]",
+		"start", "<f8", "end", "<f8", "width_percent", "<f8", "is_bar", "?", "agreement", "<f8"));
+
+	if (!ROI_descr || !segment_descr)
+	{
+		return nullptr;
+	}
+
+	return PyModule_Create(&module_definition);
+}
@@ -1,10 +1,12 @@
 import os
+import tempfile
 import time
-from collections import Counter
 
 import numpy as np
 import cv2 as cv
 
+import lndb_native
+
 from scripts import calcFleischner as calc
 from scripts import utils
 
@@ -68,16 +70,17 @@ def load_data(path):
 
 
 def process_data_2d(ct_scans, ct_segmentations, path, image_size=512, load_processed=True, save_processed=True):
+    store_path = 'cache/processed_data_2d.lnds'
+
     images = np.zeros(dtype=np.float32, shape=(0, image_size, image_size, 1))
     labels = np.zeros(dtype=np.int32, shape=(0,))
 
-    if load_processed and os.path.exists('cache/processed_data_2d.npz'):
+    if load_processed and os.path.exists(store_path):
         print('Loading processed data...')
 
-        archive = np.load('cache/processed_data_2d.npz')
-
-        images = archive['images']
-        labels = archive['labels']
+        # Samples are only read from the mapped store, and decoded, once batched
+        images = lndb_native.SampleStore(store_path)
+        labels = images.labels
 
         print('Loading finished!')
     else:
@@ -91,14 +94,15 @@ def process_data_2d(ct_scans, ct_segmentations, path, image_size=512, load_proce
         labels.resize((100,), refcheck=False)
 
         for ct in ct_scans:
-            scan, spacing, origin, transfmat = utils.readMhd(os.path.join(path, 'data', '{}.mhd'.format(ct)))
+            # Only the slices of the findings are read from the mapped scan
+            volume, spacing, origin, transfmat = utils.openMhd(os.path.join(path, 'data', '{}.mhd'.format(ct)))
 
             for segmentation in ct_segmentations[ct]['findings']:
                 transfmat_toimg, transfmat_toworld = utils.getImgWorldTransfMats(spacing, transfmat)
                 xyz = utils.convertToImgCoord(np.array(segmentation['xyz']), origin, transfmat_toimg)
                 z = int(xyz[2])
 
-                scan_image = scan[z]
+                scan_image = volume.slice(z)
                 scan_label = calc.calcNodTexClass(np.array([segmentation['texture']]))
 
                 scan_image = cv.resize(scan_image, dsize=(image_size, image_size), interpolation=cv.INTER_AREA)
@@ -124,9 +128,9 @@ def process_data_2d(ct_scans, ct_segmentations, path, image_size=512, load_proce
         if save_processed:
             print('Saving processed data...\t\t\t\t')
 
-            np.savez_compressed('cache/processed_data_2d.npz',
-                                images=images,
-                                labels=labels)
+            # Images are normalised to [0, 1], so quantising them to 8 bits keeps them within 0.5/255
+            images = lndb_native.write_sample_store(store_path, images, labels, encoding='uint8')
+            labels = images.labels
 
             print('Saving finished!')
 
@@ -141,16 +145,14 @@ def process_data_2d(ct_scans, ct_segmentations, path, image_size=512, load_proce
 
 
 def process_data_3d(ct_scans, ct_segmentations, path, image_size=512, load_processed=True, save_processed=True):
-    images = np.zeros(dtype=np.float32, shape=(0, image_size, image_size, image_size, 1))
-    labels = np.zeros(dtype=np.int32, shape=(0,))
+    store_path = 'cache/processed_data_3d.lnds'
 
-    if load_processed and os.path.exists('cache/processed_data_3d.npz'):
+    if load_processed and os.path.exists(store_path):
         print('Loading processed data...')
 
-        archive = np.load('cache/processed_data_3d.npz')
-
-        images = archive['images']
-        labels = archive['labels']
+        # Samples are only read from the mapped store, and decoded, once batched
+        store = lndb_native.SampleStore(store_path)
+        images, labels = store, store.labels
 
         print('Loading finished!')
     else:
@@ -158,59 +160,30 @@ def process_data_3d(ct_scans, ct_segmentations, path, image_size=512, load_proce
 
         start_time = time.perf_counter()
 
-        index = 0
-
-        images.resize((100,) + images.shape[1:], refcheck=False)
-        labels.resize((100,), refcheck=False)
-
-        for ct in ct_scans:
-            scan, spacing, origin, transfmat = utils.readMhd(os.path.join(path, 'data', '{}.mhd'.format(ct)))
-
-            scan_image = np.zeros(dtype=np.float32, shape=(image_size, image_size, image_size))
-            scan_label = ct_segmentations[ct]['class']
-
-            z_step = scan.shape[0] / image_size
-
-            z_index = 0
-            z = 0
-
-            while z < scan.shape[0]:
-                # Extract section and resize it
-                scan_section = cv.resize(scan[int(z)], dsize=(image_size, image_size), interpolation=cv.INTER_AREA)
-
-                # Normalize values
-                scan_section = scan_section - np.min(scan_section)
-                section_max = np.max(scan_section)
-                scan_section = scan_section / section_max if section_max else 0
-
-                scan_image[z_index] = scan_section
-
-                z_index += 1
-                z = z_index * z_step
-
-            images[index] = scan_image.reshape((image_size, image_size, image_size, 1))
-            labels[index] = scan_label
-
-            index += 1
-
-            print('Current data processed: {}'.format(index), end='\r', flush=True)
-
-            if index == images.shape[0]:
-                images.resize((index + 100,) + images.shape[1:], refcheck=False)
-                labels.resize((index + 100,), refcheck=False)
+        scan_paths = [os.path.join(path, 'data', '{}.mhd'.format(ct)) for ct in ct_scans]
+        scan_labels = [ct_segmentations[ct]['class'] for ct in ct_scans]
 
+        # Scans are processed in parallel and streamed to disk as they finish, so they never all sit in memory
         if save_processed:
-            print('Saving processed data...\t\t\t\t')
-
-            np.savez_compressed('cache/processed_data_3d.npz',
-                                images=images,
-                                labels=labels)
-
-            print('Saving finished!')
+            store = lndb_native.preprocess_volumes(scan_paths, scan_labels, store_path, image_size, encoding='uint8')
+            images, labels = store, store.labels
+        else:
+            # Without saving, they are streamed to a temporary store instead, which is read into memory and removed
+            temp_file, temp_path = tempfile.mkstemp(suffix='.lnds')
+            os.close(temp_file)
+
+            try:
+                store = lndb_native.preprocess_volumes(scan_paths, scan_labels, temp_path, image_size)
+                images, labels = np.array(store.images), np.array(store.labels)
+
+                # The file can only be removed once unmapped, on Windows
+                del store
+            finally:
+                os.remove(temp_path)
 
         end_time = time.perf_counter()
 
-        print('Total data processed: {}'.format(index))
+        print('Total data processed: {}'.format(len(images)))
         print('Total time elapsed: {}s'.format(end_time - start_time))
 
         print('Processing finished!')
@@ -218,47 +191,26 @@ def process_data_3d(ct_scans, ct_segmentations, path, image_size=512, load_proce
     return images, labels
 
 
-def prepare_data(images, labels, split_ratio=0.9, should_balance=False):
+def prepare_data(images, labels, batch_size, split_ratio=0.9, validation_ratio=0.1, should_balance=False):
     print('Preparing data...')
 
-    if should_balance:
-        classes = Counter(labels.tolist())
-        indexes = {}
-
-        for c in classes:
-            index_mask = np.array(labels == c)
-            indexes[c] = np.array(range(len(index_mask)))[index_mask]
-
-        # Naive oversampling to balance data
-        max_value = max(classes.values())
-
-        for c in classes:
-            if classes[c] != max_value:
-                old_size = images.shape[0]
-                new_size = old_size + max_value - classes[c]
-
-                images.resize((new_size,) + images.shape[1:], refcheck=False)
-                labels.resize((new_size,), refcheck=False)
-
-                for i in range(old_size, new_size):
-                    index = np.random.choice(indexes[c])
-                    images[i] = images[index]
-                    labels[i] = labels[index]
-
-    labels = labels.reshape((labels.shape[0], 1))
-
-    # Shuffle the data
-    permutation1 = np.random.permutation(len(images))
-    permutation2 = np.random.permutation(len(images))
+    # Samples are only split by index, since the images may be a read-only mapped store
+    indexes = np.random.permutation(len(images))
 
-    images = images[permutation1][permutation2]
-    labels = labels[permutation1][permutation2]
+    split_len = int(len(indexes) * split_ratio)
+    validation_len = int(split_len * validation_ratio)
 
-    split_len = int(len(images) * split_ratio)
+    train_indexes = indexes[:split_len - validation_len]
+    validation_indexes = indexes[split_len - validation_len:split_len]
+    test_indexes = indexes[split_len:]
 
-    train_images, train_labels = images[:split_len], labels[:split_len]
-    test_images, test_labels = images[split_len:], labels[split_len:]
+    # Batches are gathered by index in the background as they are consumed, and training batches are balanced by naive oversampling
+    # and shuffled anew every epoch, so the images are never copied as a whole
+    # Small datasets can leave the validation or test split empty, in which case there is nothing to load and its loader is None
+    train_batches = lndb_native.BatchLoader(images, labels, train_indexes, batch_size, balance=should_balance)
+    validation_batches = lndb_native.BatchLoader(images, labels, validation_indexes, batch_size, shuffle=False) if len(validation_indexes) > 0 else None
+    test_batches = lndb_native.BatchLoader(images, labels, test_indexes, batch_size, shuffle=False) if len(test_indexes) > 0 else None
 
     print('Preparing finished!')
 
-    return (train_images, train_labels), (test_images, test_labels)
+    return train_batches, validation_batches, test_batches
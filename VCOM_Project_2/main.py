@@ -16,7 +16,7 @@ def texture_characterization(dataset_path):
 
     scans, segmentations = dt.load_data(path=dataset_path)
     images, labels = dt.process_data_2d(scans, segmentations, path=dataset_path, image_size=128)
-    (train_images, train_labels), (test_images, test_labels) = dt.prepare_data(images, labels, should_balance=True)
+    train_batches, validation_batches, test_batches = dt.prepare_data(images, labels, batch_size=30, should_balance=True)
 
     model, loaded = mdl.load_model('texture')
     if not loaded:
@@ -27,17 +27,19 @@ def texture_characterization(dataset_path):
     if not loaded:
         start_time = time.perf_counter()
 
-        history = model.fit(train_images, train_labels,
-                            batch_size=30,
+        history = model.fit(train_batches,
+                            steps_per_epoch=len(train_batches),
                             epochs=60,
-                            validation_split=0.10)
+                            validation_data=validation_batches,
+                            validation_steps=len(validation_batches) if validation_batches is not None else None)
 
         end_time = time.perf_counter()
 
         print('Total time elapsed: {}s'.format(end_time - start_time))
 
         plt.plot(history.history['accuracy'], label='accuracy')
-        plt.plot(history.history['val_accuracy'], label='val_accuracy')
+        if 'val_accuracy' in history.history:
+            plt.plot(history.history['val_accuracy'], label='val_accuracy')
         plt.xlabel('Epoch')
         plt.ylabel('Accuracy')
         plt.ylim([0, 1])
@@ -46,11 +48,13 @@ def texture_characterization(dataset_path):
 
         mdl.save_model(model, 'texture')
 
-    score = model.evaluate(test_images, test_labels,
-                           verbose=0)
+    if test_batches is not None:
+        score = model.evaluate(test_batches,
+                               steps=len(test_batches),
+                               verbose=0)
 
-    print(model.metrics_names)
-    print(score)
+        print(model.metrics_names)
+        print(score)
 
 
 def fleischner_classification(dataset_path):
@@ -61,7 +65,7 @@ def fleischner_classification(dataset_path):
 
     scans, segmentations = dt.load_data(path=dataset_path)
     images, labels = dt.process_data_3d(scans, segmentations, path=dataset_path, image_size=64)
-    (train_images, train_labels), (test_images, test_labels) = dt.prepare_data(images, labels, should_balance=True)
+    train_batches, validation_batches, test_batches = dt.prepare_data(images, labels, batch_size=15, should_balance=True)
 
     model, loaded = mdl.load_model('fleischner')
     if not loaded:
@@ -72,17 +76,19 @@ def fleischner_classification(dataset_path):
     if not loaded:
         start_time = time.perf_counter()
 
-        history = model.fit(train_images, train_labels,
-                            batch_size=15,
+        history = model.fit(train_batches,
+                            steps_per_epoch=len(train_batches),
                             epochs=60,
-                            validation_split=0.10)
+                            validation_data=validation_batches,
+                            validation_steps=len(validation_batches) if validation_batches is not None else None)
 
         end_time = time.perf_counter()
 
         print('Total time elapsed: {}s'.format(end_time - start_time))
 
         plt.plot(history.history['accuracy'], label='accuracy')
-        plt.plot(history.history['val_accuracy'], label='val_accuracy')
+        if 'val_accuracy' in history.history:
+            plt.plot(history.history['val_accuracy'], label='val_accuracy')
         plt.xlabel('Epoch')
         plt.ylabel('Accuracy')
         plt.ylim([0, 1])
@@ -91,11 +97,13 @@ def fleischner_classification(dataset_path):
 
         mdl.save_model(model, 'fleischner')
 
-    score = model.evaluate(test_images, test_labels,
-                           verbose=0)
+    if test_batches is not None:
+        score = model.evaluate(test_batches,
+                               steps=len(test_batches),
+                               verbose=0)
 
-    print(model.metrics_names)
-    print(score)
+        print(model.metrics_names)
+        print(score)
 
 
 if __name__=='__main__':
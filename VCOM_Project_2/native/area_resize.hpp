@@ -0,0 +1,14 @@
+#ifndef AREA_RESIZE_HEADER
+#define AREA_RESIZE_HEADER
+
+#include <cstddef>
+#include <vector>
+
+// Same as cv::resize with cv::INTER_AREA on a single channel image, including its rounding of integer elements, without depending on OpenCV
+// The source rows are the specified number of elements apart, while the destination ones are contiguous
+template <typename T>
+void ResizeArea(T const * in_src, size_t in_src_width, size_t in_src_height, size_t in_src_row_stride, T * out_dst, size_t in_dst_width, size_t in_dst_height);
+
+#include "area_resize.tpp"
+
+#endif
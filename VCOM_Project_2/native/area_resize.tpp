@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace AreaResizeDetail
+{
+	// Same as cv::saturate_cast from the working type, which rounds half to even
+	template <typename T, typename W>
+	T SaturateCast(W in_value) noexcept
+	{
+		if constexpr (std::is_floating_point_v<T>)
+		{
+			return T(in_value);
+		}
+		else
+		{
+			auto const rounded = std::nearbyint(double(in_value));
+			return T(std::clamp(rounded, double(std::numeric_limits<T>::lowest()), double(std::numeric_limits<T>::max())));
+		}
+	}
+
+	// OpenCV accumulates in double for double images only
+	template <typename T>
+	using WorkType = std::conditional_t<std::is_same_v<T, double>, double, float>;
+
+	struct AreaWeight
+	{
+		size_t dst_idx;
+		size_t src_idx;
+		float alpha;
+	};
+
+	// Source elements covering each destination element and the fraction of it they cover, as computed by OpenCV
+	inline std::vector<AreaWeight> ComputeAreaWeights(size_t in_src_size, size_t in_dst_size, double in_scale)
+	{
+		std::vector<AreaWeight> weights;
+		weights.reserve(in_dst_size * (size_t(std::ceil(in_scale)) + 2));
+
+		auto const src_size = std::ptrdiff_t(in_src_size);
+
+		for (size_t dst_idx = 0; dst_idx < in_dst_size; ++dst_idx)
+		{
+			double const fsrc1 = double(dst_idx) * in_scale;
+			double const fsrc2 = fsrc1 + in_scale;
+			double const cell_width = std::min(in_scale, double(src_size) - fsrc1);
+
+			auto src2 = std::min(std::ptrdiff_t(std::floor(fsrc2)), src_size - 1);
+			auto src1 = std::min(std::ptrdiff_t(std::ceil(fsrc1)), src2);
+
+			if (double(src1) - fsrc1 > 1e-3)
+			{
+				weights.push_back({ dst_idx, size_t(src1 - 1), float((double(src1) - fsrc1) / cell_width) });
+			}
+			for (auto src_idx = src1; src_idx < src2; ++src_idx)
+			{
+				weights.push_back({ dst_idx, size_t(src_idx), float(1.0 / cell_width) });
+			}
+			if (fsrc2 - double(src2) > 1e-3)
+			{
+				weights.push_back({ dst_idx, size_t(src2), float(std::min(std::min(fsrc2 - double(src2), 1.0), cell_width) / cell_width) });
+			}
+		}
+		return weights;
+	}
+
+	// Downscaling by integer factors averages whole blocks
+	template <typename T>
+	void ResizeAreaFast(T const * in_src, size_t in_src_row_stride, T * out_dst, size_t in_dst_width, size_t in_dst_height, size_t in_scale_x, size_t in_scale_y)
+	{
+		using W = WorkType<T>;
+
+		// OpenCV's vectorised halving of 8 and 16-bit integers rounds half up instead
+		constexpr bool rounds_half_up = std::is_integral_v<T> && sizeof(T) <= 2;
+		bool const is_halving = in_scale_x == 2 && in_scale_y == 2;
+
+		auto const scale = W(1) / W(in_scale_x * in_scale_y);
+
+		for (size_t dst_y = 0; dst_y < in_dst_height; ++dst_y)
+		{
+			auto const src_rows = in_src + dst_y * in_scale_y * in_src_row_stride;
+			auto const dst_row = out_dst + dst_y * in_dst_width;
+
+			for (size_t dst_x = 0; dst_x < in_dst_width; ++dst_x)
+			{
+				auto const block = src_rows + dst_x * in_scale_x;
+
+				if (rounds_half_up && is_halving)
+				{
+					auto const sum = int(block[0]) + int(block[1]) + int(block[in_src_row_stride]) + int(block[in_src_row_stride + 1]);
+					dst_row[dst_x] = T((sum + 2) >> 2);
+					continue;
+				}
+
+				// Its vectorised halving of floats sums each row first
+				if (std::is_floating_point_v<T> && is_halving)
+				{
+					auto const sum = (W(block[0]) + W(block[1])) + (W(block[in_src_row_stride]) + W(block[in_src_row_stride + 1]));
+					dst_row[dst_x] = SaturateCast<T>(sum * scale);
+					continue;
+				}
+
+				W sum = 0;
+				for (size_t y = 0; y < in_scale_y; ++y)
+				{
+					for (size_t x = 0; x < in_scale_x; ++x)
+					{
+						sum += W(block[y * in_src_row_stride + x]);
+					}
+				}
+				dst_row[dst_x] = SaturateCast<T>(sum * scale);
+			}
+		}
+	}
+
+	// Any other downscaling weighs each source element by the area of the destination element it covers
+	template <typename T>
+	void ResizeAreaWeighted(T const * in_src, size_t in_src_width, size_t in_src_height, size_t in_src_row_stride, T * out_dst, size_t in_dst_width, size_t in_dst_height)
+	{
+		using W = WorkType<T>;
+
+		auto const x_weights = ComputeAreaWeights(in_src_width, in_dst_width, double(in_src_width) / double(in_dst_width));
+		auto const y_weights = ComputeAreaWeights(in_src_height, in_dst_height, double(in_src_height) / double(in_dst_height));
+
+		std::vector<W> row_sums(in_dst_width);
+		std::vector<W> sums(in_dst_width, W(0));
+
+		auto dst_y = y_weights.front().dst_idx;
+
+		for (auto const & y_weight : y_weights)
+		{
+			auto const src_row = in_src + y_weight.src_idx * in_src_row_stride;
+
+			std::fill(row_sums.begin(), row_sums.end(), W(0));
+			for (auto const & x_weight : x_weights)
+			{
+				row_sums[x_weight.dst_idx] += W(src_row[x_weight.src_idx]) * W(x_weight.alpha);
+			}
+
+			auto const beta = W(y_weight.alpha);
+
+			// Each destination row is written once the rows covering it are all summed
+			if (y_weight.dst_idx != dst_y)
+			{
+				auto const dst_row = out_dst + dst_y * in_dst_width;
+
+				for (size_t dst_x = 0; dst_x < in_dst_width; ++dst_x)
+				{
+					dst_row[dst_x] = SaturateCast<T>(sums[dst_x]);
+					sums[dst_x] = beta * row_sums[dst_x];
+				}
+				dst_y = y_weight.dst_idx;
+			}
+			else
+			{
+				for (size_t dst_x = 0; dst_x < in_dst_width; ++dst_x)
+				{
+					sums[dst_x] += beta * row_sums[dst_x];
+				}
+			}
+		}
+
+		auto const dst_row = out_dst + dst_y * in_dst_width;
+		for (size_t dst_x = 0; dst_x < in_dst_width; ++dst_x)
+		{
+			dst_row[dst_x] = SaturateCast<T>(sums[dst_x]);
+		}
+	}
+
+	struct LinearWeight
+	{
+		size_t src_idx;
+		size_t next_src_idx;
+		float alpha; // Of the next source element
+	};
+
+	// Source elements interpolated for each destination element, with the coefficients OpenCV uses for area interpolation when upscaling
+	inline std::vector<LinearWeight> ComputeLinearWeights(size_t in_src_size, size_t in_dst_size)
+	{
+		std::vector<LinearWeight> weights(in_dst_size);
+
+		double const scale = double(in_src_size) / double(in_dst_size);
+		double const inv_scale = double(in_dst_size) / double(in_src_size);
+
+		for (size_t dst_idx = 0; dst_idx < in_dst_size; ++dst_idx)
+		{
+			auto src_idx = std::ptrdiff_t(std::floor(double(dst_idx) * scale));
+			auto alpha = float(double(dst_idx + 1) - double(src_idx + 1) * inv_scale);
+			alpha = alpha <= 0.0f ? 0.0f : alpha - std::floor(alpha);
+
+			if (src_idx < 0)
+			{
+				src_idx = 0;
+				alpha = 0.0f;
+			}
+			if (src_idx >= std::ptrdiff_t(in_src_size) - 1)
+			{
+				src_idx = std::ptrdiff_t(in_src_size) - 1;
+				alpha = 0.0f;
+			}
+
+			weights[dst_idx] = { size_t(src_idx), std::min(size_t(src_idx) + 1, in_src_size - 1), alpha };
+		}
+		return weights;
+	}
+
+	template <typename T>
+	void ResizeAreaLinear(T const * in_src, size_t in_src_width, size_t in_src_height, size_t in_src_row_stride, T * out_dst, size_t in_dst_width, size_t in_dst_height)
+	{
+		using W = WorkType<T>;
+
+		auto const x_weights = ComputeLinearWeights(in_src_width, in_dst_width);
+		auto const y_weights = ComputeLinearWeights(in_src_height, in_dst_height);
+
+		std::vector<W> row0(in_dst_width);
+		std::vector<W> row1(in_dst_width);
+
+		auto const interpolate_row = [&](size_t in_src_y, std::vector<W> & out_row)
+		{
+			auto const src_row = in_src + in_src_y * in_src_row_stride;
+
+			for (size_t dst_x = 0; dst_x < in_dst_width; ++dst_x)
+			{
+				auto const & weight = x_weights[dst_x];
+				out_row[dst_x] = W(src_row[weight.src_idx]) * W(1.0f - weight.alpha) + W(src_row[weight.next_src_idx]) * W(weight.alpha);
+			}
+		};
+
+		for (size_t dst_y = 0; dst_y < in_dst_height; ++dst_y)
+		{
+			auto const & weight = y_weights[dst_y];
+
+			interpolate_row(weight.src_idx, row0);
+			interpolate_row(weight.next_src_idx, row1);
+
+			auto const dst_row = out_dst + dst_y * in_dst_width;
+			for (size_t dst_x = 0; dst_x < in_dst_width; ++dst_x)
+			{
+				dst_row[dst_x] = SaturateCast<T>(W(1.0f - weight.alpha) * row0[dst_x] + W(weight.alpha) * row1[dst_x]);
+			}
+		}
+	}
+}
+
+template <typename T>
+void ResizeArea(T const * in_src, size_t in_src_width, size_t in_src_height, size_t in_src_row_stride, T * out_dst, size_t in_dst_width, size_t in_dst_height)
+{
+	using namespace AreaResizeDetail;
+
+	if (in_src_width == in_dst_width && in_src_height == in_dst_height)
+	{
+		for (size_t y = 0; y < in_dst_height; ++y)
+		{
+			std::copy(in_src + y * in_src_row_stride, in_src + y * in_src_row_stride + in_src_width, out_dst + y * in_dst_width);
+		}
+		return;
+	}
+
+	double const scale_x = double(in_src_width) / double(in_dst_width);
+	double const scale_y = double(in_src_height) / double(in_dst_height);
+
+	if (scale_x < 1.0 || scale_y < 1.0)
+	{
+		ResizeAreaLinear(in_src, in_src_width, in_src_height, in_src_row_stride, out_dst, in_dst_width, in_dst_height);
+		return;
+	}
+
+	auto const integer_scale_x = std::round(scale_x);
+	auto const integer_scale_y = std::round(scale_y);
+
+	if (std::abs(scale_x - integer_scale_x) < DBL_EPSILON && std::abs(scale_y - integer_scale_y) < DBL_EPSILON)
+	{
+		ResizeAreaFast(in_src, in_src_row_stride, out_dst, in_dst_width, in_dst_height, size_t(integer_scale_x), size_t(integer_scale_y));
+		return;
+	}
+
+	ResizeAreaWeighted(in_src, in_src_width, in_src_height, in_src_row_stride, out_dst, in_dst_width, in_dst_height);
+}
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+#include "batch_loader.hpp"
+#include "parallel.hpp"
+
+BatchLoader::BatchLoader(SampleSource const & in_source, std::vector<std::int32_t> in_labels, std::vector<size_t> in_indices, size_t in_batch_size,
+	bool is_balanced, bool is_shuffled, std::uint64_t in_seed, size_t in_prefetch_count, size_t in_thread_count)
+	: source{ in_source }
+	, labels{ std::move(in_labels) }
+	, batch_size{ in_batch_size }
+	, is_shuffled{ is_shuffled }
+	, prefetch_count{ std::max(in_prefetch_count, size_t(1)) }
+	, epoch_size{ 0 }
+	, random_engine{ in_seed }
+	, is_stopping{ false }
+	, pool{ in_thread_count }
+{
+	if (in_indices.empty())
+	{
+		throw std::invalid_argument("there must be at least one sample to load");
+	}
+	if (in_batch_size == 0)
+	{
+		throw std::invalid_argument("batch size must be positive");
+	}
+	if (labels.size() != source.sample_count)
+	{
+		throw std::invalid_argument("there must be one label per sample");
+	}
+
+	for (auto const idx : in_indices)
+	{
+		if (idx >= source.sample_count)
+		{
+			throw std::out_of_range("sample index out of range");
+		}
+	}
+
+	if (is_balanced)
+	{
+		std::map<std::int32_t, std::vector<size_t>> indices_by_label;
+
+		for (auto const idx : in_indices)
+		{
+			indices_by_label[labels[idx]].push_back(idx);
+		}
+
+		size_t max_class_size = 0;
+		for (auto & [label, indices] : indices_by_label)
+		{
+			max_class_size = std::max(max_class_size, indices.size());
+			class_indices.push_back(std::move(indices));
+		}
+
+		epoch_size = class_indices.size() * max_class_size;
+	}
+	else
+	{
+		epoch_size = in_indices.size();
+		class_indices.push_back(std::move(in_indices));
+	}
+
+	thread = std::thread{ &BatchLoader::Run, this };
+}
+
+BatchLoader::~BatchLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		is_stopping = true;
+	}
+	batch_taken.notify_all();
+
+	thread.join();
+}
+
+SampleBatch const & BatchLoader::NextBatch()
+{
+	std::unique_lock<std::mutex> lock{ mutex };
+
+	batch_ready.wait(lock, [this] { return !ready_buffers.empty() || exception; });
+
+	if (ready_buffers.empty())
+	{
+		std::rethrow_exception(exception);
+	}
+
+	auto const & batch = *buffers[ready_buffers.front()];
+	ready_buffers.pop_front();
+
+	lock.unlock();
+	batch_taken.notify_all();
+
+	return batch;
+}
+
+void BatchLoader::ReleaseBatch(SampleBatch const & in_batch) noexcept
+{
+	std::lock_guard<std::mutex> lock{ mutex };
+
+	free_buffers.push_back(in_batch.buffer_idx);
+}
+
+void BatchLoader::Run() noexcept
+{
+	try
+	{
+		size_t epoch_offset = 0;
+
+		for (;;)
+		{
+			if (epoch_offset == epoch_indices.size())
+			{
+				DrawEpoch();
+				epoch_offset = 0;
+			}
+
+			SampleBatch * batch = nullptr;
+
+			// Waits for room ahead of the consumer, then takes a released buffer, or a new one while batches are held on to
+
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+
+				batch_taken.wait(lock, [this] { return is_stopping || ready_buffers.size() < prefetch_count; });
+				if (is_stopping)
+				{
+					return;
+				}
+
+				if (free_buffers.empty())
+				{
+					buffers.push_back(std::make_unique<SampleBatch>());
+					buffers.back()->samples.resize(batch_size * source.sample_size);
+					buffers.back()->labels.resize(batch_size);
+					buffers.back()->buffer_idx = buffers.size() - 1;
+
+					free_buffers.push_back(buffers.back()->buffer_idx);
+				}
+
+				batch = buffers[free_buffers.back()].get();
+				free_buffers.pop_back();
+			}
+
+			// Samples are gathered without the lock held, and in parallel, since reading them may fault pages in from disk
+
+			batch->sample_count = std::min(batch_size, epoch_indices.size() - epoch_offset);
+
+			auto const batch_indices = epoch_indices.data() + epoch_offset;
+
+			pool.ParallelFor(batch->sample_count, [&](size_t idx)
+			{
+				auto const sample = source.data + std::ptrdiff_t(batch_indices[idx]) * source.sample_stride;
+				auto const batch_sample = batch->samples.data() + idx * source.sample_size;
+
+				if (source.encoding == SampleEncoding::Raw)
+				{
+					std::memcpy(batch_sample, sample, source.sample_size);
+				}
+				else
+				{
+					DecodeElements(sample, source.sample_size / sizeof(float), source.encoding, source.scale, source.offset,
+						reinterpret_cast<float *>(batch_sample));
+				}
+
+				batch->labels[idx] = labels[batch_indices[idx]];
+			});
+
+			epoch_offset += batch->sample_count;
+
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				ready_buffers.push_back(batch->buffer_idx);
+			}
+			batch_ready.notify_one();
+		}
+	}
+	catch (...)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			exception = std::current_exception();
+		}
+		batch_ready.notify_one();
+	}
+}
+
+void BatchLoader::DrawEpoch()
+{
+	epoch_indices.clear();
+	epoch_indices.reserve(epoch_size);
+
+	// Every class is drawn whole, then topped up with samples chosen at random from it, as prepare_data oversampled
+
+	size_t const class_size = epoch_size / class_indices.size();
+
+	for (auto const & indices : class_indices)
+	{
+		epoch_indices.insert(epoch_indices.end(), indices.begin(), indices.end());
+
+		std::uniform_int_distribution<size_t> distribution{ 0, indices.size() - 1 };
+
+		for (size_t idx = indices.size(); idx < class_size; ++idx)
+		{
+			epoch_indices.push_back(indices[distribution(random_engine)]);
+		}
+	}
+
+	if (is_shuffled)
+	{
+		std::shuffle(epoch_indices.begin(), epoch_indices.end(), random_engine);
+	}
+}
@@ -0,0 +1,112 @@
+#ifndef BATCH_LOADER_HEADER
+#define BATCH_LOADER_HEADER
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "parallel.hpp"
+#include "sample_encoding.hpp"
+
+// Samples of the same size, read in place, each contiguous in memory but possibly a whole chunk apart (as in a sample store),
+// and possibly encoded float32 samples, decoded as they are gathered
+struct SampleSource
+{
+	std::byte const * data;
+	size_t sample_count;
+	size_t sample_size; // Once decoded
+	std::ptrdiff_t sample_stride;
+	int encoding;
+	float scale;
+	float offset;
+};
+
+// Batch of samples gathered into a buffer of the loader, which is only reused once released
+struct SampleBatch
+{
+	std::vector<std::byte> samples;
+	std::vector<std::int32_t> labels;
+	size_t sample_count;
+	size_t buffer_idx;
+};
+
+// Endless stream of mini-batches of the samples at the specified indices, drawn epoch after epoch by index only, so that no sample is ever
+// copied but into the batches themselves
+// Each epoch is optionally balanced, by oversampling every class (with replacement) up to the size of the largest, and shuffled,
+// the last batch of an epoch holding whatever samples are left
+// Batches are gathered ahead on a background thread, up to the prefetch count, into buffers reused once released, so memory use is bounded
+// by the batches in flight rather than by the number of samples, and in parallel on threads that live as long as the loader
+class BatchLoader
+{
+public:
+	// Throws std::invalid_argument if there are no indices or the batch size is 0, and std::out_of_range if an index is not less than the sample count
+	// (0 threads for the number of hardware threads)
+	BatchLoader(SampleSource const & in_source, std::vector<std::int32_t> in_labels, std::vector<size_t> in_indices, size_t in_batch_size,
+		bool is_balanced, bool is_shuffled, std::uint64_t in_seed, size_t in_prefetch_count, size_t in_thread_count);
+	~BatchLoader();
+
+	BatchLoader(BatchLoader const &) = delete;
+	BatchLoader & operator=(BatchLoader const &) = delete;
+
+	size_t SampleSize() const noexcept
+	{
+		return source.sample_size;
+	}
+	// Number of samples drawn each epoch, after balancing
+	size_t EpochSize() const noexcept
+	{
+		return epoch_size;
+	}
+	size_t BatchesPerEpoch() const noexcept
+	{
+		return (epoch_size + batch_size - 1) / batch_size;
+	}
+
+	// Waits for the next batch, which stays valid until released, rethrowing whatever exception stopped the background thread, if any
+	SampleBatch const & NextBatch();
+	// Hands the buffer of the batch back to the loader, to be reused for a later batch
+	void ReleaseBatch(SampleBatch const & in_batch) noexcept;
+
+private:
+	void Run() noexcept;
+	// Draws the indices of the next epoch
+	void DrawEpoch();
+
+	SampleSource source;
+	std::vector<std::int32_t> labels;
+	size_t batch_size;
+	bool is_shuffled;
+	size_t prefetch_count;
+
+	// Indices of each class, in order of their labels, which are oversampled up to the size of the largest when balancing
+	std::vector<std::vector<size_t>> class_indices;
+	size_t epoch_size;
+
+	// Only touched by the background thread once started
+	std::mt19937_64 random_engine;
+	std::vector<size_t> epoch_indices;
+
+	std::mutex mutex;
+	std::condition_variable batch_ready;
+	std::condition_variable batch_taken;
+	// Buffers are never moved once allocated, since batches handed out point into them
+	std::vector<std::unique_ptr<SampleBatch>> buffers;
+	std::vector<size_t> free_buffers;
+	std::deque<size_t> ready_buffers;
+	std::exception_ptr exception;
+	bool is_stopping;
+
+	// Only used by the background thread, which is stopped before the pool
+	ThreadPool pool;
+	std::thread thread;
+
+};
+
+#endif
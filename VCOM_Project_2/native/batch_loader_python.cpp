@@ -0,0 +1,486 @@
+#include <cstring>
+#include <exception>
+#include <random>
+#include <vector>
+
+#include "batch_loader.hpp"
+#include "python_common.hpp"
+
+namespace
+{
+	struct BatchLoaderObject
+	{
+		PyObject_HEAD
+		BatchLoader * loader;
+		// Array or SampleStore the samples are read from in place, kept alive as long as the loader
+		PyObject * images;
+		// Of the decoded samples
+		PyArray_Descr * descr;
+		int sample_dims;
+		npy_intp sample_shape[NPY_MAXDIMS];
+	};
+
+	char const lease_name[] = "lndb_native.BatchLease";
+
+	BatchLoader * CheckedLoader(PyObject * in_self)
+	{
+		auto const loader = reinterpret_cast<BatchLoaderObject *>(in_self)->loader;
+		if (!loader)
+		{
+			PyErr_SetString(PyExc_ValueError, "BatchLoader was not initialized");
+		}
+		return loader;
+	}
+
+	// Hands the buffer of a batch back to its loader once no array of the batch is left
+	void ReleaseLease(PyObject * in_lease)
+	{
+		auto const owner = static_cast<PyObject *>(PyCapsule_GetContext(in_lease));
+		auto const batch = static_cast<SampleBatch const *>(PyCapsule_GetPointer(in_lease, lease_name));
+
+		reinterpret_cast<BatchLoaderObject *>(owner)->loader->ReleaseBatch(*batch);
+		Py_DECREF(owner);
+	}
+
+	// Array over a batch buffer, which keeps the lease on the buffer alive
+	PyObject * NewBatchArray(PyArray_Descr * in_descr, int in_dims, npy_intp * in_shape, void * in_data, PyObject * in_lease)
+	{
+		if (!in_descr)
+		{
+			return nullptr;
+		}
+
+		// Steals the reference to the descriptor
+		PyObject * array = PyArray_NewFromDescr(&PyArray_Type, in_descr, in_dims, in_shape, nullptr, in_data, NPY_ARRAY_CARRAY, nullptr);
+		if (!array)
+		{
+			return nullptr;
+		}
+
+		Py_INCREF(in_lease);
+		if (PyArray_SetBaseObject(reinterpret_cast<PyArrayObject *>(array), in_lease) != 0)
+		{
+			Py_DECREF(array);
+			return nullptr;
+		}
+
+		return array;
+	}
+
+	// Samples of a SampleStore, decoded as they are read, keeping a reference to the store
+	bool GetStoreSampleSource(PyObject * in_object, SampleSource & out_source, BatchLoaderObject * io_self)
+	{
+		auto const store = GetSampleStore(in_object);
+		if (!store)
+		{
+			return false;
+		}
+
+		auto const & sample_shape = store->SampleShape();
+
+		out_source.data = store->Sample(0);
+		out_source.sample_count = store->SampleCount();
+		out_source.sample_size = store->SampleLength() * ElementSize(store->ElementType());
+		out_source.sample_stride = std::ptrdiff_t(store->SampleStride());
+		out_source.encoding = store->Encoding();
+		out_source.scale = store->Scale();
+		out_source.offset = store->Offset();
+
+		io_self->descr = NewElementDescr(store->ElementType(), false);
+		if (!io_self->descr)
+		{
+			return false;
+		}
+
+		Py_INCREF(in_object);
+		io_self->images = in_object;
+		io_self->sample_dims = int(sample_shape.size());
+		for (size_t axis = 0; axis < sample_shape.size(); ++axis)
+		{
+			io_self->sample_shape[axis] = npy_intp(sample_shape[axis]);
+		}
+
+		return true;
+	}
+
+	// Samples of an array along its first axis, read in place if each sample is contiguous (as in a sample store), or else from a contiguous copy,
+	// keeping a reference to the array read from
+	bool GetArraySampleSource(PyObject * in_object, SampleSource & out_source, BatchLoaderObject * io_self)
+	{
+		PyObject * images_array = PyArray_FromAny(in_object, nullptr, 1, 0, NPY_ARRAY_ALIGNED, nullptr);
+		if (!images_array)
+		{
+			return false;
+		}
+
+		auto array = reinterpret_cast<PyArrayObject *>(images_array);
+
+		if (PyDataType_REFCHK(PyArray_DESCR(array)))
+		{
+			PyErr_SetString(PyExc_ValueError, "images must not be an array of objects");
+			Py_DECREF(images_array);
+			return false;
+		}
+
+		auto stride = npy_intp(PyArray_ITEMSIZE(array));
+		for (auto axis = PyArray_NDIM(array) - 1; axis > 0; --axis)
+		{
+			if (PyArray_DIM(array, axis) > 1 && PyArray_STRIDE(array, axis) != stride)
+			{
+				PyObject * copy = PyArray_NewCopy(array, NPY_CORDER);
+
+				Py_DECREF(images_array);
+				images_array = copy;
+				if (!images_array)
+				{
+					return false;
+				}
+
+				array = reinterpret_cast<PyArrayObject *>(images_array);
+				break;
+			}
+
+			stride *= PyArray_DIM(array, axis);
+		}
+
+		out_source.data = static_cast<std::byte const *>(PyArray_DATA(array));
+		out_source.sample_count = size_t(PyArray_DIM(array, 0));
+		out_source.sample_size = size_t(PyArray_ITEMSIZE(array));
+		out_source.sample_stride = std::ptrdiff_t(PyArray_STRIDE(array, 0));
+
+		out_source.encoding = SampleEncoding::Raw;
+		out_source.scale = 1.0f;
+		out_source.offset = 0.0f;
+
+		for (auto axis = 1; axis < PyArray_NDIM(array); ++axis)
+		{
+			out_source.sample_size *= size_t(PyArray_DIM(array, axis));
+		}
+
+		auto const descr = PyArray_DESCR(array);
+		Py_INCREF(descr);
+
+		io_self->images = images_array;
+		io_self->descr = descr;
+		io_self->sample_dims = PyArray_NDIM(array) - 1;
+		std::memcpy(io_self->sample_shape, PyArray_SHAPE(array) + 1, size_t(io_self->sample_dims) * sizeof(npy_intp));
+
+		return true;
+	}
+
+	// Converts an array of one label per sample, of any shape, returning false with a Python exception set on failure
+	bool ConvertLabels(PyObject * in_object, size_t in_sample_count, std::vector<std::int32_t> & out_labels)
+	{
+		PyObject * array = PyArray_FROM_OTF(in_object, NPY_INT32, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+		if (!array)
+		{
+			return false;
+		}
+
+		auto const labels_array = reinterpret_cast<PyArrayObject *>(array);
+
+		if (size_t(PyArray_SIZE(labels_array)) != in_sample_count)
+		{
+			PyErr_SetString(PyExc_ValueError, "labels must hold one label per image");
+			Py_DECREF(array);
+			return false;
+		}
+
+		auto const labels = static_cast<std::int32_t const *>(PyArray_DATA(labels_array));
+		out_labels.assign(labels, labels + in_sample_count);
+
+		Py_DECREF(array);
+		return true;
+	}
+
+	// Converts an array of sample indices, negative ones counting from the end, or all samples in order if None
+	bool ConvertIndices(PyObject * in_object, size_t in_sample_count, std::vector<size_t> & out_indices)
+	{
+		if (in_object == Py_None)
+		{
+			out_indices.resize(in_sample_count);
+
+			for (size_t idx = 0; idx < in_sample_count; ++idx)
+			{
+				out_indices[idx] = idx;
+			}
+			return true;
+		}
+
+		PyObject * array = PyArray_FROM_OTF(in_object, NPY_INTP, NPY_ARRAY_IN_ARRAY);
+		if (!array)
+		{
+			return false;
+		}
+
+		auto const indices_array = reinterpret_cast<PyArrayObject *>(array);
+
+		if (PyArray_NDIM(indices_array) != 1)
+		{
+			PyErr_SetString(PyExc_ValueError, "indexes must be of shape (count,)");
+			Py_DECREF(array);
+			return false;
+		}
+
+		auto const indices = static_cast<npy_intp const *>(PyArray_DATA(indices_array));
+
+		out_indices.resize(size_t(PyArray_DIM(indices_array, 0)));
+
+		for (size_t idx = 0; idx < out_indices.size(); ++idx)
+		{
+			// Indices still negative once wrapped become out of range
+			out_indices[idx] = indices[idx] < 0 ? size_t(indices[idx] + npy_intp(in_sample_count)) : size_t(indices[idx]);
+		}
+
+		Py_DECREF(array);
+		return true;
+	}
+
+	int Init(PyObject * in_self, PyObject * in_args, PyObject * in_kwargs)
+	{
+		static char const * keywords[] = { "images", "labels", "indexes", "batch_size", "balance", "shuffle", "seed", "prefetch", "threads", nullptr };
+
+		PyObject * images_object = nullptr;
+		PyObject * labels_object = nullptr;
+		PyObject * indices_object = Py_None;
+		Py_ssize_t batch_size = 32;
+		int is_balanced = 0;
+		int is_shuffled = 1;
+		PyObject * seed_object = Py_None;
+		Py_ssize_t prefetch_count = 2;
+		Py_ssize_t thread_count = 0;
+
+		if (!PyArg_ParseTupleAndKeywords(in_args, in_kwargs, "OO|OnppOnn", const_cast<char **>(keywords),
+			&images_object, &labels_object, &indices_object, &batch_size, &is_balanced, &is_shuffled, &seed_object, &prefetch_count, &thread_count))
+		{
+			return -1;
+		}
+
+		auto const self = reinterpret_cast<BatchLoaderObject *>(in_self);
+
+		// Batches of the loader may still be leased, so it cannot be replaced
+		if (self->loader)
+		{
+			PyErr_SetString(PyExc_RuntimeError, "BatchLoader cannot be initialized twice");
+			return -1;
+		}
+
+		if (batch_size <= 0)
+		{
+			PyErr_SetString(PyExc_ValueError, "batch_size must be positive");
+			return -1;
+		}
+		if (prefetch_count <= 0)
+		{
+			PyErr_SetString(PyExc_ValueError, "prefetch must be positive");
+			return -1;
+		}
+		if (thread_count < 0)
+		{
+			PyErr_SetString(PyExc_ValueError, "threads must not be negative");
+			return -1;
+		}
+
+		// Unseeded loaders draw a different order on every run, as NumPy's global generator did
+		std::uint64_t seed = 0;
+		if (seed_object == Py_None)
+		{
+			std::random_device device;
+			seed = (std::uint64_t(device()) << 32) | device();
+		}
+		else
+		{
+			seed = PyLong_AsUnsignedLongLongMask(seed_object);
+			if (PyErr_Occurred())
+			{
+				return -1;
+			}
+		}
+
+		// Any other object than an array must be a store
+		SampleSource source;
+
+		if (PyArray_Check(images_object) ? !GetArraySampleSource(images_object, source, self) : !GetStoreSampleSource(images_object, source, self))
+		{
+			return -1;
+		}
+
+		std::vector<std::int32_t> labels;
+		std::vector<size_t> indices;
+
+		if (!ConvertLabels(labels_object, source.sample_count, labels) || !ConvertIndices(indices_object, source.sample_count, indices))
+		{
+			Py_CLEAR(self->images);
+			Py_CLEAR(self->descr);
+			return -1;
+		}
+
+		try
+		{
+			self->loader = new BatchLoader(source, std::move(labels), std::move(indices), size_t(batch_size), is_balanced != 0, is_shuffled != 0, seed,
+				size_t(prefetch_count), size_t(thread_count));
+		}
+		catch (...)
+		{
+			SetPythonError();
+			Py_CLEAR(self->images);
+			Py_CLEAR(self->descr);
+			return -1;
+		}
+
+		return 0;
+	}
+
+	void Dealloc(PyObject * in_self)
+	{
+		auto const type = Py_TYPE(in_self);
+		auto const self = reinterpret_cast<BatchLoaderObject *>(in_self);
+
+		// The background thread never takes the GIL, and is stopped before the images it reads are released
+		delete self->loader;
+		Py_XDECREF(self->images);
+		Py_XDECREF(self->descr);
+
+		reinterpret_cast<freefunc>(PyType_GetSlot(type, Py_tp_free))(in_self);
+		Py_DECREF(type);
+	}
+
+	Py_ssize_t Length(PyObject * in_self)
+	{
+		auto const loader = CheckedLoader(in_self);
+
+		return loader ? Py_ssize_t(loader->BatchesPerEpoch()) : -1;
+	}
+
+	PyObject * Next(PyObject * in_self)
+	{
+		auto const loader = CheckedLoader(in_self);
+		if (!loader)
+		{
+			return nullptr;
+		}
+
+		SampleBatch const * batch = nullptr;
+		std::exception_ptr exception;
+
+		// The batch is most likely gathered already, but the GIL is released anyway while it might be waited for
+		Py_BEGIN_ALLOW_THREADS
+		try
+		{
+			batch = &loader->NextBatch();
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+		Py_END_ALLOW_THREADS
+
+		if (exception)
+		{
+			try
+			{
+				std::rethrow_exception(exception);
+			}
+			catch (...)
+			{
+				SetPythonError();
+			}
+			return nullptr;
+		}
+
+		// Both arrays of the batch share a lease on its buffer, which keeps the loader alive until they are both released
+
+		PyObject * lease = PyCapsule_New(const_cast<SampleBatch *>(batch), lease_name, ReleaseLease);
+		if (!lease)
+		{
+			loader->ReleaseBatch(*batch);
+			return nullptr;
+		}
+
+		Py_INCREF(in_self);
+		PyCapsule_SetContext(lease, in_self);
+
+		auto const self = reinterpret_cast<BatchLoaderObject *>(in_self);
+
+		npy_intp images_shape[NPY_MAXDIMS + 1];
+		images_shape[0] = npy_intp(batch->sample_count);
+		std::memcpy(images_shape + 1, self->sample_shape, size_t(self->sample_dims) * sizeof(npy_intp));
+
+		npy_intp labels_shape[2] = { npy_intp(batch->sample_count), 1 };
+
+		Py_INCREF(self->descr);
+
+		PyObject * images = NewBatchArray(self->descr, self->sample_dims + 1, images_shape, const_cast<std::byte *>(batch->samples.data()), lease);
+		PyObject * labels = NewBatchArray(PyArray_DescrFromType(NPY_INT32), 2, labels_shape, const_cast<std::int32_t *>(batch->labels.data()), lease);
+
+		Py_DECREF(lease);
+
+		if (!images || !labels)
+		{
+			Py_XDECREF(images);
+			Py_XDECREF(labels);
+			return nullptr;
+		}
+
+		// Steals the references to the arrays
+		return Py_BuildValue("(NN)", images, labels);
+	}
+
+	PyObject * GetEpochSize(PyObject * in_self, void *)
+	{
+		auto const loader = CheckedLoader(in_self);
+
+		return loader ? PyLong_FromSize_t(loader->EpochSize()) : nullptr;
+	}
+
+	PyGetSetDef loader_getset[] = {
+		{ "epoch_size", GetEpochSize, nullptr, "Number of samples drawn each epoch, after balancing", nullptr },
+		{ nullptr, nullptr, nullptr, nullptr, nullptr }
+	};
+
+	PyType_Slot loader_slots[] = {
+		{ Py_tp_doc, const_cast<char *>(
+			"BatchLoader(images, labels, indexes=None, batch_size=32, balance=False, shuffle=True, seed=None, prefetch=2, threads=0)\n\n"
+			"Endless iterator over mini-batches of the images at indexes (all of them if None), as (images, labels) tuples of arrays of shapes\n"
+			"(count,) + image shape and (count, 1), epoch after epoch, len() being the number of batches per epoch.\n"
+			"images is an array or a SampleStore, read in place by index, and decoded if the store is encoded.\n"
+			"Each epoch is drawn anew: balanced if balance is true, by oversampling every class up to the size of the largest\n"
+			"as prepare_data did, and shuffled if shuffle is true.\n"
+			"Up to prefetch batches are gathered ahead on a background thread, with threads threads (0 for the number of hardware threads),\n"
+			"into buffers that are reused once the arrays of their batch are released.") },
+		{ Py_tp_new, reinterpret_cast<void *>(PyType_GenericNew) },
+		{ Py_tp_init, reinterpret_cast<void *>(Init) },
+		{ Py_tp_dealloc, reinterpret_cast<void *>(Dealloc) },
+		{ Py_tp_iter, reinterpret_cast<void *>(PyObject_SelfIter) },
+		{ Py_tp_iternext, reinterpret_cast<void *>(Next) },
+		{ Py_sq_length, reinterpret_cast<void *>(Length) },
+		{ Py_tp_getset, loader_getset },
+		{ 0, nullptr }
+	};
+
+	PyType_Spec loader_spec = {
+		"lndb_native.BatchLoader",
+		sizeof(BatchLoaderObject),
+		0,
+		Py_TPFLAGS_DEFAULT,
+		loader_slots
+	};
+}
+
+bool AddBatchLoaderType(PyObject * io_module)
+{
+	auto const loader_type = PyType_FromSpec(&loader_spec);
+	if (!loader_type)
+	{
+		return false;
+	}
+
+	// Steals the reference to the type on success only
+	if (PyModule_AddObject(io_module, "BatchLoader", loader_type) != 0)
+	{
+		Py_DECREF(loader_type);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include "cube_extraction.hpp"
+#include "parallel.hpp"
+
+namespace
+{
+	// Pole of the quadratic B-spline, 2 * sqrt(2) - 3
+	constexpr double spline_pole = -0.171572875253809902396622551580603843;
+
+	// Coefficients weighing the value at a coordinate, of the nearest spline knot and its neighbours
+	struct SplineTaps
+	{
+		std::array<size_t, 3> idx;
+		std::array<double, 3> weights;
+	};
+
+	// Mirrors indices past the edges onto the line, as SciPy extends spline coefficients
+	size_t MirrorIndex(std::ptrdiff_t in_idx, size_t in_length) noexcept
+	{
+		if (in_length == 1)
+		{
+			return 0;
+		}
+
+		auto const period = std::ptrdiff_t(2 * (in_length - 1));
+		auto const idx = std::abs(in_idx) % period;
+
+		return size_t(idx < std::ptrdiff_t(in_length) ? idx : period - idx);
+	}
+
+	// Taps of each resampled coordinate along an axis, spaced so that the first and last coordinates fall on the first and last voxels
+	std::vector<SplineTaps> ComputeSplineTaps(size_t in_length, size_t in_cube_size)
+	{
+		double const zoom = in_cube_size > 1 ? double(in_length - 1) / double(in_cube_size - 1) : 1.0;
+
+		std::vector<SplineTaps> taps(in_cube_size);
+
+		for (size_t idx = 0; idx < in_cube_size; ++idx)
+		{
+			double const coordinate = double(idx) * zoom;
+			double const knot = std::floor(coordinate + 0.5);
+			double const offset = coordinate - knot;
+
+			auto const first_idx = std::ptrdiff_t(knot) - 1;
+			for (std::ptrdiff_t tap = 0; tap < 3; ++tap)
+			{
+				taps[idx].idx[size_t(tap)] = MirrorIndex(first_idx + tap, in_length);
+			}
+
+			double const before = 0.5 - offset;
+			double const after = 0.5 + offset;
+
+			taps[idx].weights = { 0.5 * before * before, 0.75 - offset * offset, 0.5 * after * after };
+		}
+		return taps;
+	}
+
+	// Turns lines of values into the coefficients of the quadratic spline interpolating them, with mirrored edges as SciPy does
+	// Element i of line l of group g is at io_data[g * group_stride + i * stride + l], each step running over all lines of a group at once
+	void PrefilterAxis(double * io_data, size_t in_group_count, size_t in_group_stride, size_t in_length, size_t in_stride, size_t in_line_count)
+	{
+		if (in_length < 2)
+		{
+			return;
+		}
+
+		double const z = spline_pole;
+		double const gain = (1.0 - z) * (1.0 - 1.0 / z);
+		double const z_n_1 = std::pow(z, double(in_length - 1));
+
+		for (size_t group = 0; group < in_group_count; ++group)
+		{
+			double * const data = io_data + group * in_group_stride;
+			auto const line = [&](size_t in_idx)
+			{
+				return data + in_idx * in_stride;
+			};
+
+			for (size_t idx = 0; idx < in_length; ++idx)
+			{
+				double * const values = line(idx);
+				for (size_t lane = 0; lane < in_line_count; ++lane)
+				{
+					values[lane] *= gain;
+				}
+			}
+
+			// Causal filter, starting from the sum of the mirrored line
+
+			double * const first_values = line(0);
+			double * const last_values = line(in_length - 1);
+
+			for (size_t lane = 0; lane < in_line_count; ++lane)
+			{
+				first_values[lane] += z_n_1 * last_values[lane];
+			}
+
+			double z_i = z;
+			for (size_t idx = 1; idx < in_length - 1; ++idx)
+			{
+				double const * const values = line(idx);
+				double const * const mirrored_values = line(in_length - 1 - idx);
+				for (size_t lane = 0; lane < in_line_count; ++lane)
+				{
+					first_values[lane] += z_i * (values[lane] + z_n_1 * mirrored_values[lane]);
+				}
+				z_i *= z;
+			}
+
+			for (size_t lane = 0; lane < in_line_count; ++lane)
+			{
+				first_values[lane] /= 1.0 - z_n_1 * z_n_1;
+			}
+
+			for (size_t idx = 1; idx < in_length; ++idx)
+			{
+				double * const values = line(idx);
+				double const * const previous_values = line(idx - 1);
+				for (size_t lane = 0; lane < in_line_count; ++lane)
+				{
+					values[lane] += z * previous_values[lane];
+				}
+			}
+
+			// Anti-causal filter, starting from the mirrored edge
+
+			double const * const before_last_values = line(in_length - 2);
+
+			for (size_t lane = 0; lane < in_line_count; ++lane)
+			{
+				last_values[lane] = (z * before_last_values[lane] + last_values[lane]) * z / (z * z - 1.0);
+			}
+
+			for (size_t idx = in_length - 1; idx-- > 0;)
+			{
+				double * const values = line(idx);
+				double const * const next_values = line(idx + 1);
+				for (size_t lane = 0; lane < in_line_count; ++lane)
+				{
+					values[lane] = z * (next_values[lane] - values[lane]);
+				}
+			}
+		}
+	}
+
+	// Resamples the spline coefficients along an axis, with the same layout of groups and lines as for PrefilterAxis
+	void ResampleAxis(double const * in_src, size_t in_src_group_stride, size_t in_src_stride, double * out_dst, size_t in_dst_group_stride, size_t in_dst_stride,
+		size_t in_group_count, std::vector<SplineTaps> const & in_taps, size_t in_line_count)
+	{
+		for (size_t group = 0; group < in_group_count; ++group)
+		{
+			double const * const src = in_src + group * in_src_group_stride;
+			double * const dst = out_dst + group * in_dst_group_stride;
+
+			for (size_t idx = 0; idx < in_taps.size(); ++idx)
+			{
+				auto const & taps = in_taps[idx];
+
+				double const * const values0 = src + taps.idx[0] * in_src_stride;
+				double const * const values1 = src + taps.idx[1] * in_src_stride;
+				double const * const values2 = src + taps.idx[2] * in_src_stride;
+				double * const values = dst + idx * in_dst_stride;
+
+				for (size_t lane = 0; lane < in_line_count; ++lane)
+				{
+					values[lane] = taps.weights[0] * values0[lane] + taps.weights[1] * values1[lane] + taps.weights[2] * values2[lane];
+				}
+			}
+		}
+	}
+
+	// Rounds integers half away from zero, as SciPy does, saturating them to the type
+	template <typename T>
+	T CastVoxel(double in_value) noexcept
+	{
+		if constexpr (std::is_floating_point_v<T>)
+		{
+			return T(in_value);
+		}
+		else
+		{
+			return T(std::clamp(std::round(in_value), double(std::numeric_limits<T>::lowest()), double(std::numeric_limits<T>::max())));
+		}
+	}
+
+	template <typename T>
+	void ExtractCubeTyped(VolumeView const & in_volume, std::array<std::ptrdiff_t, 3> const & in_center, std::array<size_t, 3> const & in_half_size,
+		size_t in_cube_size, bool is_clamped, T * out_cube)
+	{
+		std::array<size_t, 3> const size = { 2 * in_half_size[0], 2 * in_half_size[1], 2 * in_half_size[2] };
+		std::array<std::ptrdiff_t, 3> const begin = {
+			in_center[0] - std::ptrdiff_t(in_half_size[0]),
+			in_center[1] - std::ptrdiff_t(in_half_size[1]),
+			in_center[2] - std::ptrdiff_t(in_half_size[2])
+		};
+
+		// Only the voxels of the cube are copied, so voxels outside the volume are resolved for each of them
+
+		auto const source_idx = [&](size_t in_axis, size_t in_idx)
+		{
+			auto const idx = begin[in_axis] + std::ptrdiff_t(in_idx);
+			auto const length = std::ptrdiff_t(in_volume.shape[in_axis]);
+
+			return is_clamped ? std::clamp(idx, std::ptrdiff_t(0), length - 1) : (idx < 0 || idx >= length ? std::ptrdiff_t(-1) : idx);
+		};
+
+		std::vector<double> coefficients(size[0] * size[1] * size[2], 0.0);
+
+		for (size_t z = 0; z < size[0]; ++z)
+		{
+			auto const src_z = source_idx(0, z);
+			if (src_z < 0)
+			{
+				continue;
+			}
+
+			for (size_t y = 0; y < size[1]; ++y)
+			{
+				auto const src_y = source_idx(1, y);
+				if (src_y < 0)
+				{
+					continue;
+				}
+
+				auto const src_row = in_volume.data + src_z * in_volume.strides[0] + src_y * in_volume.strides[1];
+				auto const row = coefficients.data() + (z * size[1] + y) * size[2];
+
+				for (size_t x = 0; x < size[2]; ++x)
+				{
+					auto const src_x = source_idx(2, x);
+					if (src_x >= 0)
+					{
+						row[x] = double(*reinterpret_cast<T const *>(src_row + src_x * in_volume.strides[2]));
+					}
+				}
+			}
+		}
+
+		// The spline is filtered and resampled one axis after another, z and y a whole plane or row at a time
+
+		auto const plane_size = size[1] * size[2];
+
+		PrefilterAxis(coefficients.data(), 1, 0, size[0], plane_size, plane_size);
+		PrefilterAxis(coefficients.data(), size[0], plane_size, size[1], size[2], size[2]);
+		PrefilterAxis(coefficients.data(), size[0] * size[1], size[2], size[2], 1, 1);
+
+		auto const cube_size = in_cube_size;
+
+		std::vector<double> resampled_z(cube_size * plane_size);
+		std::vector<double> resampled_y(cube_size * cube_size * size[2]);
+		std::vector<double> resampled_x(cube_size * cube_size * cube_size);
+
+		ResampleAxis(coefficients.data(), 0, plane_size, resampled_z.data(), 0, plane_size,
+			1, ComputeSplineTaps(size[0], cube_size), plane_size);
+		ResampleAxis(resampled_z.data(), plane_size, size[2], resampled_y.data(), cube_size * size[2], size[2],
+			cube_size, ComputeSplineTaps(size[1], cube_size), size[2]);
+		ResampleAxis(resampled_y.data(), size[2], 1, resampled_x.data(), cube_size, 1,
+			cube_size * cube_size, ComputeSplineTaps(size[2], cube_size), 1);
+
+		std::transform(resampled_x.begin(), resampled_x.end(), out_cube, CastVoxel<T>);
+	}
+}
+
+void ExtractCube(VolumeView const & in_volume, std::array<std::ptrdiff_t, 3> const & in_center, std::array<size_t, 3> const & in_half_size,
+	size_t in_cube_size, bool is_clamped, std::byte * out_cube)
+{
+	if (in_volume.is_big_endian && ElementSize(in_volume.element_type) > 1)
+	{
+		throw std::invalid_argument("big-endian volumes are not supported");
+	}
+	if (in_half_size[0] == 0 || in_half_size[1] == 0 || in_half_size[2] == 0)
+	{
+		throw std::invalid_argument("cube must span at least one voxel from its center along each axis");
+	}
+	if (in_cube_size == 0)
+	{
+		throw std::invalid_argument("cube size must be positive");
+	}
+	if (in_volume.shape[0] == 0 || in_volume.shape[1] == 0 || in_volume.shape[2] == 0)
+	{
+		throw std::invalid_argument("volume must not be empty");
+	}
+
+	switch (in_volume.element_type)
+	{
+	case ElementType::Int8:
+		return ExtractCubeTyped(in_volume, in_center, in_half_size, in_cube_size, is_clamped, reinterpret_cast<std::int8_t *>(out_cube));
+	case ElementType::UInt8:
+		return ExtractCubeTyped(in_volume, in_center, in_half_size, in_cube_size, is_clamped, reinterpret_cast<std::uint8_t *>(out_cube));
+	case ElementType::Int16:
+		return ExtractCubeTyped(in_volume, in_center, in_half_size, in_cube_size, is_clamped, reinterpret_cast<std::int16_t *>(out_cube));
+	case ElementType::UInt16:
+		return ExtractCubeTyped(in_volume, in_center, in_half_size, in_cube_size, is_clamped, reinterpret_cast<std::uint16_t *>(out_cube));
+	case ElementType::Int32:
+		return ExtractCubeTyped(in_volume, in_center, in_half_size, in_cube_size, is_clamped, reinterpret_cast<std::int32_t *>(out_cube));
+	case ElementType::UInt32:
+		return ExtractCubeTyped(in_volume, in_center, in_half_size, in_cube_size, is_clamped, reinterpret_cast<std::uint32_t *>(out_cube));
+	case ElementType::Float32:
+		return ExtractCubeTyped(in_volume, in_center, in_half_size, in_cube_size, is_clamped, reinterpret_cast<float *>(out_cube));
+	case ElementType::Float64:
+	default:
+		return ExtractCubeTyped(in_volume, in_center, in_half_size, in_cube_size, is_clamped, reinterpret_cast<double *>(out_cube));
+	}
+}
+
+void ExtractCubes(VolumeView const & in_volume, std::vector<std::array<std::ptrdiff_t, 3>> const & in_centers, std::array<size_t, 3> const & in_half_size,
+	size_t in_cube_size, bool is_clamped, size_t in_thread_count, std::byte * out_cubes)
+{
+	auto const cube_bytes = in_cube_size * in_cube_size * in_cube_size * ElementSize(in_volume.element_type);
+
+	ParallelFor(in_centers.size(), in_thread_count, [&](size_t in_idx)
+	{
+		ExtractCube(in_volume, in_centers[in_idx], in_half_size, in_cube_size, is_clamped, out_cubes + in_idx * cube_bytes);
+	});
+}
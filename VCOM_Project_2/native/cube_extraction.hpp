@@ -0,0 +1,22 @@
+#ifndef CUBE_EXTRACTION_HEADER
+#define CUBE_EXTRACTION_HEADER
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "mhd_volume.hpp"
+
+// Extracts the voxels from center - half_size up to center + half_size along each of z, y and x, then resamples them to cube_size^3
+// voxels of the same type, as utils.extractCube did with NumPy and SciPy: quadratic spline interpolation (scipy.ndimage.zoom(order=2)),
+// with integers rounded to the nearest value
+// Voxels outside the volume are zeros, as if the volume had been padded, or the nearest voxels inside it if clamped
+// Throws std::invalid_argument for big-endian volumes, empty half sizes or an empty cube size
+void ExtractCube(VolumeView const & in_volume, std::array<std::ptrdiff_t, 3> const & in_center, std::array<size_t, 3> const & in_half_size,
+	size_t in_cube_size, bool is_clamped, std::byte * out_cube);
+
+// Extracts the cubes around each center in parallel, one after another in the output (0 threads for the number of hardware threads)
+void ExtractCubes(VolumeView const & in_volume, std::vector<std::array<std::ptrdiff_t, 3>> const & in_centers, std::array<size_t, 3> const & in_half_size,
+	size_t in_cube_size, bool is_clamped, size_t in_thread_count, std::byte * out_cubes);
+
+#endif
@@ -0,0 +1,231 @@
+#include <array>
+#include <cmath>
+#include <exception>
+#include <vector>
+
+#include "cube_extraction.hpp"
+#include "python_common.hpp"
+
+namespace
+{
+	// Voxels of an MhdVolume object or of a 3D array, keeping a reference to the array (if any) to be released once done with the view
+	bool GetVolumeView(PyObject * in_object, VolumeView & out_view, PyObject *& out_array)
+	{
+		out_array = nullptr;
+
+		if (!PyArray_Check(in_object))
+		{
+			auto const volume = GetMhdVolume(in_object);
+			if (!volume)
+			{
+				return false;
+			}
+
+			out_view = volume->Volume();
+			return true;
+		}
+
+		// Arrays in another byte order or misaligned are copied, anything else is read in place through its strides
+		PyArray_Descr * descr = nullptr;
+		if (!PyArray_ISNOTSWAPPED(reinterpret_cast<PyArrayObject *>(in_object)))
+		{
+			descr = PyArray_DescrNewByteorder(PyArray_DESCR(reinterpret_cast<PyArrayObject *>(in_object)), NPY_NATIVE);
+			if (!descr)
+			{
+				return false;
+			}
+		}
+
+		// Steals the reference to the descriptor
+		out_array = PyArray_FromAny(in_object, descr, 3, 3, NPY_ARRAY_ALIGNED | NPY_ARRAY_NOTSWAPPED, nullptr);
+		if (!out_array)
+		{
+			return false;
+		}
+
+		auto const array = reinterpret_cast<PyArrayObject *>(out_array);
+
+		auto const element_type = ArrayElementType(array);
+		if (element_type < 0)
+		{
+			PyErr_SetString(PyExc_ValueError, "volume must be an array of 8, 16 or 32-bit integers or of floats");
+			Py_CLEAR(out_array);
+			return false;
+		}
+
+		auto const shape = PyArray_SHAPE(array);
+		auto const strides = PyArray_STRIDES(array);
+
+		out_view.data = static_cast<std::byte const *>(PyArray_DATA(array));
+		out_view.shape = { size_t(shape[0]), size_t(shape[1]), size_t(shape[2]) };
+		out_view.strides = { std::ptrdiff_t(strides[0]), std::ptrdiff_t(strides[1]), std::ptrdiff_t(strides[2]) };
+		out_view.element_type = element_type;
+		out_view.is_big_endian = false;
+
+		return true;
+	}
+
+	// Converts image coordinates in x, y, z order into voxel indices in z, y, x order, truncated as utils.extractCube did
+	bool ConvertCenters(PyObject * in_object, std::vector<std::array<std::ptrdiff_t, 3>> & out_centers)
+	{
+		PyObject * array = PyArray_FROM_OTF(in_object, NPY_FLOAT64, NPY_ARRAY_IN_ARRAY);
+		if (!array)
+		{
+			return false;
+		}
+
+		auto const centers_array = reinterpret_cast<PyArrayObject *>(array);
+
+		if (PyArray_NDIM(centers_array) != 2 || PyArray_DIM(centers_array, 1) != 3)
+		{
+			PyErr_SetString(PyExc_ValueError, "centers must be of shape (count, 3)");
+			Py_DECREF(array);
+			return false;
+		}
+
+		auto const count = size_t(PyArray_DIM(centers_array, 0));
+		auto const coordinates = static_cast<double const *>(PyArray_DATA(centers_array));
+
+		out_centers.resize(count);
+
+		for (size_t idx = 0; idx < count; ++idx)
+		{
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				double const coordinate = coordinates[idx * 3 + 2 - axis];
+				if (!std::isfinite(coordinate))
+				{
+					PyErr_SetString(PyExc_ValueError, "centers must be finite");
+					Py_DECREF(array);
+					return false;
+				}
+
+				out_centers[idx][axis] = std::ptrdiff_t(coordinate);
+			}
+		}
+
+		Py_DECREF(array);
+		return true;
+	}
+
+	PyObject * ExtractCubesFunction(PyObject *, PyObject * in_args, PyObject * in_kwargs)
+	{
+		static char const * keywords[] = { "volume", "centers", "spacing", "cube_size", "cube_size_mm", "clamp", "threads", nullptr };
+
+		PyObject * volume_object = nullptr;
+		PyObject * centers_object = nullptr;
+		double spacing[3];
+		Py_ssize_t cube_size = 80;
+		double cube_size_mm = 51.0;
+		int is_clamped = 0;
+		Py_ssize_t thread_count = 0;
+
+		if (!PyArg_ParseTupleAndKeywords(in_args, in_kwargs, "OO(ddd)|ndpn", const_cast<char **>(keywords),
+			&volume_object, &centers_object, &spacing[0], &spacing[1], &spacing[2], &cube_size, &cube_size_mm, &is_clamped, &thread_count))
+		{
+			return nullptr;
+		}
+
+		if (cube_size <= 0)
+		{
+			PyErr_SetString(PyExc_ValueError, "cube_size must be positive");
+			return nullptr;
+		}
+		if (thread_count < 0)
+		{
+			PyErr_SetString(PyExc_ValueError, "threads must not be negative");
+			return nullptr;
+		}
+
+		// Half of the cube along z, y and x, in voxels
+		std::array<size_t, 3> half_size;
+
+		for (size_t axis = 0; axis < 3; ++axis)
+		{
+			double const voxels = cube_size_mm / spacing[2 - axis] / 2.0;
+			if (!(voxels >= 1.0) || !std::isfinite(voxels))
+			{
+				PyErr_SetString(PyExc_ValueError, "cube must span at least one voxel from its center along each axis");
+				return nullptr;
+			}
+
+			half_size[axis] = size_t(voxels);
+		}
+
+		std::vector<std::array<std::ptrdiff_t, 3>> centers;
+
+		if (!ConvertCenters(centers_object, centers))
+		{
+			return nullptr;
+		}
+
+		VolumeView volume;
+		PyObject * volume_array = nullptr;
+
+		if (!GetVolumeView(volume_object, volume, volume_array))
+		{
+			return nullptr;
+		}
+
+		npy_intp dims[4] = { npy_intp(centers.size()), npy_intp(cube_size), npy_intp(cube_size), npy_intp(cube_size) };
+
+		// Steals the reference to the descriptor
+		PyObject * cubes = PyArray_SimpleNewFromDescr(4, dims, NewElementDescr(volume.element_type, false));
+		if (!cubes)
+		{
+			Py_XDECREF(volume_array);
+			return nullptr;
+		}
+
+		// No Python object is touched while the cubes are extracted, so the exception is only translated once the GIL is held again
+		std::exception_ptr exception;
+
+		Py_BEGIN_ALLOW_THREADS
+		try
+		{
+			ExtractCubes(volume, centers, half_size, size_t(cube_size), is_clamped != 0, size_t(thread_count),
+				static_cast<std::byte *>(PyArray_DATA(reinterpret_cast<PyArrayObject *>(cubes))));
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+		Py_END_ALLOW_THREADS
+
+		Py_XDECREF(volume_array);
+
+		if (exception)
+		{
+			Py_DECREF(cubes);
+
+			try
+			{
+				std::rethrow_exception(exception);
+			}
+			catch (...)
+			{
+				SetPythonError();
+			}
+			return nullptr;
+		}
+
+		return cubes;
+	}
+
+	PyMethodDef cube_extraction_methods[] = {
+		{ "extract_cubes", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(ExtractCubesFunction)), METH_VARARGS | METH_KEYWORDS,
+			"extract_cubes(volume, centers, spacing, cube_size=80, cube_size_mm=51, clamp=False, threads=0)\n\n"
+			"Extracts cubes of cube_size_mm^3 mm around each of the centers of the volume, resampled to cube_size^3 voxels, in parallel.\n"
+			"volume is an MhdVolume or an array in z, y, x order, while centers are image coordinates in x, y, z order, of shape (count, 3),\n"
+			"and spacing is the voxel size along x, y and z.\n"
+			"Returns an array of shape (count, cube_size, cube_size, cube_size) of the type of the volume, resampled as scipy.ndimage.zoom(order=2).\n"
+			"Voxels outside the volume are zeros, or the nearest voxels inside it if clamp is true.\n"
+			"threads is the number of threads to use, 0 for the number of hardware threads." },
+		{ nullptr, nullptr, 0, nullptr }
+	};
+}
+
+bool AddCubeExtractionFunctions(PyObject * io_module)
+{
+	return PyModule_AddFunctions(io_module, cube_extraction_methods) == 0;
+}
@@ -0,0 +1,21 @@
+#include "element_type.hpp"
+
+size_t ElementSize(int in_element_type) noexcept
+{
+	switch (in_element_type)
+	{
+	case ElementType::Int8:
+	case ElementType::UInt8:
+		return 1;
+	case ElementType::Int16:
+	case ElementType::UInt16:
+		return 2;
+	case ElementType::Int32:
+	case ElementType::UInt32:
+	case ElementType::Float32:
+		return 4;
+	case ElementType::Float64:
+	default:
+		return 8;
+	}
+}
@@ -0,0 +1,24 @@
+#ifndef ELEMENT_TYPE_HEADER
+#define ELEMENT_TYPE_HEADER
+
+#include <cstddef>
+
+struct ElementType
+{
+	enum _element_type : int
+	{
+		Int8 = 0,
+		UInt8,
+		Int16,
+		UInt16,
+		Int32,
+		UInt32,
+		Float32,
+		Float64,
+	};
+};
+
+// Size in bytes of an element of the type
+size_t ElementSize(int in_element_type) noexcept;
+
+#endif
@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+#include "fleischner.hpp"
+#include "parallel.hpp"
+
+namespace
+{
+	// Sums, over every way of splitting the findings into non-nodules and two groups of nodules, of the products of the weights each finding
+	// has in its group, by the number of findings in each group (none, one, or two or more)
+	using GroupSums = std::array<std::array<double, 3>, 3>;
+
+	GroupSums SumOverGroups(std::vector<double> const & in_non_nodule, std::vector<double> const & in_first, std::vector<double> const & in_second)
+	{
+		GroupSums sums = {};
+		sums[0][0] = 1.0;
+
+		for (size_t idx = 0; idx < in_non_nodule.size(); ++idx)
+		{
+			GroupSums next_sums = {};
+
+			for (size_t first_count = 0; first_count < 3; ++first_count)
+			{
+				for (size_t second_count = 0; second_count < 3; ++second_count)
+				{
+					auto const sum = sums[first_count][second_count];
+
+					next_sums[first_count][second_count] += sum * in_non_nodule[idx];
+					next_sums[std::min(first_count + 1, size_t(2))][second_count] += sum * in_first[idx];
+					next_sums[first_count][std::min(second_count + 1, size_t(2))] += sum * in_second[idx];
+				}
+			}
+			sums = next_sums;
+		}
+		return sums;
+	}
+
+	std::vector<double> Add(std::vector<double> in_lhs, std::vector<double> const & in_rhs)
+	{
+		for (size_t idx = 0; idx < in_lhs.size(); ++idx)
+		{
+			in_lhs[idx] += in_rhs[idx];
+		}
+		return in_lhs;
+	}
+
+	// Probabilities replaced by zero where they are not numbers (0 / 0), as calcCTFleischnerProb_Mixed does
+	double Ratio(double in_numerator, double in_denominator) noexcept
+	{
+		double const ratio = in_numerator / in_denominator;
+
+		return std::isnan(ratio) ? 0.0 : ratio;
+	}
+
+	template <typename P>
+	std::vector<FleischnerFinding> FindingsWhere(std::vector<FleischnerFinding> const & in_findings, P in_predicate)
+	{
+		std::vector<FleischnerFinding> findings;
+		std::copy_if(in_findings.begin(), in_findings.end(), std::back_inserter(findings), in_predicate);
+		return findings;
+	}
+
+	size_t ArgMax(std::array<double, 3> const & in_values) noexcept
+	{
+		return size_t(std::max_element(in_values.begin(), in_values.end()) - in_values.begin());
+	}
+}
+
+std::array<double, 4> FleischnerProbabilities(std::vector<FleischnerFinding> const & in_findings)
+{
+	auto const count = in_findings.size();
+
+	// Weights of each finding, with the probabilities of its volume and texture classes normalised
+
+	std::vector<double> nodule(count), non_nodule(count);
+	std::vector<std::array<double, 3>> volume(count), texture(count);
+
+	for (size_t idx = 0; idx < count; ++idx)
+	{
+		auto const & finding = in_findings[idx];
+
+		nodule[idx] = finding.nodule;
+		non_nodule[idx] = 1.0 - finding.nodule;
+
+		double const volume_sum = finding.volume[0] + finding.volume[1] + finding.volume[2];
+		double const texture_sum = finding.texture[0] + finding.texture[1] + finding.texture[2];
+
+		for (size_t cls = 0; cls < 3; ++cls)
+		{
+			volume[idx][cls] = finding.volume[cls] / volume_sum;
+			texture[idx][cls] = finding.texture[cls] / texture_sum;
+		}
+	}
+
+	std::array<double, 4> p = {};
+
+	// No nodules, then a single nodule, with the products over all other findings from prefix and suffix products
+
+	std::vector<double> other_non_nodules(count + 1, 1.0);
+	for (size_t idx = count; idx-- > 0;)
+	{
+		other_non_nodules[idx] = other_non_nodules[idx + 1] * non_nodule[idx];
+	}
+
+	p[0] += other_non_nodules[0];
+
+	double prefix = 1.0;
+	for (size_t idx = 0; idx < count; ++idx)
+	{
+		auto const & v = volume[idx];
+		auto const & t = texture[idx];
+
+		double const single = prefix * other_non_nodules[idx + 1] * nodule[idx];
+
+		p[0] += single * v[0];
+		p[1] += single * ((v[1] + v[2]) * t[0] + v[1] * t[2]);
+		p[2] += single * ((v[1] + v[2]) * t[1]);
+		p[3] += single * v[2] * t[2];
+
+		prefix *= non_nodule[idx];
+	}
+
+	if (count < 2)
+	{
+		return p;
+	}
+
+	// Multiple nodules, each term being a sum over the subsets of two or more nodules (the first group), and then over the ways of splitting
+	// them into solid (first group) and non-solid nodules (second group) for mixed nodules
+
+	std::vector<double> const none(count, 0.0);
+	std::vector<double> all_non_solid(count), all_solid(count), all_solid_small(count), all_solid_any(count), all_solid_not_large(count);
+	std::vector<double> solid(count), solid_small(count), solid_medium(count), solid_large(count), solid_any(count), solid_not_large(count);
+	std::vector<double> non_solid_small(count), non_solid_ground_glass(count), non_solid_part_solid(count), non_solid(count);
+
+	for (size_t idx = 0; idx < count; ++idx)
+	{
+		auto const & v = volume[idx];
+		auto const & t = texture[idx];
+
+		all_non_solid[idx] = nodule[idx] * (t[0] + t[1]);
+		all_solid[idx] = nodule[idx] * t[2];
+		all_solid_small[idx] = all_solid[idx] * v[0];
+		all_solid_any[idx] = all_solid[idx] * v[2] + all_solid[idx] * (v[0] + v[1]);
+		all_solid_not_large[idx] = all_solid[idx] * (v[0] + v[1]);
+
+		// Within mixed nodules, solid nodules are certainly solid and non-solid ones only ground glass or part solid
+
+		double const solid_texture = Ratio(t[2], t[2]);
+		double const non_solid_texture = t[0] + t[1];
+		double const ground_glass_texture = Ratio(t[0], non_solid_texture);
+		double const part_solid_texture = Ratio(t[1], non_solid_texture);
+
+		solid[idx] = nodule[idx] * t[2] * solid_texture;
+		solid_small[idx] = solid[idx] * v[0];
+		solid_medium[idx] = solid[idx] * v[1];
+		solid_large[idx] = solid[idx] * v[2];
+		solid_any[idx] = solid_large[idx] + solid[idx] * (v[0] + v[1]);
+		solid_not_large[idx] = solid[idx] * (v[0] + v[1]);
+
+		double const non_solid_weight = nodule[idx] * non_solid_texture;
+
+		non_solid_small[idx] = non_solid_weight * v[0];
+		non_solid_ground_glass[idx] = non_solid_weight * (v[1] + v[2]) * ground_glass_texture;
+		non_solid_part_solid[idx] = non_solid_weight * (v[1] + v[2]) * part_solid_texture;
+		non_solid[idx] = non_solid_weight * (ground_glass_texture + part_solid_texture);
+	}
+
+	auto const sum_all = [&](std::vector<double> const & in_weights)
+	{
+		return SumOverGroups(non_nodule, in_weights, none)[2][0];
+	};
+	auto const sum_mixed = [&](std::vector<double> const & in_solid, std::vector<double> const & in_non_solid, size_t in_solid_count, size_t in_non_solid_count)
+	{
+		return SumOverGroups(non_nodule, in_solid, in_non_solid)[in_solid_count][in_non_solid_count];
+	};
+
+	// All non-solid
+	p[3] += sum_all(all_non_solid);
+
+	// All solid
+	double const all_solid_p = sum_all(all_solid);
+	double const all_solid_p0 = sum_all(all_solid_small);
+	double const all_solid_p3 = sum_all(all_solid_any) - sum_all(all_solid_not_large);
+
+	p[0] += all_solid_p0;
+	p[3] += all_solid_p3;
+	p[2] += all_solid_p - all_solid_p3 - all_solid_p0;
+
+	// Mixed, with a single solid nodule and a single non-solid one, whose classes combine as for single nodules
+	auto const non_solid_any = Add(Add(non_solid_small, non_solid_ground_glass), non_solid_part_solid);
+
+	p[0] += sum_mixed(solid_small, non_solid_small, 1, 1);
+	p[1] += sum_mixed(solid_medium, non_solid_small, 1, 1) + sum_mixed(solid_small, non_solid_ground_glass, 1, 1) + sum_mixed(solid_medium, non_solid_ground_glass, 1, 1);
+	p[2] += sum_mixed(Add(solid_small, solid_medium), non_solid_part_solid, 1, 1);
+	p[3] += sum_mixed(solid_large, non_solid_any, 1, 1);
+
+	// Mixed, with a single solid nodule and multiple non-solid ones, which are all of the highest class
+	p[3] += sum_mixed(Add(Add(solid_small, solid_medium), solid_large), non_solid, 1, 2);
+
+	// Mixed, with multiple solid nodules and a single non-solid one
+	double const solid_p0 = sum_mixed(solid_small, non_solid_any, 2, 1);
+	double const solid_p3 = sum_mixed(solid_any, non_solid_any, 2, 1) - sum_mixed(solid_not_large, non_solid_any, 2, 1);
+	double const solid_p2 = sum_mixed(solid, non_solid_any, 2, 1) - solid_p3 - solid_p0;
+
+	p[0] += sum_mixed(solid_small, non_solid_small, 2, 1);
+	p[1] += sum_mixed(solid_small, non_solid_ground_glass, 2, 1);
+	p[2] += solid_p2 + sum_mixed(solid_small, non_solid_part_solid, 2, 1);
+	p[3] += solid_p3;
+
+	// Mixed, with multiple solid nodules and multiple non-solid ones
+	p[3] += sum_mixed(solid, non_solid, 2, 2);
+
+	return p;
+}
+
+int FleischnerClass(std::vector<FleischnerFinding> const & in_findings, double in_nodule_threshold)
+{
+	auto const nodules = FindingsWhere(in_findings, [&](FleischnerFinding const & in_finding)
+	{
+		return in_finding.nodule >= in_nodule_threshold;
+	});
+
+	auto const all_of = [&](auto in_predicate)
+	{
+		return std::all_of(nodules.begin(), nodules.end(), in_predicate);
+	};
+
+	if (nodules.empty())
+	{
+		return 0;
+	}
+
+	if (nodules.size() == 1)
+	{
+		auto const & nodule = nodules.front();
+
+		if (nodule.volume_class == 0)
+		{
+			return 0;
+		}
+		if (nodule.texture_class == 1)
+		{
+			return 2;
+		}
+		if (nodule.texture_class == 0 || nodule.volume_class == 1)
+		{
+			return 1;
+		}
+		return 3;
+	}
+
+	if (all_of([](FleischnerFinding const & in_nodule) { return in_nodule.texture_class < 2; }))
+	{
+		return 2;
+	}
+
+	if (all_of([](FleischnerFinding const & in_nodule) { return in_nodule.texture_class == 2; }))
+	{
+		if (all_of([](FleischnerFinding const & in_nodule) { return in_nodule.volume_class == 0; }))
+		{
+			return 0;
+		}
+		if (std::any_of(nodules.begin(), nodules.end(), [](FleischnerFinding const & in_nodule) { return in_nodule.volume_class == 2; }))
+		{
+			return 3;
+		}
+		return 2;
+	}
+
+	// Mixed nodules are scored as the worst of the solid and the non-solid ones, which are counted as nodules with the default probability again
+
+	auto const solid = FindingsWhere(nodules, [](FleischnerFinding const & in_nodule) { return in_nodule.texture_class == 2; });
+	auto const non_solid = FindingsWhere(nodules, [](FleischnerFinding const & in_nodule) { return in_nodule.texture_class < 2; });
+
+	return std::max(FleischnerClass(solid), FleischnerClass(non_solid));
+}
+
+std::vector<FleischnerScore> ScoreFleischner(std::vector<FleischnerFinding> const & in_findings, std::vector<size_t> const & in_ct_indices,
+	size_t in_ct_count, bool has_probabilities, size_t in_thread_count)
+{
+	if (in_ct_indices.size() != in_findings.size())
+	{
+		throw std::invalid_argument("there must be one CT index for each finding");
+	}
+
+	// The findings of each CT keep their order, which the sums of their probabilities depend on
+
+	std::vector<std::vector<FleischnerFinding>> ct_findings(in_ct_count);
+
+	for (size_t idx = 0; idx < in_findings.size(); ++idx)
+	{
+		if (in_ct_indices[idx] >= in_ct_count)
+		{
+			throw std::invalid_argument("CT index exceeds the CT count");
+		}
+
+		auto & finding = ct_findings[in_ct_indices[idx]].emplace_back(in_findings[idx]);
+
+		// Predicted findings are of their most likely classes
+		if (has_probabilities)
+		{
+			finding.volume_class = double(ArgMax(finding.volume));
+			finding.texture_class = double(ArgMax(finding.texture));
+		}
+	}
+
+	std::vector<FleischnerScore> scores(in_ct_count);
+
+	ParallelFor(in_ct_count, in_thread_count, [&](size_t in_idx)
+	{
+		scores[in_idx].fleischner_class = FleischnerClass(ct_findings[in_idx]);
+		scores[in_idx].probabilities = has_probabilities ? FleischnerProbabilities(ct_findings[in_idx]) : std::array<double, 4>{};
+	});
+
+	return scores;
+}
@@ -0,0 +1,37 @@
+#ifndef FLEISCHNER_HEADER
+#define FLEISCHNER_HEADER
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// Finding of a CT, either rated (with volume and texture classes) or predicted (with probabilities of each class as well)
+struct FleischnerFinding
+{
+	double nodule; // Probability of being a nodule
+	double volume_class; // 0 (small), 1 (medium) or 2 (large)
+	double texture_class; // 0 (ground glass), 1 (part solid) or 2 (solid)
+	std::array<double, 3> volume; // Probability of each volume class, not necessarily normalised
+	std::array<double, 3> texture; // Probability of each texture class, not necessarily normalised
+};
+
+struct FleischnerScore
+{
+	int fleischner_class;
+	std::array<double, 4> probabilities; // Of each class, or zeros if the findings have no class probabilities
+};
+
+// Probability of each Fleischner class of a CT, as calcFleischner.calcCTFleischnerProb, in linear rather than exponential time
+// Summing over every subset of the findings factors into products over the findings, so each sum is built one finding at a time
+std::array<double, 4> FleischnerProbabilities(std::vector<FleischnerFinding> const & in_findings);
+
+// Fleischner class of a CT, as calcFleischner.calcCTFleischnerScore, counting findings as nodules from the specified probability
+int FleischnerClass(std::vector<FleischnerFinding> const & in_findings, double in_nodule_threshold = 0.5);
+
+// Scores the CTs of all findings in parallel, the findings of each being gathered in one pass by the index of their CT
+// (0 threads for the number of hardware threads)
+// Throws std::invalid_argument if a CT index is not less than the CT count
+std::vector<FleischnerScore> ScoreFleischner(std::vector<FleischnerFinding> const & in_findings, std::vector<size_t> const & in_ct_indices,
+	size_t in_ct_count, bool has_probabilities, size_t in_thread_count);
+
+#endif
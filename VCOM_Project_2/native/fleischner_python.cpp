@@ -0,0 +1,217 @@
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+#include "fleischner.hpp"
+#include "python_common.hpp"
+
+namespace
+{
+	// Contiguous array of the type, of the specified number of dimensions, or nullptr with a Python exception set
+	PyArrayObject * ConvertArray(PyObject * in_object, int in_type, int in_dims, char const * in_error)
+	{
+		PyObject * array = PyArray_FROM_OTF(in_object, in_type, NPY_ARRAY_IN_ARRAY);
+		if (!array)
+		{
+			return nullptr;
+		}
+
+		if (PyArray_NDIM(reinterpret_cast<PyArrayObject *>(array)) != in_dims)
+		{
+			PyErr_SetString(PyExc_ValueError, in_error);
+			Py_DECREF(array);
+			return nullptr;
+		}
+		return reinterpret_cast<PyArrayObject *>(array);
+	}
+
+	// Findings from the arrays of their nodule probabilities and of either their volume and texture classes or the probabilities of each class,
+	// returning false with a Python exception set on failure
+	bool ConvertFindings(PyObject * in_nodule, PyObject * in_volume, PyObject * in_texture, std::vector<FleischnerFinding> & out_findings, bool & out_has_probabilities)
+	{
+		PyObject * objects[3] = { in_nodule, in_volume, in_texture };
+		PyArrayObject * arrays[3] = {};
+
+		bool is_valid = true;
+		for (size_t idx = 0; is_valid && idx < 3; ++idx)
+		{
+			arrays[idx] = reinterpret_cast<PyArrayObject *>(PyArray_FROM_OTF(objects[idx], NPY_FLOAT64, NPY_ARRAY_IN_ARRAY));
+			is_valid = arrays[idx] != nullptr;
+		}
+
+		if (is_valid)
+		{
+			// Classes are given one per finding, and probabilities three per finding
+			out_has_probabilities = PyArray_NDIM(arrays[1]) == 2;
+
+			is_valid = PyArray_NDIM(arrays[0]) == 1;
+			for (size_t idx = 1; is_valid && idx < 3; ++idx)
+			{
+				is_valid = PyArray_NDIM(arrays[idx]) == (out_has_probabilities ? 2 : 1) && PyArray_DIM(arrays[idx], 0) == PyArray_DIM(arrays[0], 0)
+					&& (!out_has_probabilities || PyArray_DIM(arrays[idx], 1) == 3);
+			}
+
+			if (!is_valid)
+			{
+				PyErr_SetString(PyExc_ValueError, "nodule must be of shape (count,), and volume and texture both of shape (count,) for classes or (count, 3) for probabilities");
+			}
+		}
+
+		if (is_valid)
+		{
+			auto const nodule = static_cast<double const *>(PyArray_DATA(arrays[0]));
+			auto const volume = static_cast<double const *>(PyArray_DATA(arrays[1]));
+			auto const texture = static_cast<double const *>(PyArray_DATA(arrays[2]));
+
+			out_findings.assign(size_t(PyArray_DIM(arrays[0], 0)), FleischnerFinding{});
+
+			for (size_t idx = 0; idx < out_findings.size(); ++idx)
+			{
+				auto & finding = out_findings[idx];
+
+				finding.nodule = nodule[idx];
+
+				if (out_has_probabilities)
+				{
+					std::memcpy(finding.volume.data(), volume + idx * 3, sizeof(finding.volume));
+					std::memcpy(finding.texture.data(), texture + idx * 3, sizeof(finding.texture));
+				}
+				else
+				{
+					finding.volume_class = volume[idx];
+					finding.texture_class = texture[idx];
+				}
+			}
+		}
+
+		for (auto const array : arrays)
+		{
+			Py_XDECREF(array);
+		}
+
+		return is_valid;
+	}
+
+	PyObject * FleischnerScoresFunction(PyObject *, PyObject * in_args, PyObject * in_kwargs)
+	{
+		static char const * keywords[] = { "ct_indices", "ct_count", "nodule", "volume", "texture", "threads", nullptr };
+
+		PyObject * ct_indices_object = nullptr;
+		Py_ssize_t ct_count = 0;
+		PyObject * nodule_object = nullptr;
+		PyObject * volume_object = nullptr;
+		PyObject * texture_object = nullptr;
+		Py_ssize_t thread_count = 0;
+
+		if (!PyArg_ParseTupleAndKeywords(in_args, in_kwargs, "OnOOO|n", const_cast<char **>(keywords),
+			&ct_indices_object, &ct_count, &nodule_object, &volume_object, &texture_object, &thread_count))
+		{
+			return nullptr;
+		}
+
+		if (ct_count < 0)
+		{
+			PyErr_SetString(PyExc_ValueError, "ct_count must not be negative");
+			return nullptr;
+		}
+		if (thread_count < 0)
+		{
+			PyErr_SetString(PyExc_ValueError, "threads must not be negative");
+			return nullptr;
+		}
+
+		std::vector<FleischnerFinding> findings;
+		bool has_probabilities = false;
+
+		if (!ConvertFindings(nodule_object, volume_object, texture_object, findings, has_probabilities))
+		{
+			return nullptr;
+		}
+
+		auto const ct_indices_array = ConvertArray(ct_indices_object, NPY_INTP, 1, "ct_indices must be of shape (count,)");
+		if (!ct_indices_array)
+		{
+			return nullptr;
+		}
+
+		std::vector<size_t> ct_indices(size_t(PyArray_DIM(ct_indices_array, 0)));
+
+		for (size_t idx = 0; idx < ct_indices.size(); ++idx)
+		{
+			auto const ct_idx = static_cast<npy_intp const *>(PyArray_DATA(ct_indices_array))[idx];
+
+			// Negative indices wrap around to beyond the CT count
+			ct_indices[idx] = ct_idx < 0 ? size_t(ct_count) : size_t(ct_idx);
+		}
+		Py_DECREF(ct_indices_array);
+
+		std::vector<FleischnerScore> scores;
+		std::exception_ptr exception;
+
+		Py_BEGIN_ALLOW_THREADS
+		try
+		{
+			scores = ScoreFleischner(findings, ct_indices, size_t(ct_count), has_probabilities, size_t(thread_count));
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+		Py_END_ALLOW_THREADS
+
+		if (exception)
+		{
+			try
+			{
+				std::rethrow_exception(exception);
+			}
+			catch (...)
+			{
+				SetPythonError();
+			}
+			return nullptr;
+		}
+
+		npy_intp class_dims[1] = { npy_intp(scores.size()) };
+		npy_intp probability_dims[2] = { npy_intp(scores.size()), 4 };
+
+		PyObject * classes = PyArray_SimpleNew(1, class_dims, NPY_INT32);
+		PyObject * probabilities = PyArray_SimpleNew(2, probability_dims, NPY_FLOAT64);
+		if (!classes || !probabilities)
+		{
+			Py_XDECREF(classes);
+			Py_XDECREF(probabilities);
+			return nullptr;
+		}
+
+		auto const class_data = static_cast<std::int32_t *>(PyArray_DATA(reinterpret_cast<PyArrayObject *>(classes)));
+		auto const probability_data = static_cast<double *>(PyArray_DATA(reinterpret_cast<PyArrayObject *>(probabilities)));
+
+		for (size_t idx = 0; idx < scores.size(); ++idx)
+		{
+			class_data[idx] = std::int32_t(scores[idx].fleischner_class);
+			std::memcpy(probability_data + idx * 4, scores[idx].probabilities.data(), sizeof(scores[idx].probabilities));
+		}
+
+		// Steals the references to the arrays
+		return Py_BuildValue("(NN)", classes, probabilities);
+	}
+
+	PyMethodDef fleischner_methods[] = {
+		{ "fleischner_scores", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(FleischnerScoresFunction)), METH_VARARGS | METH_KEYWORDS,
+			"fleischner_scores(ct_indices, ct_count, nodule, volume, texture, threads=0)\n\n"
+			"Scores the Fleischner class of ct_count CTs in parallel, from all of their findings at once, as calcFleischner.calcFleischner.\n"
+			"ct_indices is the index of the CT of each finding, as from numpy.unique(..., return_inverse=True), and nodule the probability of\n"
+			"each finding being a nodule. volume and texture are either the classes of each finding, of shape (count,), or the probabilities of\n"
+			"each class, of shape (count, 3), in which case the probabilities of each Fleischner class are computed as well.\n"
+			"Returns the classes, of shape (ct_count,), and the probabilities of each class, of shape (ct_count, 4) (zeros if not computed).\n"
+			"threads is the number of threads to use, 0 for the number of hardware threads." },
+		{ nullptr, nullptr, 0, nullptr }
+	};
+}
+
+bool AddFleischnerFunctions(PyObject * io_module)
+{
+	return PyModule_AddFunctions(io_module, fleischner_methods) == 0;
+}
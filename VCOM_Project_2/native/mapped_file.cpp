@@ -0,0 +1,261 @@
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.hpp"
+
+#if defined(_WIN32)
+
+namespace
+{
+	// Paths are UTF-8, as Python encodes them, so they are converted for the wide functions rather than read in the ANSI code page
+	std::wstring WidePath(std::string const & in_path)
+	{
+		if (in_path.empty())
+		{
+			return std::wstring{};
+		}
+
+		int const length = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, in_path.data(), int(in_path.size()), nullptr, 0);
+		if (length <= 0)
+		{
+			throw std::runtime_error("invalid path " + in_path);
+		}
+
+		std::wstring wide_path(size_t(length), L'\0');
+		MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, in_path.data(), int(in_path.size()), wide_path.data(), length);
+
+		return wide_path;
+	}
+}
+
+MappedFile::MappedFile(std::string const & in_path)
+	: data{ nullptr }
+	, size{ 0 }
+	, is_writable{ false }
+	, file_handle{ INVALID_HANDLE_VALUE }
+	, mapping_handle{ nullptr }
+{
+	// Random access keeps the cache manager from reading ahead of the slices that are accessed
+
+	file_handle = CreateFileW(WidePath(in_path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file_handle == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("cannot open " + in_path);
+	}
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file_handle, &file_size))
+	{
+		CloseHandle(file_handle);
+		throw std::runtime_error("cannot read the size of " + in_path);
+	}
+
+	size = size_t(file_size.QuadPart);
+
+	Map(in_path);
+}
+
+MappedFile::MappedFile(std::string const & in_path, size_t in_size)
+	: data{ nullptr }
+	, size{ in_size }
+	, is_writable{ true }
+	, file_handle{ INVALID_HANDLE_VALUE }
+	, mapping_handle{ nullptr }
+{
+	file_handle = CreateFileW(WidePath(in_path).c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file_handle == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("cannot create " + in_path);
+	}
+
+	// Mapping the file with its final size extends it
+
+	Map(in_path);
+}
+
+void MappedFile::Map(std::string const & in_path)
+{
+	// Empty files cannot be mapped, but have no data to access either
+
+	if (size == 0)
+	{
+		return;
+	}
+
+	auto const mapping_size = static_cast<std::uint64_t>(size);
+
+	mapping_handle = CreateFileMappingW(file_handle, nullptr, is_writable ? PAGE_READWRITE : PAGE_READONLY,
+		DWORD(mapping_size >> 32), DWORD(mapping_size & 0xFFFFFFFF), nullptr);
+	if (!mapping_handle)
+	{
+		CloseHandle(file_handle);
+		throw std::runtime_error("cannot map " + in_path);
+	}
+
+	data = static_cast<std::byte const *>(MapViewOfFile(mapping_handle, is_writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+	if (!data)
+	{
+		CloseHandle(mapping_handle);
+		CloseHandle(file_handle);
+		throw std::runtime_error("cannot map " + in_path);
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (data)
+	{
+		if (is_writable)
+		{
+			FlushViewOfFile(data, 0);
+		}
+		UnmapViewOfFile(data);
+	}
+	if (mapping_handle)
+	{
+		CloseHandle(mapping_handle);
+	}
+	CloseHandle(file_handle);
+}
+
+void MappedFile::Prefetch(size_t in_offset, size_t in_length) const noexcept
+{
+	if (!data || in_length == 0)
+	{
+		return;
+	}
+
+	WIN32_MEMORY_RANGE_ENTRY range{ const_cast<std::byte *>(data) + in_offset, in_length };
+
+	// Only a hint, which older versions of Windows ignore
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+bool MappedFile::Flush(size_t in_offset, size_t in_length) const noexcept
+{
+	return !is_writable || !data || in_length == 0 || FlushViewOfFile(data + in_offset, in_length);
+}
+
+#else
+
+MappedFile::MappedFile(std::string const & in_path)
+	: data{ nullptr }
+	, size{ 0 }
+	, is_writable{ false }
+	, file_descriptor{ open(in_path.c_str(), O_RDONLY) }
+{
+	if (file_descriptor < 0)
+	{
+		throw std::runtime_error("cannot open " + in_path);
+	}
+
+	struct stat file_status;
+	if (fstat(file_descriptor, &file_status) != 0)
+	{
+		close(file_descriptor);
+		throw std::runtime_error("cannot read the size of " + in_path);
+	}
+
+	size = size_t(file_status.st_size);
+
+	Map(in_path);
+}
+
+MappedFile::MappedFile(std::string const & in_path, size_t in_size)
+	: data{ nullptr }
+	, size{ in_size }
+	, is_writable{ true }
+	, file_descriptor{ open(in_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) }
+{
+	if (file_descriptor < 0)
+	{
+		throw std::runtime_error("cannot create " + in_path);
+	}
+
+	if (ftruncate(file_descriptor, off_t(size)) != 0)
+	{
+		close(file_descriptor);
+		throw std::runtime_error("cannot extend " + in_path);
+	}
+
+	Map(in_path);
+}
+
+void MappedFile::Map(std::string const & in_path)
+{
+	// Empty files cannot be mapped, but have no data to access either
+
+	if (size == 0)
+	{
+		return;
+	}
+
+	void * mapping = mmap(nullptr, size, is_writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file_descriptor, 0);
+	if (mapping == MAP_FAILED)
+	{
+		close(file_descriptor);
+		throw std::runtime_error("cannot map " + in_path);
+	}
+
+	// Random access keeps the kernel from reading ahead of the slices that are accessed
+
+	if (!is_writable)
+	{
+		madvise(mapping, size, MADV_RANDOM);
+	}
+
+	data = static_cast<std::byte const *>(mapping);
+}
+
+MappedFile::~MappedFile()
+{
+	if (data)
+	{
+		munmap(const_cast<std::byte *>(data), size);
+	}
+	close(file_descriptor);
+}
+
+void MappedFile::Prefetch(size_t in_offset, size_t in_length) const noexcept
+{
+	if (!data || in_length == 0)
+	{
+		return;
+	}
+
+	// The advised range must start at a page boundary
+
+	auto const page_size = size_t(sysconf(_SC_PAGESIZE));
+	auto const page_offset = in_offset - in_offset % page_size;
+
+	madvise(const_cast<std::byte *>(data) + page_offset, in_length + (in_offset - page_offset), MADV_WILLNEED);
+}
+
+bool MappedFile::Flush(size_t in_offset, size_t in_length) const noexcept
+{
+	if (!is_writable || !data || in_length == 0)
+	{
+		return true;
+	}
+
+	// The flushed range must start at a page boundary
+
+	auto const page_size = size_t(sysconf(_SC_PAGESIZE));
+	auto const page_offset = in_offset - in_offset % page_size;
+
+	return msync(const_cast<std::byte *>(data) + page_offset, in_length + (in_offset - page_offset), MS_ASYNC) == 0;
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef MAPPED_FILE_HEADER
+#define MAPPED_FILE_HEADER
+
+#include <cstddef>
+#include <string>
+
+// Memory mapping of a whole file, by its UTF-8 path, whose pages are only read from disk once they are accessed
+class MappedFile
+{
+public:
+	// Maps an existing file for reading, throwing std::runtime_error if it cannot be opened or mapped
+	explicit MappedFile(std::string const & in_path);
+	// Creates (or replaces) a file of the specified size and maps it for writing, throwing std::runtime_error if it cannot be created or mapped
+	MappedFile(std::string const & in_path, size_t in_size);
+	~MappedFile();
+
+	MappedFile(MappedFile const &) = delete;
+	MappedFile & operator=(MappedFile const &) = delete;
+
+	std::byte const * Data() const noexcept
+	{
+		return data;
+	}
+	size_t Size() const noexcept
+	{
+		return size;
+	}
+
+	// Writable data, or nullptr if the file was mapped for reading
+	std::byte * WritableData() const noexcept
+	{
+		return is_writable ? const_cast<std::byte *>(data) : nullptr;
+	}
+
+	// Hints that the range will be read soon, so that its pages are read ahead of the accesses, and nothing around it
+	void Prefetch(size_t in_offset, size_t in_length) const noexcept;
+	// Starts writing the range back to disk, so that written pages do not pile up in memory, returning false on failure
+	bool Flush(size_t in_offset, size_t in_length) const noexcept;
+
+private:
+	void Map(std::string const & in_path);
+
+	std::byte const * data;
+	size_t size;
+	bool is_writable;
+
+#if defined(_WIN32)
+	void * file_handle;
+	void * mapping_handle;
+#else
+	int file_descriptor;
+#endif
+
+};
+
+#endif
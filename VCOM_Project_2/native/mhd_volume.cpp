@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "mhd_volume.hpp"
+
+namespace
+{
+	std::string Trim(std::string const & in_string)
+	{
+		auto const begin = in_string.find_first_not_of(" \t\r\n");
+		auto const end = in_string.find_last_not_of(" \t\r\n");
+
+		return begin == std::string::npos ? std::string{} : in_string.substr(begin, end - begin + 1);
+	}
+
+	std::vector<double> ParseNumbers(std::string const & in_value)
+	{
+		std::vector<double> numbers;
+		std::istringstream stream{ in_value };
+
+		for (double number; stream >> number;)
+		{
+			numbers.push_back(number);
+		}
+		return numbers;
+	}
+
+	bool ParseBool(std::string const & in_value)
+	{
+		return in_value == "True" || in_value == "true" || in_value == "1";
+	}
+
+	int ParseElementType(std::string const & in_value)
+	{
+		static std::pair<char const *, int> const element_types[] = {
+			{ "MET_CHAR", ElementType::Int8 },
+			{ "MET_UCHAR", ElementType::UInt8 },
+			{ "MET_SHORT", ElementType::Int16 },
+			{ "MET_USHORT", ElementType::UInt16 },
+			{ "MET_INT", ElementType::Int32 },
+			{ "MET_UINT", ElementType::UInt32 },
+			{ "MET_FLOAT", ElementType::Float32 },
+			{ "MET_DOUBLE", ElementType::Float64 },
+		};
+
+		for (auto const & [name, element_type] : element_types)
+		{
+			if (in_value == name)
+			{
+				return element_type;
+			}
+		}
+		throw std::runtime_error("unsupported element type " + in_value);
+	}
+
+	std::string ParentPath(std::string const & in_path)
+	{
+		auto const separator = in_path.find_last_of("/\\");
+
+		return separator == std::string::npos ? std::string{} : in_path.substr(0, separator + 1);
+	}
+}
+
+MhdHeader ReadMhdHeader(std::string const & in_path)
+{
+	// Paths are UTF-8, as Python encodes them, which only the wide functions behind a filesystem path keep on Windows
+	std::ifstream stream{ std::filesystem::u8path(in_path), std::ios::binary };
+	if (!stream)
+	{
+		throw std::runtime_error("cannot open " + in_path);
+	}
+
+	MhdHeader header{};
+	header.dim_size = { 1, 1, 1 };
+	header.spacing = { 1.0, 1.0, 1.0 };
+	header.direction = { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0 };
+	header.element_type = -1;
+
+	size_t dims = 0;
+	bool has_spacing = false;
+	std::ptrdiff_t header_size = 0;
+	std::vector<double> transform_matrix;
+
+	// Every line is a key and value pair, with the data file always being the last one
+
+	for (std::string line; std::getline(stream, line);)
+	{
+		auto const separator = line.find('=');
+		if (separator == std::string::npos)
+		{
+			continue;
+		}
+
+		auto const key = Trim(line.substr(0, separator));
+		auto const value = Trim(line.substr(separator + 1));
+
+		if (key == "NDims")
+		{
+			dims = size_t(std::stoul(value));
+
+			if (dims != 2 && dims != 3)
+			{
+				throw std::runtime_error("unsupported number of dimensions in " + in_path);
+			}
+		}
+		else if (key == "DimSize")
+		{
+			auto const numbers = ParseNumbers(value);
+			std::transform(numbers.begin(), numbers.begin() + std::min(numbers.size(), size_t(3)), header.dim_size.begin(), [](double in_number) { return size_t(in_number); });
+		}
+		else if (key == "ElementSpacing" || (key == "ElementSize" && !has_spacing))
+		{
+			// The size of the elements only stands for their spacing if the latter is missing
+
+			auto const numbers = ParseNumbers(value);
+			std::copy(numbers.begin(), numbers.begin() + std::min(numbers.size(), size_t(3)), header.spacing.begin());
+
+			has_spacing = key == "ElementSpacing";
+		}
+		else if (key == "Offset" || key == "Origin" || key == "Position")
+		{
+			auto const numbers = ParseNumbers(value);
+			std::copy(numbers.begin(), numbers.begin() + std::min(numbers.size(), size_t(3)), header.origin.begin());
+		}
+		else if (key == "TransformMatrix" || key == "Rotation" || key == "Orientation")
+		{
+			transform_matrix = ParseNumbers(value);
+		}
+		else if (key == "ElementType")
+		{
+			header.element_type = ParseElementType(value);
+		}
+		else if (key == "BinaryDataByteOrderMSB" || key == "ElementByteOrderMSB")
+		{
+			header.is_big_endian = ParseBool(value);
+		}
+		else if (key == "CompressedData" && ParseBool(value))
+		{
+			throw std::runtime_error("compressed data cannot be mapped in " + in_path);
+		}
+		else if (key == "ElementNumberOfChannels" && value != "1")
+		{
+			throw std::runtime_error("unsupported number of channels in " + in_path);
+		}
+		else if (key == "HeaderSize")
+		{
+			header_size = std::ptrdiff_t(std::stol(value));
+		}
+		else if (key == "ElementDataFile")
+		{
+			if (value == "LOCAL")
+			{
+				// The voxels follow the header in the same file
+
+				header.data_file = in_path;
+				header.data_offset = header_size < 0 ? -1 : std::ptrdiff_t(stream.tellg()) + header_size;
+			}
+			else if (value == "LIST" || value.find('%') != std::string::npos)
+			{
+				throw std::runtime_error("data split across several files cannot be mapped in " + in_path);
+			}
+			else
+			{
+				header.data_file = ParentPath(in_path) + value;
+				header.data_offset = header_size;
+			}
+			break;
+		}
+	}
+
+	if (dims == 0 || header.element_type < 0 || header.data_file.empty())
+	{
+		throw std::runtime_error("incomplete header in " + in_path);
+	}
+
+	// The transform matrix holds the direction of each image axis in a row, while SimpleITK holds them in columns
+
+	if (transform_matrix.size() == dims * dims)
+	{
+		for (size_t row = 0; row < dims; ++row)
+		{
+			for (size_t column = 0; column < dims; ++column)
+			{
+				header.direction[row * 3 + column] = transform_matrix[column * dims + row];
+			}
+		}
+	}
+
+	return header;
+}
+
+MhdVolume::MhdVolume(std::string const & in_path)
+	: header{ ReadMhdHeader(in_path) }
+	, file{ std::make_unique<MappedFile>(header.data_file) }
+	, voxels{ nullptr }
+{
+	auto const data_size = header.dim_size[0] * header.dim_size[1] * header.dim_size[2] * ElementSize(header.element_type);
+
+	if (header.data_offset < 0)
+	{
+		header.data_offset = std::ptrdiff_t(file->Size()) - std::ptrdiff_t(data_size);
+	}
+
+	if (header.data_offset < 0 || size_t(header.data_offset) + data_size > file->Size())
+	{
+		throw std::runtime_error(header.data_file + " is smaller than its header describes");
+	}
+
+	voxels = file->Data() + header.data_offset;
+}
+
+VolumeView MhdVolume::Volume() const noexcept
+{
+	auto const element_size = std::ptrdiff_t(ElementSize(header.element_type));
+	auto const row_stride = element_size * std::ptrdiff_t(header.dim_size[0]);
+	auto const slice_stride = row_stride * std::ptrdiff_t(header.dim_size[1]);
+
+	return {
+		voxels,
+		{ header.dim_size[2], header.dim_size[1], header.dim_size[0] },
+		{ slice_stride, row_stride, element_size },
+		header.element_type,
+		header.is_big_endian
+	};
+}
+
+VolumeView MhdVolume::Slice(size_t in_z) const
+{
+	if (in_z >= header.dim_size[2])
+	{
+		throw std::out_of_range("slice exceeds the volume");
+	}
+
+	auto view = SubVolume({ in_z, 0, 0 }, { in_z + 1, header.dim_size[1], header.dim_size[0] });
+
+	file->Prefetch(size_t(header.data_offset + std::ptrdiff_t(in_z) * view.strides[0]), size_t(view.strides[0]));
+
+	return view;
+}
+
+VolumeView MhdVolume::SubVolume(std::array<size_t, 3> const & in_begin, std::array<size_t, 3> const & in_end) const
+{
+	auto view = Volume();
+
+	for (size_t axis = 0; axis < 3; ++axis)
+	{
+		if (in_begin[axis] > in_end[axis] || in_end[axis] > view.shape[axis])
+		{
+			throw std::out_of_range("sub-volume exceeds the volume");
+		}
+
+		view.data += std::ptrdiff_t(in_begin[axis]) * view.strides[axis];
+		view.shape[axis] = in_end[axis] - in_begin[axis];
+	}
+
+	return view;
+}
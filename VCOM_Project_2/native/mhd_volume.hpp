@@ -0,0 +1,65 @@
+#ifndef MHD_VOLUME_HEADER
+#define MHD_VOLUME_HEADER
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "element_type.hpp"
+#include "mapped_file.hpp"
+
+// Metadata of an uncompressed single channel MetaImage, in the same conventions as SimpleITK
+struct MhdHeader
+{
+	std::array<size_t, 3> dim_size; // Voxels along x, y and z (1 along z for 2D images)
+	std::array<double, 3> spacing; // Along x, y and z
+	std::array<double, 3> origin; // World coordinates of the first voxel
+	std::array<double, 9> direction; // Row-major, each column being the world direction of one image axis
+
+	int element_type;
+	bool is_big_endian;
+
+	std::string data_file; // Path of the data file, which is the header itself for local data
+	std::ptrdiff_t data_offset; // Position of the voxels in the data file, or -1 if they end with it
+};
+
+// Parses a .mhd header, throwing std::runtime_error if it is malformed or describes data that cannot be mapped
+MhdHeader ReadMhdHeader(std::string const & in_path);
+
+// Strided view of voxels of a volume, in z, y, x order as SimpleITK arrays are
+struct VolumeView
+{
+	std::byte const * data;
+	std::array<size_t, 3> shape;
+	std::array<std::ptrdiff_t, 3> strides; // In bytes
+	int element_type;
+	bool is_big_endian;
+};
+
+// Volume of a .mhd/.raw pair whose data file is memory-mapped, so that only the voxels that are accessed are read from disk
+class MhdVolume
+{
+public:
+	explicit MhdVolume(std::string const & in_path);
+
+	MhdHeader const & Header() const noexcept
+	{
+		return header;
+	}
+
+	// Whole volume
+	VolumeView Volume() const noexcept;
+	// Single slice along z, which is read ahead as a whole, throwing std::out_of_range if it does not exist
+	VolumeView Slice(size_t in_z) const;
+	// Voxels from the begin up to the end of each of the z, y and x ranges, throwing std::out_of_range if they exceed the volume
+	VolumeView SubVolume(std::array<size_t, 3> const & in_begin, std::array<size_t, 3> const & in_end) const;
+
+private:
+	MhdHeader header;
+	std::unique_ptr<MappedFile> file;
+	std::byte const * voxels;
+
+};
+
+#endif
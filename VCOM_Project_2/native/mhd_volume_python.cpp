@@ -0,0 +1,319 @@
+#include <array>
+#include <string>
+
+#include "python_common.hpp"
+
+namespace
+{
+	struct MhdVolumeObject
+	{
+		PyObject_HEAD
+		MhdVolume * volume;
+	};
+
+	PyTypeObject * volume_type = nullptr;
+
+	// Read-only array over the mapped voxels of a view, which keeps the volume object (and so the mapping) alive
+	PyObject * NewViewArray(VolumeView const & in_view, int in_dims, PyObject * in_owner)
+	{
+		PyArray_Descr * descr = NewElementDescr(in_view.element_type, in_view.is_big_endian);
+		if (!descr)
+		{
+			return nullptr;
+		}
+
+		// The leading axes are dropped for slices
+		auto const first_axis = size_t(3 - in_dims);
+
+		npy_intp dims[3];
+		npy_intp strides[3];
+
+		for (size_t axis = first_axis; axis < 3; ++axis)
+		{
+			dims[axis - first_axis] = npy_intp(in_view.shape[axis]);
+			strides[axis - first_axis] = npy_intp(in_view.strides[axis]);
+		}
+
+		// Steals the reference to the descriptor, and leaves the array read-only since it is not flagged as writeable
+		PyObject * array = PyArray_NewFromDescr(&PyArray_Type, descr, in_dims, dims, strides, const_cast<std::byte *>(in_view.data), 0, nullptr);
+		if (!array)
+		{
+			return nullptr;
+		}
+
+		Py_INCREF(in_owner);
+		if (PyArray_SetBaseObject(reinterpret_cast<PyArrayObject *>(array), in_owner) != 0)
+		{
+			Py_DECREF(array);
+			return nullptr;
+		}
+
+		return array;
+	}
+
+	MhdVolume const * CheckedVolume(PyObject * in_self)
+	{
+		auto const volume = reinterpret_cast<MhdVolumeObject *>(in_self)->volume;
+		if (!volume)
+		{
+			PyErr_SetString(PyExc_ValueError, "MhdVolume was not initialized");
+		}
+		return volume;
+	}
+
+	int Init(PyObject * in_self, PyObject * in_args, PyObject * in_kwargs)
+	{
+		static char const * keywords[] = { "path", nullptr };
+
+		PyObject * path_bytes = nullptr;
+
+		if (!PyArg_ParseTupleAndKeywords(in_args, in_kwargs, "O&", const_cast<char **>(keywords), PyUnicode_FSConverter, &path_bytes))
+		{
+			return -1;
+		}
+
+		std::string const path = PyBytes_AS_STRING(path_bytes);
+		Py_DECREF(path_bytes);
+
+		auto const self = reinterpret_cast<MhdVolumeObject *>(in_self);
+
+		// Arrays over the mapping may still be alive, so it cannot be replaced
+		if (self->volume)
+		{
+			PyErr_SetString(PyExc_RuntimeError, "MhdVolume cannot be initialized twice");
+			return -1;
+		}
+
+		try
+		{
+			self->volume = new MhdVolume(path);
+		}
+		catch (...)
+		{
+			SetPythonError();
+			return -1;
+		}
+
+		return 0;
+	}
+
+	void Dealloc(PyObject * in_self)
+	{
+		auto const type = Py_TYPE(in_self);
+
+		delete reinterpret_cast<MhdVolumeObject *>(in_self)->volume;
+
+		reinterpret_cast<freefunc>(PyType_GetSlot(type, Py_tp_free))(in_self);
+		Py_DECREF(type);
+	}
+
+	PyObject * Slice(PyObject * in_self, PyObject * in_args)
+	{
+		Py_ssize_t z = 0;
+
+		if (!PyArg_ParseTuple(in_args, "n", &z))
+		{
+			return nullptr;
+		}
+
+		auto const volume = CheckedVolume(in_self);
+		if (!volume)
+		{
+			return nullptr;
+		}
+
+		// Negative indices count from the last slice, as in NumPy
+
+		if (z < 0)
+		{
+			z += Py_ssize_t(volume->Header().dim_size[2]);
+		}
+		if (z < 0)
+		{
+			PyErr_SetString(PyExc_IndexError, "slice exceeds the volume");
+			return nullptr;
+		}
+
+		try
+		{
+			return NewViewArray(volume->Slice(size_t(z)), 2, in_self);
+		}
+		catch (...)
+		{
+			SetPythonError();
+			return nullptr;
+		}
+	}
+
+	PyObject * SubVolume(PyObject * in_self, PyObject * in_args)
+	{
+		Py_ssize_t begin[3];
+		Py_ssize_t end[3];
+
+		if (!PyArg_ParseTuple(in_args, "(nnn)(nnn)", &begin[0], &begin[1], &begin[2], &end[0], &end[1], &end[2]))
+		{
+			return nullptr;
+		}
+
+		auto const volume = CheckedVolume(in_self);
+		if (!volume)
+		{
+			return nullptr;
+		}
+
+		if (begin[0] < 0 || begin[1] < 0 || begin[2] < 0 || end[0] < 0 || end[1] < 0 || end[2] < 0)
+		{
+			PyErr_SetString(PyExc_IndexError, "sub-volume exceeds the volume");
+			return nullptr;
+		}
+
+		try
+		{
+			return NewViewArray(volume->SubVolume(
+				{ size_t(begin[0]), size_t(begin[1]), size_t(begin[2]) },
+				{ size_t(end[0]), size_t(end[1]), size_t(end[2]) }), 3, in_self);
+		}
+		catch (...)
+		{
+			SetPythonError();
+			return nullptr;
+		}
+	}
+
+	PyObject * NewTuple(double const * in_values, size_t in_count)
+	{
+		PyObject * tuple = PyTuple_New(Py_ssize_t(in_count));
+
+		for (size_t idx = 0; tuple && idx < in_count; ++idx)
+		{
+			PyObject * value = PyFloat_FromDouble(in_values[idx]);
+			if (!value)
+			{
+				Py_DECREF(tuple);
+				return nullptr;
+			}
+
+			// Steals the reference to the value
+			PyTuple_SET_ITEM(tuple, Py_ssize_t(idx), value);
+		}
+		return tuple;
+	}
+
+	PyObject * GetArray(PyObject * in_self, void *)
+	{
+		auto const volume = CheckedVolume(in_self);
+
+		return volume ? NewViewArray(volume->Volume(), 3, in_self) : nullptr;
+	}
+
+	PyObject * GetShape(PyObject * in_self, void *)
+	{
+		auto const volume = CheckedVolume(in_self);
+		if (!volume)
+		{
+			return nullptr;
+		}
+
+		auto const & dim_size = volume->Header().dim_size;
+
+		return Py_BuildValue("(nnn)", Py_ssize_t(dim_size[2]), Py_ssize_t(dim_size[1]), Py_ssize_t(dim_size[0]));
+	}
+
+	PyObject * GetDtype(PyObject * in_self, void *)
+	{
+		auto const volume = CheckedVolume(in_self);
+
+		return volume ? reinterpret_cast<PyObject *>(NewElementDescr(volume->Header().element_type, volume->Header().is_big_endian)) : nullptr;
+	}
+
+	PyObject * GetSpacing(PyObject * in_self, void *)
+	{
+		auto const volume = CheckedVolume(in_self);
+
+		return volume ? NewTuple(volume->Header().spacing.data(), 3) : nullptr;
+	}
+
+	PyObject * GetOrigin(PyObject * in_self, void *)
+	{
+		auto const volume = CheckedVolume(in_self);
+
+		return volume ? NewTuple(volume->Header().origin.data(), 3) : nullptr;
+	}
+
+	PyObject * GetDirection(PyObject * in_self, void *)
+	{
+		auto const volume = CheckedVolume(in_self);
+
+		return volume ? NewTuple(volume->Header().direction.data(), 9) : nullptr;
+	}
+
+	PyMethodDef volume_methods[] = {
+		{ "slice", Slice, METH_VARARGS,
+			"slice(z)\n\n"
+			"Read-only view of the slice at z, of shape (y, x), whose pages are read ahead as a whole and nothing else." },
+		{ "subvolume", SubVolume, METH_VARARGS,
+			"subvolume(begin, end)\n\n"
+			"Read-only view of the voxels from begin up to end, both (z, y, x) tuples." },
+		{ nullptr, nullptr, 0, nullptr }
+	};
+
+	PyGetSetDef volume_getset[] = {
+		{ "array", GetArray, nullptr, "Read-only view of the whole volume, of shape (z, y, x) as from SimpleITK.GetArrayFromImage", nullptr },
+		{ "shape", GetShape, nullptr, "Shape of the volume, as (z, y, x)", nullptr },
+		{ "dtype", GetDtype, nullptr, "Data type of the voxels", nullptr },
+		{ "spacing", GetSpacing, nullptr, "Voxel size, as (x, y, z) as from SimpleITK.Image.GetSpacing", nullptr },
+		{ "origin", GetOrigin, nullptr, "World coordinates of the first voxel, as from SimpleITK.Image.GetOrigin", nullptr },
+		{ "direction", GetDirection, nullptr, "Row-major 3D rotation matrix, as from SimpleITK.Image.GetDirection", nullptr },
+		{ nullptr, nullptr, nullptr, nullptr, nullptr }
+	};
+
+	PyType_Slot volume_slots[] = {
+		{ Py_tp_doc, const_cast<char *>(
+			"MhdVolume(path)\n\n"
+			"Memory-mapped volume of an uncompressed .mhd/.raw pair, whose voxels are only read from disk once accessed.") },
+		{ Py_tp_new, reinterpret_cast<void *>(PyType_GenericNew) },
+		{ Py_tp_init, reinterpret_cast<void *>(Init) },
+		{ Py_tp_dealloc, reinterpret_cast<void *>(Dealloc) },
+		{ Py_tp_methods, volume_methods },
+		{ Py_tp_getset, volume_getset },
+		{ 0, nullptr }
+	};
+
+	PyType_Spec volume_spec = {
+		"lndb_native.MhdVolume",
+		sizeof(MhdVolumeObject),
+		0,
+		Py_TPFLAGS_DEFAULT,
+		volume_slots
+	};
+}
+
+bool AddMhdVolumeType(PyObject * io_module)
+{
+	volume_type = reinterpret_cast<PyTypeObject *>(PyType_FromSpec(&volume_spec));
+	if (!volume_type)
+	{
+		return false;
+	}
+
+	// Steals a reference to the type on success only
+	Py_INCREF(volume_type);
+	if (PyModule_AddObject(io_module, "MhdVolume", reinterpret_cast<PyObject *>(volume_type)) != 0)
+	{
+		Py_DECREF(volume_type);
+		return false;
+	}
+
+	return true;
+}
+
+MhdVolume const * GetMhdVolume(PyObject * in_object)
+{
+	if (!volume_type || !PyObject_TypeCheck(in_object, volume_type))
+	{
+		PyErr_SetString(PyExc_TypeError, "expected an MhdVolume");
+		return nullptr;
+	}
+
+	return CheckedVolume(in_object);
+}
@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "parallel.hpp"
+
+size_t DefaultThreadCount() noexcept
+{
+	return std::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+}
+
+void ParallelFor(size_t in_count, size_t in_thread_count, std::function<void(size_t)> const & in_body)
+{
+	auto const thread_count = std::min(in_thread_count == 0 ? DefaultThreadCount() : in_thread_count, in_count);
+
+	std::atomic_size_t next_idx = 0;
+
+	std::mutex exception_mutex;
+	std::exception_ptr first_exception;
+
+	auto const worker = [&]
+	{
+		for (size_t idx; (idx = next_idx.fetch_add(1, std::memory_order_relaxed)) < in_count;)
+		{
+			try
+			{
+				in_body(idx);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock{ exception_mutex };
+
+				if (!first_exception)
+				{
+					first_exception = std::current_exception();
+				}
+
+				// Skip the indices left, since the loop failed anyway
+				next_idx.store(in_count, std::memory_order_relaxed);
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(thread_count > 0 ? thread_count - 1 : 0);
+
+	for (size_t thread_idx = 1; thread_idx < thread_count; ++thread_idx)
+	{
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (auto & thread : threads)
+	{
+		thread.join();
+	}
+
+	if (first_exception)
+	{
+		std::rethrow_exception(first_exception);
+	}
+}
+
+ThreadPool::ThreadPool(size_t in_thread_count)
+	: loop_generation{ 0 }
+	, running_workers{ 0 }
+	, is_stopping{ false }
+	, body{ nullptr }
+	, count{ 0 }
+	, next_idx{ 0 }
+{
+	auto const thread_count = in_thread_count == 0 ? DefaultThreadCount() : in_thread_count;
+
+	threads.reserve(thread_count - 1);
+
+	try
+	{
+		for (size_t thread_idx = 1; thread_idx < thread_count; ++thread_idx)
+		{
+			threads.emplace_back(&ThreadPool::WorkerLoop, this);
+		}
+	}
+	catch (...)
+	{
+		// The destructor is not run for a pool that failed to construct, so the threads already started are stopped here
+		Stop();
+		throw;
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	Stop();
+}
+
+void ThreadPool::Stop() noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		is_stopping = true;
+	}
+	loop_started.notify_all();
+
+	for (auto & thread : threads)
+	{
+		thread.join();
+	}
+}
+
+void ThreadPool::ParallelFor(size_t in_count, std::function<void(size_t)> const & in_body)
+{
+	// Nothing to gain from the workers for a single index
+
+	if (in_count <= 1 || threads.empty())
+	{
+		for (size_t idx = 0; idx < in_count; ++idx)
+		{
+			in_body(idx);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+
+		body = &in_body;
+		count = in_count;
+		next_idx.store(0, std::memory_order_relaxed);
+		first_exception = nullptr;
+
+		running_workers = threads.size();
+		++loop_generation;
+	}
+	loop_started.notify_all();
+
+	RunIndices();
+
+	// Every worker takes part in every loop, so the next one cannot start before all of them are done with this one
+
+	std::exception_ptr exception;
+
+	{
+		std::unique_lock<std::mutex> lock{ mutex };
+		loop_finished.wait(lock, [this] { return running_workers == 0; });
+
+		body = nullptr;
+		exception = std::exchange(first_exception, nullptr);
+	}
+
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+}
+
+void ThreadPool::WorkerLoop() noexcept
+{
+	std::uint64_t seen_generation = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock{ mutex };
+			loop_started.wait(lock, [&] { return is_stopping || loop_generation != seen_generation; });
+
+			if (is_stopping)
+			{
+				return;
+			}
+			seen_generation = loop_generation;
+		}
+
+		RunIndices();
+
+		bool is_last = false;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			is_last = --running_workers == 0;
+		}
+		if (is_last)
+		{
+			loop_finished.notify_one();
+		}
+	}
+}
+
+void ThreadPool::RunIndices() noexcept
+{
+	for (size_t idx; (idx = next_idx.fetch_add(1, std::memory_order_relaxed)) < count;)
+	{
+		try
+		{
+			(*body)(idx);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+
+			if (!first_exception)
+			{
+				first_exception = std::current_exception();
+			}
+
+			// Skip the indices left, since the loop failed anyway
+			next_idx.store(count, std::memory_order_relaxed);
+		}
+	}
+}
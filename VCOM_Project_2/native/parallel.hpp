@@ -0,0 +1,63 @@
+#ifndef PARALLEL_HEADER
+#define PARALLEL_HEADER
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of threads used for a thread count of 0, which is the number of hardware threads
+size_t DefaultThreadCount() noexcept;
+
+// Runs the body for every index up to the count on the specified number of threads, the calling thread being one of them,
+// handing out indices one at a time so that uneven work balances itself, then rethrows the first exception thrown by the body, if any
+void ParallelFor(size_t in_count, size_t in_thread_count, std::function<void(size_t)> const & in_body);
+
+// Threads kept alive across loops, for callers that run many short loops, which would otherwise spend as long creating threads as running them
+// Loops run as ParallelFor does, the calling thread being one of the threads, but must not be run concurrently on the same pool
+class ThreadPool
+{
+public:
+	// A thread count of 0 uses the number of hardware threads
+	explicit ThreadPool(size_t in_thread_count);
+	~ThreadPool();
+
+	ThreadPool(ThreadPool const &) = delete;
+	ThreadPool & operator=(ThreadPool const &) = delete;
+
+	size_t ThreadCount() const noexcept
+	{
+		return threads.size() + 1;
+	}
+
+	void ParallelFor(size_t in_count, std::function<void(size_t)> const & in_body);
+
+private:
+	void Stop() noexcept;
+	void WorkerLoop() noexcept;
+	// Runs indices of the current loop until none are left
+	void RunIndices() noexcept;
+
+	std::vector<std::thread> threads;
+
+	std::mutex mutex;
+	std::condition_variable loop_started;
+	std::condition_variable loop_finished;
+	std::uint64_t loop_generation;
+	size_t running_workers;
+	bool is_stopping;
+
+	// Current loop, only changed while no worker runs it
+	std::function<void(size_t)> const * body;
+	size_t count;
+	std::atomic_size_t next_idx;
+	std::exception_ptr first_exception;
+
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef PYTHON_COMMON_HEADER
+#define PYTHON_COMMON_HEADER
+
+#include <string>
+
+// Every translation unit of the module shares the NumPy API imported by python_module.cpp, which defines LNDB_NATIVE_MODULE
+
+// The release interpreter is linked in every configuration, since debug builds of Python are seldom installed
+
+#if defined(_DEBUG)
+#undef _DEBUG
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#define _DEBUG
+#else
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#endif
+
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#define PY_ARRAY_UNIQUE_SYMBOL LNDB_NATIVE_ARRAY_API
+#if !defined(LNDB_NATIVE_MODULE)
+#define NO_IMPORT_ARRAY
+#endif
+#include <numpy/arrayobject.h>
+
+#include "mhd_volume.hpp"
+#include "sample_store.hpp"
+
+// Sets the Python exception matching the exception being handled, to be called from a catch block
+void SetPythonError();
+
+// Data type of elements of the type, with the specified byte order
+PyArray_Descr * NewElementDescr(int in_element_type, bool is_big_endian);
+// Element type of the elements of the array, ignoring their byte order, or -1 if none matches them
+int ArrayElementType(PyArrayObject * in_array) noexcept;
+
+// Adds the MhdVolume type to the module, returning false with a Python exception set on failure
+bool AddMhdVolumeType(PyObject * io_module);
+// Volume of a MhdVolume object, or nullptr with a Python exception set if the object is not one
+MhdVolume const * GetMhdVolume(PyObject * in_object);
+
+// Adds the SampleStore type to the module, returning false with a Python exception set on failure
+bool AddSampleStoreType(PyObject * io_module);
+// Opens the sample store at the path as a SampleStore object, or returns nullptr with a Python exception set
+PyObject * OpenSampleStore(std::string const & in_path);
+// Store of a SampleStore object, or nullptr with a Python exception set if the object is not one
+SampleStore const * GetSampleStore(PyObject * in_object);
+// Converter of a sample encoding name ('raw', 'uint8' or 'float16') into a SampleEncoding, for PyArg_ParseTuple's O& format
+int ConvertSampleEncoding(PyObject * in_object, void * out_encoding);
+
+// Adds the BatchLoader type to the module, returning false with a Python exception set on failure
+bool AddBatchLoaderType(PyObject * io_module);
+
+// Adds the functions of the preprocessing engine to the module, returning false with a Python exception set on failure
+bool AddPreprocessingFunctions(PyObject * io_module);
+
+// Adds the functions of the cube extractor to the module, returning false with a Python exception set on failure
+bool AddCubeExtractionFunctions(PyObject * io_module);
+
+// Adds the functions of the Fleischner scoring engine to the module, returning false with a Python exception set on failure
+bool AddFleischnerFunctions(PyObject * io_module);
+
+#endif
@@ -0,0 +1,115 @@
+#include <new>
+#include <stdexcept>
+
+#define LNDB_NATIVE_MODULE
+#include "python_common.hpp"
+
+namespace
+{
+	int NumpyType(int in_element_type) noexcept
+	{
+		switch (in_element_type)
+		{
+		case ElementType::Int8:
+			return NPY_INT8;
+		case ElementType::UInt8:
+			return NPY_UINT8;
+		case ElementType::Int16:
+			return NPY_INT16;
+		case ElementType::UInt16:
+			return NPY_UINT16;
+		case ElementType::Int32:
+			return NPY_INT32;
+		case ElementType::UInt32:
+			return NPY_UINT32;
+		case ElementType::Float32:
+			return NPY_FLOAT32;
+		case ElementType::Float64:
+		default:
+			return NPY_FLOAT64;
+		}
+	}
+
+	PyModuleDef module_definition = {
+		PyModuleDef_HEAD_INIT,
+		"lndb_native",
+		"Native processing of LNDb scans for VCOM_Project_2",
+		-1,
+		nullptr
+	};
+}
+
+void SetPythonError()
+{
+	try
+	{
+		throw;
+	}
+	catch (std::bad_alloc const &)
+	{
+		PyErr_NoMemory();
+	}
+	catch (std::out_of_range const & exception)
+	{
+		PyErr_SetString(PyExc_IndexError, exception.what());
+	}
+	catch (std::invalid_argument const & exception)
+	{
+		PyErr_SetString(PyExc_ValueError, exception.what());
+	}
+	catch (std::exception const & exception)
+	{
+		PyErr_SetString(PyExc_RuntimeError, exception.what());
+	}
+}
+
+PyArray_Descr * NewElementDescr(int in_element_type, bool is_big_endian)
+{
+	PyArray_Descr * descr = PyArray_DescrFromType(NumpyType(in_element_type));
+
+	if (descr && is_big_endian)
+	{
+		PyArray_Descr * swapped_descr = PyArray_DescrNewByteorder(descr, NPY_BIG);
+		Py_DECREF(descr);
+		descr = swapped_descr;
+	}
+	return descr;
+}
+
+int ArrayElementType(PyArrayObject * in_array) noexcept
+{
+	auto const size = PyArray_ITEMSIZE(in_array);
+
+	// Type numbers are compared by kind and size, since different C types share the same sizes
+	switch (PyArray_DESCR(in_array)->kind)
+	{
+	case 'i':
+		return size == 1 ? ElementType::Int8 : size == 2 ? ElementType::Int16 : size == 4 ? ElementType::Int32 : -1;
+	case 'u':
+		return size == 1 ? ElementType::UInt8 : size == 2 ? ElementType::UInt16 : size == 4 ? ElementType::UInt32 : -1;
+	case 'f':
+		return size == 4 ? ElementType::Float32 : size == 8 ? ElementType::Float64 : -1;
+	default:
+		return -1;
+	}
+}
+
+PyMODINIT_FUNC PyInit_lndb_native()
+{
+	import_array();
+
+	PyObject * module = PyModule_Create(&module_definition);
+	if (!module)
+	{
+		return nullptr;
+	}
+
+	if (!AddMhdVolumeType(module) || !AddSampleStoreType(module) || !AddBatchLoaderType(module) || !AddPreprocessingFunctions(module)
+		|| !AddCubeExtractionFunctions(module) || !AddFleischnerFunctions(module))
+	{
+		Py_DECREF(module);
+		return nullptr;
+	}
+
+	return module;
+}
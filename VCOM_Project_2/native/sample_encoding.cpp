@@ -0,0 +1,160 @@
+#include <cmath>
+#include <cstring>
+
+#include "element_type.hpp"
+#include "sample_encoding.hpp"
+
+namespace
+{
+	std::uint32_t FloatBits(float in_value) noexcept
+	{
+		std::uint32_t bits;
+		std::memcpy(&bits, &in_value, sizeof(bits));
+		return bits;
+	}
+
+	float BitsFloat(std::uint32_t in_bits) noexcept
+	{
+		float value;
+		std::memcpy(&value, &in_bits, sizeof(value));
+		return value;
+	}
+
+	// Shifts the bits right, rounding to nearest with ties to even
+	std::uint32_t ShiftRounded(std::uint32_t in_bits, std::uint32_t in_shift) noexcept
+	{
+		std::uint32_t const shifted = in_bits >> in_shift;
+		std::uint32_t const remainder = in_bits & ((1u << in_shift) - 1);
+		std::uint32_t const half = 1u << (in_shift - 1);
+
+		return shifted + (remainder > half || (remainder == half && (shifted & 1)) ? 1 : 0);
+	}
+}
+
+size_t EncodedElementSize(int in_encoding, int in_element_type) noexcept
+{
+	switch (in_encoding)
+	{
+	case SampleEncoding::UInt8:
+		return 1;
+	case SampleEncoding::Float16:
+		return 2;
+	case SampleEncoding::Raw:
+	default:
+		return ElementSize(in_element_type);
+	}
+}
+
+std::uint16_t FloatToHalf(float in_value) noexcept
+{
+	std::uint32_t const bits = FloatBits(in_value);
+	auto const sign = std::uint16_t((bits >> 16) & 0x8000);
+	std::uint32_t const magnitude = bits & 0x7FFFFFFF;
+
+	// Infinities and NaNs, keeping NaNs quiet
+	if (magnitude >= 0x7F800000)
+	{
+		return std::uint16_t(sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x0200 : 0));
+	}
+	// Anything from 65520 up rounds to infinity
+	if (magnitude >= 0x477FF000)
+	{
+		return std::uint16_t(sign | 0x7C00);
+	}
+	// Anything below 2^-14 becomes subnormal, and anything up to 2^-25 rounds to zero
+	if (magnitude < 0x38800000)
+	{
+		if (magnitude <= 0x33000000)
+		{
+			return sign;
+		}
+
+		std::uint32_t const exponent = magnitude >> 23;
+		std::uint32_t const mantissa = (magnitude & 0x007FFFFF) | 0x00800000;
+
+		return std::uint16_t(sign | ShiftRounded(mantissa, 126 - exponent));
+	}
+
+	// The exponent is rebiased from 127 to 15, and a mantissa rounding up carries into the exponent as it should
+	return std::uint16_t(sign | ShiftRounded(magnitude - 0x38000000, 13));
+}
+
+float HalfToFloat(std::uint16_t in_value) noexcept
+{
+	std::uint32_t const sign = std::uint32_t(in_value & 0x8000) << 16;
+	std::uint32_t const exponent = (in_value >> 10) & 0x1F;
+	std::uint32_t const mantissa = in_value & 0x03FF;
+
+	if (exponent == 0)
+	{
+		// Subnormals are exact multiples of 2^-24
+		float const magnitude = float(mantissa) * 5.9604644775390625e-8f;
+		return sign ? -magnitude : magnitude;
+	}
+	if (exponent == 0x1F)
+	{
+		return BitsFloat(sign | 0x7F800000 | (mantissa << 13));
+	}
+	return BitsFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+void EncodeElements(float const * in_elements, size_t in_count, int in_encoding, float in_scale, float in_offset, std::byte * out_encoded) noexcept
+{
+	switch (in_encoding)
+	{
+	case SampleEncoding::UInt8:
+		for (size_t idx = 0; idx < in_count; ++idx)
+		{
+			float const step = std::floor((in_elements[idx] - in_offset) / in_scale + 0.5f);
+
+			// Comparisons are false for NaNs, which are left as 0
+			out_encoded[idx] = std::byte(step >= 255.0f ? 255 : step > 0.0f ? int(step) : 0);
+		}
+		break;
+	case SampleEncoding::Float16:
+		for (size_t idx = 0; idx < in_count; ++idx)
+		{
+			std::uint16_t const half = FloatToHalf(in_elements[idx]);
+			std::memcpy(out_encoded + idx * sizeof(half), &half, sizeof(half));
+		}
+		break;
+	case SampleEncoding::Raw:
+	default:
+		std::memcpy(out_encoded, in_elements, in_count * sizeof(float));
+		break;
+	}
+}
+
+void DecodeElements(std::byte const * in_encoded, size_t in_count, int in_encoding, float in_scale, float in_offset, float * out_elements) noexcept
+{
+	switch (in_encoding)
+	{
+	case SampleEncoding::UInt8:
+	{
+		// Every sample is long enough for a table of all 256 values to pay off
+		float values[256];
+		for (size_t value = 0; value < 256; ++value)
+		{
+			values[value] = in_offset + in_scale * float(value);
+		}
+
+		for (size_t idx = 0; idx < in_count; ++idx)
+		{
+			out_elements[idx] = values[size_t(in_encoded[idx])];
+		}
+		break;
+	}
+	case SampleEncoding::Float16:
+		for (size_t idx = 0; idx < in_count; ++idx)
+		{
+			std::uint16_t half;
+			std::memcpy(&half, in_encoded + idx * sizeof(half), sizeof(half));
+			out_elements[idx] = HalfToFloat(half);
+		}
+		break;
+	case SampleEncoding::Raw:
+	default:
+		std::memcpy(out_elements, in_encoded, in_count * sizeof(float));
+		break;
+	}
+}
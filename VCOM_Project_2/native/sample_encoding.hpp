@@ -0,0 +1,30 @@
+#ifndef SAMPLE_ENCODING_HEADER
+#define SAMPLE_ENCODING_HEADER
+
+#include <cstddef>
+#include <cstdint>
+
+// Encoding of the elements of samples on disk, either as they are, or float32 elements quantised to 8 bits or halved to 16-bit floats
+struct SampleEncoding
+{
+	enum _sample_encoding : int
+	{
+		Raw = 0,
+		UInt8, // Element = offset + scale * stored element
+		Float16,
+	};
+};
+
+// Size in bytes of an encoded element of the type
+size_t EncodedElementSize(int in_encoding, int in_element_type) noexcept;
+
+// IEEE 754 half precision float nearest to the float, ties to even, as numpy.float16
+std::uint16_t FloatToHalf(float in_value) noexcept;
+float HalfToFloat(std::uint16_t in_value) noexcept;
+
+// Encodes float32 elements, 8-bit ones being rounded to the nearest step of the scale above the offset and saturated, and NaNs becoming 0
+void EncodeElements(float const * in_elements, size_t in_count, int in_encoding, float in_scale, float in_offset, std::byte * out_encoded) noexcept;
+// Decodes float32 elements
+void DecodeElements(std::byte const * in_encoded, size_t in_count, int in_encoding, float in_scale, float in_offset, float * out_elements) noexcept;
+
+#endif
@@ -0,0 +1,203 @@
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+
+#include "sample_store.hpp"
+
+namespace
+{
+	constexpr char store_magic[8] = { 'L', 'N', 'D', 'B', 'S', 'T', 'O', 'R' };
+	constexpr std::uint32_t store_version = 2;
+	constexpr size_t max_sample_dims = 4;
+
+	struct StoreHeader
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::int32_t element_type;
+		std::uint64_t sample_count;
+		std::uint64_t sample_dims;
+		std::uint64_t sample_shape[max_sample_dims];
+		std::uint64_t labels_offset;
+		std::uint64_t samples_offset;
+		std::uint64_t sample_stride;
+		// Only from version 2, version 1 stores being raw
+		std::int32_t encoding;
+		float scale;
+		float offset;
+		std::uint32_t reserved;
+	};
+
+	static_assert(sizeof(StoreHeader) == 104, "the header is part of the file format");
+
+	constexpr size_t version_1_header_size = offsetof(StoreHeader, encoding);
+
+	size_t Product(std::vector<size_t> const & in_shape, size_t in_init) noexcept
+	{
+		return std::accumulate(in_shape.begin(), in_shape.end(), in_init, std::multiplies<size_t>());
+	}
+
+	size_t AlignChunk(size_t in_size) noexcept
+	{
+		return (in_size + SampleStore::chunk_alignment - 1) / SampleStore::chunk_alignment * SampleStore::chunk_alignment;
+	}
+}
+
+SampleStore::SampleStore(std::string const & in_path)
+	: file{ std::make_unique<MappedFile>(in_path) }
+{
+	StoreHeader header{};
+
+	if (file->Size() < version_1_header_size)
+	{
+		throw std::runtime_error(in_path + " is not a sample store");
+	}
+
+	std::memcpy(&header, file->Data(), version_1_header_size);
+
+	if (std::memcmp(header.magic, store_magic, sizeof(store_magic)) != 0 || header.sample_dims > max_sample_dims)
+	{
+		throw std::runtime_error(in_path + " is not a sample store");
+	}
+	if (header.version == 1)
+	{
+		header.encoding = SampleEncoding::Raw;
+		header.scale = 1.0f;
+	}
+	else if (header.version == store_version && file->Size() >= sizeof(header))
+	{
+		std::memcpy(&header, file->Data(), sizeof(header));
+	}
+	else
+	{
+		throw std::runtime_error(in_path + " is a sample store of an unsupported version");
+	}
+
+	if (header.element_type < ElementType::Int8 || header.element_type > ElementType::Float64 || header.encoding < SampleEncoding::Raw
+		|| header.encoding > SampleEncoding::Float16 || (header.encoding != SampleEncoding::Raw && header.element_type != ElementType::Float32))
+	{
+		throw std::runtime_error(in_path + " is not a sample store");
+	}
+
+	element_type = header.element_type;
+	sample_shape.assign(header.sample_shape, header.sample_shape + header.sample_dims);
+	sample_count = size_t(header.sample_count);
+	encoding = header.encoding;
+	scale = header.scale;
+	offset = header.offset;
+	sample_length = Product(sample_shape, 1);
+	sample_size = sample_length * EncodedElementSize(encoding, element_type);
+	sample_stride = size_t(header.sample_stride);
+	labels_offset = size_t(header.labels_offset);
+	samples_offset = size_t(header.samples_offset);
+
+	if (sample_stride < sample_size || labels_offset + sample_count * sizeof(std::int32_t) > samples_offset || samples_offset + sample_count * sample_stride > file->Size())
+	{
+		throw std::runtime_error(in_path + " is smaller than its header describes");
+	}
+}
+
+SampleStore::SampleStore(std::string const & in_path, int in_element_type, std::vector<size_t> const & in_sample_shape, size_t in_sample_count,
+	int in_encoding, float in_scale, float in_offset)
+	: element_type{ in_element_type }
+	, sample_shape{ in_sample_shape }
+	, sample_count{ in_sample_count }
+	, encoding{ in_encoding }
+	, scale{ in_scale }
+	, offset{ in_offset }
+	, sample_length{ Product(in_sample_shape, 1) }
+	, sample_size{ sample_length * EncodedElementSize(in_encoding, in_element_type) }
+	, sample_stride{ AlignChunk(sample_size) }
+	, labels_offset{ sizeof(StoreHeader) }
+	, samples_offset{ AlignChunk(sizeof(StoreHeader) + in_sample_count * sizeof(std::int32_t)) }
+{
+	if (in_sample_shape.size() > max_sample_dims)
+	{
+		throw std::invalid_argument("samples have too many dimensions");
+	}
+	if (in_encoding != SampleEncoding::Raw && in_element_type != ElementType::Float32)
+	{
+		throw std::invalid_argument("only float32 samples can be encoded");
+	}
+	if (in_encoding == SampleEncoding::UInt8 && !(in_scale > 0.0f))
+	{
+		throw std::invalid_argument("the scale of quantised samples must be positive");
+	}
+
+	// The file is created zeroed, so only the header has to be written
+
+	file = std::make_unique<MappedFile>(in_path, samples_offset + sample_count * sample_stride);
+
+	StoreHeader header{};
+	std::memcpy(header.magic, store_magic, sizeof(store_magic));
+	header.version = store_version;
+	header.element_type = std::int32_t(element_type);
+	header.sample_count = sample_count;
+	header.sample_dims = sample_shape.size();
+	std::copy(sample_shape.begin(), sample_shape.end(), header.sample_shape);
+	header.labels_offset = labels_offset;
+	header.samples_offset = samples_offset;
+	header.sample_stride = sample_stride;
+	header.encoding = std::int32_t(encoding);
+	header.scale = scale;
+	header.offset = offset;
+
+	std::memcpy(file->WritableData(), &header, sizeof(header));
+}
+
+void SampleStore::WriteSample(size_t in_idx, void const * in_elements) const noexcept
+{
+	if (encoding == SampleEncoding::Raw)
+	{
+		std::memcpy(WritableSample(in_idx), in_elements, sample_size);
+	}
+	else
+	{
+		EncodeElements(static_cast<float const *>(in_elements), sample_length, encoding, scale, offset, WritableSample(in_idx));
+	}
+}
+
+void SampleStore::ReadSample(size_t in_idx, void * out_elements) const noexcept
+{
+	if (encoding == SampleEncoding::Raw)
+	{
+		std::memcpy(out_elements, Sample(in_idx), sample_size);
+	}
+	else
+	{
+		DecodeElements(Sample(in_idx), sample_length, encoding, scale, offset, static_cast<float *>(out_elements));
+	}
+}
+
+void SampleStore::FlushSample(size_t in_idx) const noexcept
+{
+	file->Flush(samples_offset + in_idx * sample_stride, sample_size);
+}
+
+void SampleStore::PrefetchSample(size_t in_idx) const noexcept
+{
+	file->Prefetch(samples_offset + in_idx * sample_stride, sample_size);
+}
+
+void WriteSampleStore(std::string const & in_path, std::function<void(std::string const &)> const & in_write)
+{
+	// Paths are UTF-8, as Python encodes them
+	auto const path = std::filesystem::u8path(in_path);
+	auto const temp_path = std::filesystem::u8path(in_path + ".tmp");
+
+	try
+	{
+		in_write(temp_path.u8string());
+	}
+	catch (...)
+	{
+		std::error_code error;
+		std::filesystem::remove(temp_path, error);
+		throw;
+	}
+
+	std::filesystem::rename(temp_path, path);
+}
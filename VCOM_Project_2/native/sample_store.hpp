@@ -0,0 +1,122 @@
+#ifndef SAMPLE_STORE_HEADER
+#define SAMPLE_STORE_HEADER
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "element_type.hpp"
+#include "mapped_file.hpp"
+#include "sample_encoding.hpp"
+
+// On-disk array of labelled samples of the same shape, each in its own chunk aligned to a page, so that any sample is read (or written)
+// through the memory mapping without touching the pages of any other
+// Layout: header, labels (int32), then the chunks of the samples, all little-endian
+// Float32 samples may be encoded, quantised to 8 bits or halved to 16-bit floats, to be decoded as they are read
+class SampleStore
+{
+public:
+	static constexpr size_t chunk_alignment = 4096;
+
+	// Opens an existing store for reading, throwing std::runtime_error if it cannot be mapped or is not a valid store
+	explicit SampleStore(std::string const & in_path);
+	// Creates (or replaces) a store of the specified number of samples for writing, with all samples and labels zeroed
+	// Throws std::invalid_argument if samples other than float32 ones are encoded
+	SampleStore(std::string const & in_path, int in_element_type, std::vector<size_t> const & in_sample_shape, size_t in_sample_count,
+		int in_encoding = SampleEncoding::Raw, float in_scale = 1.0f, float in_offset = 0.0f);
+
+	int ElementType() const noexcept
+	{
+		return element_type;
+	}
+	std::vector<size_t> const & SampleShape() const noexcept
+	{
+		return sample_shape;
+	}
+	size_t SampleCount() const noexcept
+	{
+		return sample_count;
+	}
+	int Encoding() const noexcept
+	{
+		return encoding;
+	}
+	float Scale() const noexcept
+	{
+		return scale;
+	}
+	float Offset() const noexcept
+	{
+		return offset;
+	}
+	// Number of elements of a sample
+	size_t SampleLength() const noexcept
+	{
+		return sample_length;
+	}
+	// Size of an encoded sample, without the padding up to the next chunk
+	size_t SampleSize() const noexcept
+	{
+		return sample_size;
+	}
+	size_t SampleStride() const noexcept
+	{
+		return sample_stride;
+	}
+
+	std::byte const * Sample(size_t in_idx) const noexcept
+	{
+		return file->Data() + samples_offset + in_idx * sample_stride;
+	}
+	std::int32_t const * Labels() const noexcept
+	{
+		return reinterpret_cast<std::int32_t const *>(file->Data() + labels_offset);
+	}
+
+	// Writable sample and labels, only for stores created for writing
+	std::byte * WritableSample(size_t in_idx) const noexcept
+	{
+		return file->WritableData() + samples_offset + in_idx * sample_stride;
+	}
+	std::int32_t * WritableLabels() const noexcept
+	{
+		return reinterpret_cast<std::int32_t *>(file->WritableData() + labels_offset);
+	}
+
+	// Encodes the elements of a sample into it, only for stores created for writing
+	void WriteSample(size_t in_idx, void const * in_elements) const noexcept;
+	// Decodes the elements of a sample
+	void ReadSample(size_t in_idx, void * out_elements) const noexcept;
+
+	// Starts writing a finished sample back to disk, so that finished samples do not pile up in memory
+	void FlushSample(size_t in_idx) const noexcept;
+	// Hints that a sample will be read soon
+	void PrefetchSample(size_t in_idx) const noexcept;
+
+private:
+	std::unique_ptr<MappedFile> file;
+
+	int element_type;
+	std::vector<size_t> sample_shape;
+	size_t sample_count;
+	int encoding;
+	float scale;
+	float offset;
+	size_t sample_length;
+	size_t sample_size;
+	size_t sample_stride;
+
+	size_t labels_offset;
+	size_t samples_offset;
+
+};
+
+// Writes a store through the writer at a temporary path beside the specified one, which it is moved to only once the writer returns,
+// so that a failed or interrupted write never leaves a store there that could be opened (the temporary one is removed if the writer throws)
+// The writer should create the store at the path it is given and close it before returning, as a mapped file cannot be moved on Windows
+void WriteSampleStore(std::string const & in_path, std::function<void(std::string const &)> const & in_write);
+
+#endif
@@ -0,0 +1,440 @@
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "parallel.hpp"
+#include "python_common.hpp"
+#include "sample_store.hpp"
+
+namespace
+{
+	struct SampleStoreObject
+	{
+		PyObject_HEAD
+		SampleStore * store;
+	};
+
+	PyTypeObject * store_type = nullptr;
+
+	char const * const encoding_names[] = { "raw", "uint8", "float16" };
+
+	SampleStore const * CheckedStore(PyObject * in_self)
+	{
+		auto const store = reinterpret_cast<SampleStoreObject *>(in_self)->store;
+		if (!store)
+		{
+			PyErr_SetString(PyExc_ValueError, "SampleStore was not initialized");
+		}
+		return store;
+	}
+
+	// Read-only array over mapped data, which keeps the store object (and so the mapping) alive
+	PyObject * NewMappedArray(PyArray_Descr * in_descr, int in_dims, npy_intp * in_shape, npy_intp * in_strides, std::byte const * in_data, PyObject * in_owner)
+	{
+		if (!in_descr)
+		{
+			return nullptr;
+		}
+
+		// Steals the reference to the descriptor, and leaves the array read-only since it is not flagged as writeable
+		PyObject * array = PyArray_NewFromDescr(&PyArray_Type, in_descr, in_dims, in_shape, in_strides, const_cast<std::byte *>(in_data), 0, nullptr);
+		if (!array)
+		{
+			return nullptr;
+		}
+
+		Py_INCREF(in_owner);
+		if (PyArray_SetBaseObject(reinterpret_cast<PyArrayObject *>(array), in_owner) != 0)
+		{
+			Py_DECREF(array);
+			return nullptr;
+		}
+
+		return array;
+	}
+
+	int Init(PyObject * in_self, PyObject * in_args, PyObject * in_kwargs)
+	{
+		static char const * keywords[] = { "path", nullptr };
+
+		PyObject * path_bytes = nullptr;
+
+		if (!PyArg_ParseTupleAndKeywords(in_args, in_kwargs, "O&", const_cast<char **>(keywords), PyUnicode_FSConverter, &path_bytes))
+		{
+			return -1;
+		}
+
+		std::string const path = PyBytes_AS_STRING(path_bytes);
+		Py_DECREF(path_bytes);
+
+		auto const self = reinterpret_cast<SampleStoreObject *>(in_self);
+
+		// Arrays over the mapping may still be alive, so it cannot be replaced
+		if (self->store)
+		{
+			PyErr_SetString(PyExc_RuntimeError, "SampleStore cannot be initialized twice");
+			return -1;
+		}
+
+		try
+		{
+			self->store = new SampleStore(path);
+		}
+		catch (...)
+		{
+			SetPythonError();
+			return -1;
+		}
+
+		return 0;
+	}
+
+	void Dealloc(PyObject * in_self)
+	{
+		auto const type = Py_TYPE(in_self);
+
+		delete reinterpret_cast<SampleStoreObject *>(in_self)->store;
+
+		reinterpret_cast<freefunc>(PyType_GetSlot(type, Py_tp_free))(in_self);
+		Py_DECREF(type);
+	}
+
+	Py_ssize_t Length(PyObject * in_self)
+	{
+		auto const store = CheckedStore(in_self);
+
+		return store ? Py_ssize_t(store->SampleCount()) : -1;
+	}
+
+	PyObject * GetImages(PyObject * in_self, void *)
+	{
+		auto const store = CheckedStore(in_self);
+		if (!store)
+		{
+			return nullptr;
+		}
+
+		auto const & sample_shape = store->SampleShape();
+
+		// Samples are a whole chunk apart, and their elements are contiguous within them
+
+		npy_intp shape[5];
+		npy_intp strides[5];
+
+		shape[0] = npy_intp(store->SampleCount());
+		strides[0] = npy_intp(store->SampleStride());
+
+		auto stride = npy_intp(EncodedElementSize(store->Encoding(), store->ElementType()));
+		for (auto axis = sample_shape.size(); axis > 0; --axis)
+		{
+			shape[axis] = npy_intp(sample_shape[axis - 1]);
+			strides[axis] = stride;
+			stride *= shape[axis];
+		}
+
+		// Encoded samples are viewed as they are stored, quantised or halved
+
+		PyArray_Descr * descr = nullptr;
+		switch (store->Encoding())
+		{
+		case SampleEncoding::UInt8:
+			descr = PyArray_DescrFromType(NPY_UINT8);
+			break;
+		case SampleEncoding::Float16:
+			descr = PyArray_DescrFromType(NPY_FLOAT16);
+			break;
+		case SampleEncoding::Raw:
+		default:
+			descr = NewElementDescr(store->ElementType(), false);
+			break;
+		}
+
+		return NewMappedArray(descr, int(sample_shape.size() + 1), shape, strides, store->Sample(0), in_self);
+	}
+
+	PyObject * GetLabels(PyObject * in_self, void *)
+	{
+		auto const store = CheckedStore(in_self);
+		if (!store)
+		{
+			return nullptr;
+		}
+
+		npy_intp shape[1] = { npy_intp(store->SampleCount()) };
+		npy_intp strides[1] = { npy_intp(sizeof(std::int32_t)) };
+
+		return NewMappedArray(PyArray_DescrFromType(NPY_INT32), 1, shape, strides, reinterpret_cast<std::byte const *>(store->Labels()), in_self);
+	}
+
+	PyObject * GetSampleShape(PyObject * in_self, void *)
+	{
+		auto const store = CheckedStore(in_self);
+		if (!store)
+		{
+			return nullptr;
+		}
+
+		auto const & sample_shape = store->SampleShape();
+
+		PyObject * shape = PyTuple_New(Py_ssize_t(sample_shape.size()));
+
+		for (size_t axis = 0; shape && axis < sample_shape.size(); ++axis)
+		{
+			PyObject * size = PyLong_FromSize_t(sample_shape[axis]);
+			if (!size)
+			{
+				Py_DECREF(shape);
+				return nullptr;
+			}
+
+			// Steals the reference to the size
+			PyTuple_SET_ITEM(shape, Py_ssize_t(axis), size);
+		}
+		return shape;
+	}
+
+	PyObject * GetEncoding(PyObject * in_self, void *)
+	{
+		auto const store = CheckedStore(in_self);
+
+		return store ? PyUnicode_FromString(encoding_names[store->Encoding()]) : nullptr;
+	}
+
+	PyObject * GetScale(PyObject * in_self, void *)
+	{
+		auto const store = CheckedStore(in_self);
+
+		return store ? PyFloat_FromDouble(store->Scale()) : nullptr;
+	}
+
+	PyObject * GetOffset(PyObject * in_self, void *)
+	{
+		auto const store = CheckedStore(in_self);
+
+		return store ? PyFloat_FromDouble(store->Offset()) : nullptr;
+	}
+
+	// Writes the samples of an array into a new store at the path, encoded, returning false with a Python exception set on failure
+	bool WriteSamples(std::string const & in_path, PyObject * in_images, PyObject * in_labels, int in_encoding, Py_ssize_t in_thread_count)
+	{
+		// Encoded samples are float32, while raw ones keep their type
+		PyObject * images_object = in_encoding == SampleEncoding::Raw
+			? PyArray_FROM_OF(in_images, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_NOTSWAPPED)
+			: PyArray_FROM_OTF(in_images, NPY_FLOAT32, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+		if (!images_object)
+		{
+			return false;
+		}
+
+		auto const images = reinterpret_cast<PyArrayObject *>(images_object);
+
+		PyObject * labels_object = PyArray_FROM_OTF(in_labels, NPY_INT32, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+		if (!labels_object)
+		{
+			Py_DECREF(images_object);
+			return false;
+		}
+
+		auto const labels = reinterpret_cast<PyArrayObject *>(labels_object);
+
+		auto const element_type = ArrayElementType(images);
+		if (element_type < 0 || PyArray_NDIM(images) < 1 || PyArray_SIZE(labels) != PyArray_DIM(images, 0))
+		{
+			PyErr_SetString(PyExc_ValueError, "images must be an array of 8, 16 or 32-bit integers or of floats, with one label per image");
+			Py_DECREF(images_object);
+			Py_DECREF(labels_object);
+			return false;
+		}
+
+		auto const sample_count = size_t(PyArray_DIM(images, 0));
+		auto const sample_shape = std::vector<size_t>(PyArray_SHAPE(images) + 1, PyArray_SHAPE(images) + PyArray_NDIM(images));
+		auto const data = static_cast<std::byte const *>(PyArray_DATA(images));
+		auto const length = size_t(PyArray_SIZE(images));
+
+		std::exception_ptr exception;
+
+		Py_BEGIN_ALLOW_THREADS
+		try
+		{
+			// Quantisation spans the range of all elements, which is [0, 1] for normalised images
+			float scale = 1.0f;
+			float offset = 0.0f;
+
+			if (in_encoding == SampleEncoding::UInt8 && length > 0)
+			{
+				auto const elements = reinterpret_cast<float const *>(data);
+				auto const [min_it, max_it] = std::minmax_element(elements, elements + length);
+
+				offset = *min_it;
+				scale = *max_it > *min_it ? (*max_it - *min_it) / 255.0f : 1.0f;
+			}
+
+			// The store is only moved to the path once every sample is in it, so that a failed write leaves none of blank samples behind
+
+			WriteSampleStore(in_path, [&](std::string const & in_store_path)
+			{
+				SampleStore const store{ in_store_path, element_type, sample_shape, sample_count, in_encoding, scale, offset };
+
+				std::copy_n(static_cast<std::int32_t const *>(PyArray_DATA(labels)), sample_count, store.WritableLabels());
+
+				ParallelFor(sample_count, size_t(in_thread_count), [&](size_t in_idx)
+				{
+					store.WriteSample(in_idx, data + in_idx * store.SampleLength() * ElementSize(element_type));
+					store.FlushSample(in_idx);
+				});
+			});
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+		Py_END_ALLOW_THREADS
+
+		Py_DECREF(images_object);
+		Py_DECREF(labels_object);
+
+		if (exception)
+		{
+			try
+			{
+				std::rethrow_exception(exception);
+			}
+			catch (...)
+			{
+				SetPythonError();
+			}
+			return false;
+		}
+
+		return true;
+	}
+
+	PyObject * WriteSampleStoreFunction(PyObject *, PyObject * in_args, PyObject * in_kwargs)
+	{
+		static char const * keywords[] = { "path", "images", "labels", "encoding", "threads", nullptr };
+
+		PyObject * path_bytes = nullptr;
+		PyObject * images_object = nullptr;
+		PyObject * labels_object = nullptr;
+		int encoding = SampleEncoding::Raw;
+		Py_ssize_t thread_count = 0;
+
+		if (!PyArg_ParseTupleAndKeywords(in_args, in_kwargs, "O&OO|O&n", const_cast<char **>(keywords),
+			PyUnicode_FSConverter, &path_bytes, &images_object, &labels_object, ConvertSampleEncoding, &encoding, &thread_count))
+		{
+			return nullptr;
+		}
+
+		std::string const path = PyBytes_AS_STRING(path_bytes);
+		Py_DECREF(path_bytes);
+
+		if (thread_count < 0)
+		{
+			PyErr_SetString(PyExc_ValueError, "threads must not be negative");
+			return nullptr;
+		}
+
+		if (!WriteSamples(path, images_object, labels_object, encoding, thread_count))
+		{
+			return nullptr;
+		}
+
+		return OpenSampleStore(path);
+	}
+
+	PyGetSetDef store_getset[] = {
+		{ "images", GetImages, nullptr, "Read-only view of all samples as stored (uint8 or float16 if encoded), of shape (count,) + sample_shape,\n"
+			"whose pages are only read once accessed", nullptr },
+		{ "labels", GetLabels, nullptr, "Read-only view of the labels of the samples, as int32", nullptr },
+		{ "sample_shape", GetSampleShape, nullptr, "Shape of each sample", nullptr },
+		{ "encoding", GetEncoding, nullptr, "Encoding of the samples: 'raw', 'uint8' or 'float16'", nullptr },
+		{ "scale", GetScale, nullptr, "Step between the values of uint8 samples, which decode to offset + scale * value", nullptr },
+		{ "offset", GetOffset, nullptr, "Value of the uint8 samples that are 0", nullptr },
+		{ nullptr, nullptr, nullptr, nullptr, nullptr }
+	};
+
+	PyType_Slot store_slots[] = {
+		{ Py_tp_doc, const_cast<char *>(
+			"SampleStore(path)\n\n"
+			"Memory-mapped store of labelled samples, each in its own page-aligned chunk, as written by preprocess_volumes or write_sample_store.\n"
+			"Float32 samples may be stored encoded, quantised to 8 bits or halved to float16, and are decoded as a BatchLoader reads them.") },
+		{ Py_tp_new, reinterpret_cast<void *>(PyType_GenericNew) },
+		{ Py_tp_init, reinterpret_cast<void *>(Init) },
+		{ Py_tp_dealloc, reinterpret_cast<void *>(Dealloc) },
+		{ Py_sq_length, reinterpret_cast<void *>(Length) },
+		{ Py_tp_getset, store_getset },
+		{ 0, nullptr }
+	};
+
+	PyMethodDef store_methods[] = {
+		{ "write_sample_store", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(WriteSampleStoreFunction)), METH_VARARGS | METH_KEYWORDS,
+			"write_sample_store(path, images, labels, encoding='raw', threads=0)\n\n"
+			"Writes the images, with one label each, into a new SampleStore at path, which is returned, writing samples in parallel.\n"
+			"encoding is 'raw' to store the images as they are, or, for images converted to float32, 'uint8' to quantise them to 256 steps\n"
+			"spanning their range, or 'float16' to halve them.\n"
+			"threads is the number of threads to use, 0 for the number of hardware threads.\n"
+			"The store is written beside path and only moved there once complete, so a failed write leaves no store at path." },
+		{ nullptr, nullptr, 0, nullptr }
+	};
+
+	PyType_Spec store_spec = {
+		"lndb_native.SampleStore",
+		sizeof(SampleStoreObject),
+		0,
+		Py_TPFLAGS_DEFAULT,
+		store_slots
+	};
+}
+
+bool AddSampleStoreType(PyObject * io_module)
+{
+	store_type = reinterpret_cast<PyTypeObject *>(PyType_FromSpec(&store_spec));
+	if (!store_type)
+	{
+		return false;
+	}
+
+	// Steals a reference to the type on success only
+	Py_INCREF(store_type);
+	if (PyModule_AddObject(io_module, "SampleStore", reinterpret_cast<PyObject *>(store_type)) != 0)
+	{
+		Py_DECREF(store_type);
+		return false;
+	}
+
+	return PyModule_AddFunctions(io_module, store_methods) == 0;
+}
+
+SampleStore const * GetSampleStore(PyObject * in_object)
+{
+	if (!store_type || !PyObject_TypeCheck(in_object, store_type))
+	{
+		PyErr_SetString(PyExc_TypeError, "expected a SampleStore");
+		return nullptr;
+	}
+
+	return CheckedStore(in_object);
+}
+
+int ConvertSampleEncoding(PyObject * in_object, void * out_encoding)
+{
+	for (size_t encoding = 0; encoding < std::size(encoding_names); ++encoding)
+	{
+		int const comparison = PyUnicode_Check(in_object) ? PyUnicode_CompareWithASCIIString(in_object, encoding_names[encoding]) : 1;
+		if (comparison == 0)
+		{
+			*static_cast<int *>(out_encoding) = int(encoding);
+			return 1;
+		}
+	}
+
+	PyErr_SetString(PyExc_ValueError, "encoding must be 'raw', 'uint8' or 'float16'");
+	return 0;
+}
+
+PyObject * OpenSampleStore(std::string const & in_path)
+{
+	return PyObject_CallFunction(reinterpret_cast<PyObject *>(store_type), "s", in_path.c_str());
+}
@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "area_resize.hpp"
+#include "parallel.hpp"
+#include "sample_store.hpp"
+#include "volume_preprocessing.hpp"
+
+namespace
+{
+	// Normalises a slice as NumPy did: integers are shifted in their own type and divided in double, floats stay in single precision
+	template <typename T>
+	void NormaliseSlice(T const * in_slice, size_t in_length, float * out_voxels)
+	{
+		auto const [min_it, max_it] = std::minmax_element(in_slice, in_slice + in_length);
+		auto const min = *min_it;
+		auto const range = *max_it - min;
+
+		if (range == 0)
+		{
+			std::fill(out_voxels, out_voxels + in_length, 0.0f);
+			return;
+		}
+
+		for (size_t idx = 0; idx < in_length; ++idx)
+		{
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				out_voxels[idx] = float((in_slice[idx] - min) / range);
+			}
+			else
+			{
+				out_voxels[idx] = float(double(in_slice[idx] - min) / double(range));
+			}
+		}
+	}
+
+	template <typename T>
+	void PreprocessVolumeTyped(MhdVolume const & in_volume, size_t in_image_size, float * out_voxels)
+	{
+		auto const & dim_size = in_volume.Header().dim_size;
+		auto const slice_size = in_image_size * in_image_size;
+
+		std::vector<T> resized_slice(slice_size);
+
+		// The steps along z are computed in double exactly as in Python, so that the same slices are sampled
+
+		double const z_step = double(dim_size[2]) / double(in_image_size);
+
+		for (size_t z_idx = 0; z_idx < in_image_size; ++z_idx)
+		{
+			double const z = double(z_idx) * z_step;
+			if (z >= double(dim_size[2]))
+			{
+				break;
+			}
+
+			// Only the sampled slices are read from the mapped volume
+
+			auto const slice = in_volume.Slice(size_t(z));
+
+			ResizeArea(reinterpret_cast<T const *>(slice.data), dim_size[0], dim_size[1], size_t(slice.strides[1]) / sizeof(T),
+				resized_slice.data(), in_image_size, in_image_size);
+
+			NormaliseSlice(resized_slice.data(), slice_size, out_voxels + z_idx * slice_size);
+		}
+	}
+}
+
+void PreprocessVolume(MhdVolume const & in_volume, size_t in_image_size, float * out_voxels)
+{
+	if (in_volume.Header().is_big_endian && ElementSize(in_volume.Header().element_type) > 1)
+	{
+		throw std::invalid_argument("big-endian volumes are not supported");
+	}
+
+	switch (in_volume.Header().element_type)
+	{
+	case ElementType::Int8:
+		return PreprocessVolumeTyped<std::int8_t>(in_volume, in_image_size, out_voxels);
+	case ElementType::UInt8:
+		return PreprocessVolumeTyped<std::uint8_t>(in_volume, in_image_size, out_voxels);
+	case ElementType::Int16:
+		return PreprocessVolumeTyped<std::int16_t>(in_volume, in_image_size, out_voxels);
+	case ElementType::UInt16:
+		return PreprocessVolumeTyped<std::uint16_t>(in_volume, in_image_size, out_voxels);
+	case ElementType::Int32:
+		return PreprocessVolumeTyped<std::int32_t>(in_volume, in_image_size, out_voxels);
+	case ElementType::UInt32:
+		return PreprocessVolumeTyped<std::uint32_t>(in_volume, in_image_size, out_voxels);
+	case ElementType::Float32:
+		return PreprocessVolumeTyped<float>(in_volume, in_image_size, out_voxels);
+	case ElementType::Float64:
+	default:
+		return PreprocessVolumeTyped<double>(in_volume, in_image_size, out_voxels);
+	}
+}
+
+void PreprocessVolumes(std::vector<std::string> const & in_paths, std::vector<std::int32_t> const & in_labels, size_t in_image_size,
+	std::string const & in_output_path, int in_encoding, size_t in_thread_count)
+{
+	if (in_labels.size() != in_paths.size())
+	{
+		throw std::invalid_argument("there must be one label for each volume");
+	}
+	if (in_image_size == 0)
+	{
+		throw std::invalid_argument("image size must be positive");
+	}
+
+	// The store is only moved to the output path once every volume is in it, so that a failed run leaves none of blank samples behind
+
+	WriteSampleStore(in_output_path, [&](std::string const & in_path)
+	{
+		// Voxels are normalised to [0, 1], which is what 8-bit quantisation spans
+
+		SampleStore const store{ in_path, ElementType::Float32, { in_image_size, in_image_size, in_image_size, 1 }, in_paths.size(),
+			in_encoding, 1.0f / 255.0f, 0.0f };
+
+		std::copy(in_labels.begin(), in_labels.end(), store.WritableLabels());
+
+		// Each volume is a task of its own, mapped only while it is processed
+
+		ParallelFor(in_paths.size(), in_thread_count, [&](size_t in_idx)
+		{
+			MhdVolume const volume{ in_paths[in_idx] };
+
+			// Raw samples are preprocessed straight into the store, and encoded ones only once whole
+
+			if (store.Encoding() == SampleEncoding::Raw)
+			{
+				PreprocessVolume(volume, in_image_size, reinterpret_cast<float *>(store.WritableSample(in_idx)));
+			}
+			else
+			{
+				std::vector<float> voxels(store.SampleLength());
+
+				PreprocessVolume(volume, in_image_size, voxels.data());
+
+				store.WriteSample(in_idx, voxels.data());
+			}
+
+			store.FlushSample(in_idx);
+		});
+	});
+}
@@ -0,0 +1,23 @@
+#ifndef VOLUME_PREPROCESSING_HEADER
+#define VOLUME_PREPROCESSING_HEADER
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mhd_volume.hpp"
+
+// Preprocesses a volume into image_size^3 voxels, as process_data_3d did with OpenCV and NumPy: slices sampled along z at regular steps
+// (the nearest one below each step), each resized with INTER_AREA and normalised to [0, 1] by its own minimum and maximum
+// Throws std::invalid_argument for big-endian volumes
+void PreprocessVolume(MhdVolume const & in_volume, size_t in_image_size, float * out_voxels);
+
+// Preprocesses the volumes of .mhd files in parallel into a new sample store of float32 samples of shape (image_size, image_size, image_size, 1),
+// with the specified labels and sample encoding, streaming each sample straight into the mapped store and flushing it once done, so memory use
+// is bounded by the thread count rather than by the number of volumes (0 threads for the number of hardware threads)
+// The store is written beside the output path and only moved there once complete, as WriteSampleStore does
+void PreprocessVolumes(std::vector<std::string> const & in_paths, std::vector<std::int32_t> const & in_labels, size_t in_image_size,
+	std::string const & in_output_path, int in_encoding, size_t in_thread_count);
+
+#endif
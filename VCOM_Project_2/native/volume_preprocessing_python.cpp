@@ -0,0 +1,152 @@
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "python_common.hpp"
+#include "volume_preprocessing.hpp"
+
+namespace
+{
+	// Converts a sequence of path-like objects, returning false with a Python exception set on failure
+	bool ConvertPaths(PyObject * in_sequence, std::vector<std::string> & out_paths)
+	{
+		PyObject * sequence = PySequence_Fast(in_sequence, "paths must be a sequence");
+		if (!sequence)
+		{
+			return false;
+		}
+
+		auto const length = PySequence_Fast_GET_SIZE(sequence);
+		out_paths.reserve(size_t(length));
+
+		for (Py_ssize_t idx = 0; idx < length; ++idx)
+		{
+			PyObject * path_bytes = nullptr;
+			if (!PyUnicode_FSConverter(PySequence_Fast_GET_ITEM(sequence, idx), &path_bytes))
+			{
+				Py_DECREF(sequence);
+				return false;
+			}
+
+			out_paths.emplace_back(PyBytes_AS_STRING(path_bytes));
+			Py_DECREF(path_bytes);
+		}
+
+		Py_DECREF(sequence);
+		return true;
+	}
+
+	// Converts a sequence of integers, returning false with a Python exception set on failure
+	bool ConvertLabels(PyObject * in_sequence, std::vector<std::int32_t> & out_labels)
+	{
+		PyObject * sequence = PySequence_Fast(in_sequence, "labels must be a sequence");
+		if (!sequence)
+		{
+			return false;
+		}
+
+		auto const length = PySequence_Fast_GET_SIZE(sequence);
+		out_labels.reserve(size_t(length));
+
+		for (Py_ssize_t idx = 0; idx < length; ++idx)
+		{
+			long const label = PyLong_AsLong(PySequence_Fast_GET_ITEM(sequence, idx));
+			if (label == -1 && PyErr_Occurred())
+			{
+				Py_DECREF(sequence);
+				return false;
+			}
+
+			out_labels.push_back(std::int32_t(label));
+		}
+
+		Py_DECREF(sequence);
+		return true;
+	}
+
+	PyObject * PreprocessVolumesFunction(PyObject *, PyObject * in_args, PyObject * in_kwargs)
+	{
+		static char const * keywords[] = { "paths", "labels", "output_path", "image_size", "threads", "encoding", nullptr };
+
+		PyObject * paths_sequence = nullptr;
+		PyObject * labels_sequence = nullptr;
+		PyObject * output_bytes = nullptr;
+		Py_ssize_t image_size = 0;
+		Py_ssize_t thread_count = 0;
+		int encoding = SampleEncoding::Raw;
+
+		if (!PyArg_ParseTupleAndKeywords(in_args, in_kwargs, "OOO&n|nO&", const_cast<char **>(keywords),
+			&paths_sequence, &labels_sequence, PyUnicode_FSConverter, &output_bytes, &image_size, &thread_count, ConvertSampleEncoding, &encoding))
+		{
+			return nullptr;
+		}
+
+		std::string const output_path = PyBytes_AS_STRING(output_bytes);
+		Py_DECREF(output_bytes);
+
+		if (image_size <= 0)
+		{
+			PyErr_SetString(PyExc_ValueError, "image_size must be positive");
+			return nullptr;
+		}
+		if (thread_count < 0)
+		{
+			PyErr_SetString(PyExc_ValueError, "threads must not be negative");
+			return nullptr;
+		}
+
+		std::vector<std::string> paths;
+		std::vector<std::int32_t> labels;
+
+		if (!ConvertPaths(paths_sequence, paths) || !ConvertLabels(labels_sequence, labels))
+		{
+			return nullptr;
+		}
+
+		// No Python object is touched while the volumes are processed, so the exception is only translated once the GIL is held again
+		std::exception_ptr exception;
+
+		Py_BEGIN_ALLOW_THREADS
+		try
+		{
+			PreprocessVolumes(paths, labels, size_t(image_size), output_path, encoding, size_t(thread_count));
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+		Py_END_ALLOW_THREADS
+
+		if (exception)
+		{
+			try
+			{
+				std::rethrow_exception(exception);
+			}
+			catch (...)
+			{
+				SetPythonError();
+			}
+			return nullptr;
+		}
+
+		return OpenSampleStore(output_path);
+	}
+
+	PyMethodDef preprocessing_methods[] = {
+		{ "preprocess_volumes", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(PreprocessVolumesFunction)), METH_VARARGS | METH_KEYWORDS,
+			"preprocess_volumes(paths, labels, output_path, image_size, threads=0, encoding='raw')\n\n"
+			"Preprocesses the volumes of the .mhd files in parallel into a new SampleStore at output_path, which is returned.\n"
+			"Each volume becomes a float32 sample of shape (image_size, image_size, image_size, 1): image_size slices sampled at regular\n"
+			"steps along z, each resized with INTER_AREA and normalised to [0, 1] by its own minimum and maximum.\n"
+			"Samples are written to disk as they are finished, so memory use does not grow with the number of volumes, and stored as they are\n"
+			"if encoding is 'raw', quantised to 256 steps over [0, 1] if 'uint8', or halved if 'float16'.\n"
+			"threads is the number of threads to use, 0 for the number of hardware threads." },
+		{ nullptr, nullptr, 0, nullptr }
+	};
+}
+
+bool AddPreprocessingFunctions(PyObject * io_module)
+{
+	return PyModule_AddFunctions(io_module, preprocessing_methods) == 0;
+}
@@ -1,5 +1,8 @@
 import numpy as np
 import itertools
+
+import lndb_native
+
 from scripts.utils import readCsv
 from scripts.readNoduleList import joinNodules
 
@@ -192,60 +195,26 @@ def calcFleischner(nodules):
     indlnd = header.index('LNDbID')
     LND = np.asarray([line[indlnd] for line in lines])
     
+    Nd = np.asarray([float(line[header.index('Nodule')]) for line in lines])
     if 'Volume0' in header and 'Text0' in header:
         # if probabilities of volume and texture class are given compute Fleischner class probabilities
-        Nd = np.asarray([float(line[header.index('Nodule')]) for line in lines])
-        Nn = 1-Nd
-        V0 = np.asarray([float(line[header.index('Volume0')]) for line in lines])
-        V1 = np.asarray([float(line[header.index('Volume1')]) for line in lines])
-        V2 = np.asarray([float(line[header.index('Volume2')]) for line in lines])
-        T0 = np.asarray([float(line[header.index('Text0')]) for line in lines])
-        T1 = np.asarray([float(line[header.index('Text1')]) for line in lines])
-        T2 = np.asarray([float(line[header.index('Text2')]) for line in lines])
+        V = np.asarray([[float(line[header.index('Volume{}'.format(c))]) for c in range(3)] for line in lines]).reshape((-1,3))
+        T = np.asarray([[float(line[header.index('Text{}'.format(c))]) for c in range(3)] for line in lines]).reshape((-1,3))
     elif 'Volume' in header and 'Text' in header:
         # if volume and texture are given compute Fleischner class
-        Nd = np.asarray([float(line[header.index('Nodule')]) for line in lines])
-        V = np.asarray([float(line[header.index('Volume')]) for line in lines])
-        T = np.asarray([float(line[header.index('Text')]) for line in lines])
+        V = calcNodVolClass(np.asarray([float(line[header.index('Volume')]) for line in lines]))
+        T = calcNodTexClass(np.asarray([float(line[header.index('Text')]) for line in lines]))
     elif 'VolumeClass' in header and 'TextClass' in header:
         # if volume and texture class are given compute Fleischner class
-        Nd = np.asarray([float(line[header.index('Nodule')]) for line in lines])
-        Vclass = np.asarray([float(line[header.index('VolumeClass')]) for line in lines])
-        Tclass = np.asarray([float(line[header.index('TextClass')]) for line in lines])
+        V = np.asarray([float(line[header.index('VolumeClass')]) for line in lines])
+        T = np.asarray([float(line[header.index('TextClass')]) for line in lines])
+    
+    # Nodules are grouped by CT in a single pass and all CTs are scored in parallel (as calcCTFleischnerScore and calcCTFleischnerProb)
+    LNDU, indCT = np.unique(LND, return_inverse=True)
+    F, P = lndb_native.fleischner_scores(indCT.reshape(-1), len(LNDU), Nd, V, T)
     
-    p0 = 0.0; p1 = 0.0; p2 = 0.0; p3 = 0.0
     fleischner = [['LNDbID','Fleischner','Fleischner0','Fleischner1','Fleischner2','Fleischner3']]
-    for lndU in np.unique(LND):
-        if 'Volume0' in header and 'Text0' in header:
-            # if probabilities of volume and texture class are given compute Fleischner class probabilities
-            nd = Nd[LND==lndU]
-            nn = Nn[LND==lndU]
-            v0 = V0[LND==lndU]
-            v1 = V1[LND==lndU]
-            v2 = V2[LND==lndU]
-            t0 = T0[LND==lndU]
-            t1 = T1[LND==lndU]
-            t2 = T2[LND==lndU]
-            [p0,p1,p2,p3] = calcCTFleischnerProb(nd,nn,v0,v1,v2,t0,t1,t2,verb=False)
-            
-            vclass = np.ndarray.flatten(np.argmax([v0,v1,v2], axis=0))
-            tclass = np.ndarray.flatten(np.argmax([t0,t1,t2], axis=0))
-        elif 'Volume' in header and 'Text' in header:
-            # if volume and texture are given compute Fleischner class
-            nd = Nd[LND==lndU]
-            v = V[LND==lndU]
-            t = T[LND==lndU]
-            vclass = calcNodVolClass(v)
-            tclass = calcNodTexClass(t)
-            
-        elif 'VolumeClass' in header and 'TextClass' in header:
-            # if volume and texture class are given compute Fleischner class
-            nd = Nd[LND==lndU]
-            vclass = Vclass[LND==lndU]
-            tclass = Tclass[LND==lndU]
-            
-        f = calcCTFleischnerScore(nd,vclass,tclass,nodprob=.5)
-        
+    for lndU,f,[p0,p1,p2,p3] in zip(LNDU,F.tolist(),P.tolist()):
         print('LNDb {}'.format(lndU))
         print('Fleischner class: {}'.format(f))
         print('Fleischner class probabilities: {} {} {} {}'.format(p0,p1,p2,p3))
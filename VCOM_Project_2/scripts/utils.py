@@ -1,7 +1,8 @@
 import csv
 import numpy as np
 import SimpleITK as sitk
-from scipy.ndimage import zoom
+
+import lndb_native
 
 def readCsv(csvfname):
     # read csv to list of lists
@@ -25,6 +26,14 @@ def readMhd(filename):
     transfmat = itkimage.GetDirection() #3D rotation matrix
     return scan,spacing,origin,transfmat
 
+def openMhd(filename):
+    # memory-map mhd/raw image, only reading from disk the slices that are accessed (volume.slice(z), volume.subvolume(begin,end), volume.array)
+    volume = lndb_native.MhdVolume(filename) #3D image, same shape as from readMhd
+    spacing = volume.spacing #voxelsize
+    origin = volume.origin #world coordinates of origin
+    transfmat = volume.direction #3D rotation matrix
+    return volume,spacing,origin,transfmat
+
 def writeMhd(filename,scan,spacing,origin,transfmat):
     # write mhd/raw image
     itkim = sitk.GetImageFromArray(scan, isVector=False) #3D image
@@ -57,22 +66,12 @@ def convertToWorldCoord(xyz,origin,transfmat_toworld):
 
 def extractCube(scan,spacing,xyz,cube_size=80,cube_size_mm=51):
     # Extract cube of cube_size^3 voxels and world dimensions of cube_size_mm^3 mm from scan at image coordinates xyz
-    xyz = np.array([xyz[i] for i in [2,1,0]],np.int)
-    spacing = np.array([spacing[i] for i in [2,1,0]])
-    scan_halfcube_size = np.array(cube_size_mm/spacing/2,np.int)
-    if np.any(xyz<scan_halfcube_size) or np.any(xyz+scan_halfcube_size>scan.shape): # check if padding is necessary
-        maxsize = max(scan_halfcube_size)
-        scan = np.pad(scan,((maxsize,maxsize,)),'constant',constant_values=0)
-        xyz = xyz+maxsize
-    
-    scancube = scan[xyz[0]-scan_halfcube_size[0]:xyz[0]+scan_halfcube_size[0], # extract cube from scan at xyz
-                    xyz[1]-scan_halfcube_size[1]:xyz[1]+scan_halfcube_size[1],
-                    xyz[2]-scan_halfcube_size[2]:xyz[2]+scan_halfcube_size[2]]
+    return extractCubes(scan,spacing,[xyz],cube_size,cube_size_mm)[0]
 
-    sh = scancube.shape
-    scancube = zoom(scancube,(cube_size/sh[0],cube_size/sh[1],cube_size/sh[2]),order=2) #resample for cube_size
-    
-    return scancube
+def extractCubes(scan,spacing,xyzs,cube_size=80,cube_size_mm=51,clamp=False):
+    # Extract cubes around each of the image coordinates xyzs in parallel, from a scan array or a volume from openMhd
+    # Voxels outside the scan are zeros (or the nearest ones inside it if clamp), without padding the scan
+    return lndb_native.extract_cubes(scan,xyzs,spacing,cube_size,cube_size_mm,clamp) #resampled for cube_size as scipy.ndimage.zoom(order=2)
 
 if __name__ == "__main__":
     #Extract and display cube for example nodule